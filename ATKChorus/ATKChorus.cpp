@@ -2,19 +2,9 @@
 #include "IPlug_include_in_plug_src.h"
 #include "IControl.h"
 #include "resource.h"
+#include "../common/IPlugParameters.h"
 
-const int kNumPrograms = 3;
-
-enum EParams
-{
-  kDelay = 0,
-  kDepth,
-  kMod,
-  kBlend,
-  kFeedforward,
-  kFeedback,
-  kNumParams
-};
+const int kNumPrograms = 4;
 
 enum ELayout
 {
@@ -37,23 +27,11 @@ enum ELayout
 };
 
 ATKChorus::ATKChorus(IPlugInstanceInfo instanceInfo)
-: IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), inFilter(nullptr, 1, 0, false), outFilter(nullptr, 1, 0, false), delayFilter(50000)
+: IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), tail_length(-1)
 {
   TRACE;
 
-  //arguments are: name, defaultVal, minVal, maxVal, step, label
-  GetParam(kDelay)->InitDouble("Delay", 10, 0.2, 100.0, 0.1, "ms");
-  GetParam(kDelay)->SetShape(2.);
-  GetParam(kDepth)->InitDouble("Depth", 5, 0.1, 99.9, 0.1, "ms");
-  GetParam(kDepth)->SetShape(2.);
-  GetParam(kMod)->InitDouble("Modulation", 2, 0.1, 5.0, 0.1, "Hz");
-  GetParam(kMod)->SetShape(1.);
-  GetParam(kBlend)->InitDouble("Blend", 70, -100, 100, 0.01, "%");
-  GetParam(kBlend)->SetShape(1.);
-  GetParam(kFeedforward)->InitDouble("Feedforward", 100., -100, 100, 0.01, "%");
-  GetParam(kFeedforward)->SetShape(1.);
-  GetParam(kFeedback)->InitDouble("Feedback", 0., -90., 90., 0.01, "%");
-  GetParam(kFeedback)->SetShape(1.);
+  InitParameters(this, parameters, kNumParams);
 
   IGraphics* pGraphics = MakeGraphics(this, kWidth, kHeight);
   pGraphics->AttachBackground(UNIVERSALDELAY_ID, UNIVERSALDELAY_FN);
@@ -67,22 +45,14 @@ ATKChorus::ATKChorus(IPlugInstanceInfo instanceInfo)
   pGraphics->AttachControl(new IKnobMultiControl(this, kBlendX, kBlendY, kBlend, &knob1));
   pGraphics->AttachControl(new IKnobMultiControl(this, kFeedforwardX, kFeedforwardY, kFeedforward, &knob1));
   pGraphics->AttachControl(new IKnobMultiControl(this, kFeedbackX, kFeedbackY, kFeedback, &knob1));
+  // Voices and Spread have no knob on the background, they are set by automation and presets
 
   AttachGraphics(pGraphics);
 
-  MakePreset("Chorus", 10, 5, 2, 0.7, 1, 0);
-  MakePreset("Chorus 2", 10, 5, 2, 0.7, 1, -0.7);
-  MakePreset("Doubling", 10, 5, 2, 0.7, 0.7, 0);
-
-  lowPass.set_input_port(0, &noiseGenerator, 0);
-  offsetFilter.set_input_port(0, &lowPass, 0);
-  delayFilter.set_input_port(0, &inFilter, 0);
-  delayFilter.set_input_port(1, &offsetFilter, 0);
-  outFilter.set_input_port(0, &delayFilter, 0);
-  
-  noiseGenerator.set_offset(0);
-  noiseGenerator.set_volume(1);
-  lowPass.set_cut_frequency(1);
+  MakePreset("Chorus", 10., 5., 2., 70., 100., 0., 1., 100.);
+  MakePreset("Chorus 2", 10., 5., 2., 70., 100., -70., 1., 100.);
+  MakePreset("Doubling", 10., 5., 2., 70., 70., 0., 1., 100.);
+  MakePreset("Ensemble", 15., 5., 1., 70., 100., 0., 6., 100.);
 
   Reset();
 }
@@ -92,74 +62,53 @@ ATKChorus::~ATKChorus() {}
 void ATKChorus::ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames)
 {
   // Mutex is already locked for us.
-  inFilter.set_pointer(inputs[0], nFrames);
-  outFilter.set_pointer(outputs[0], nFrames);
-  outFilter.process(nFrames);
+
+  if (IsInChannelConnected(1))
+  {
+    stereo_dsp.process(inputs, outputs, nFrames);
+    UpdateTailSize(stereo_dsp.get_tail_length());
+  }
+  else
+  {
+    dsp.process(inputs, outputs, nFrames);
+    UpdateTailSize(dsp.get_tail_length());
+  }
 }
 
 void ATKChorus::Reset()
 {
   TRACE;
   IMutexLock lock(this);
-  
-  int sampling_rate = GetSampleRate();
-  
-  if(sampling_rate != inFilter.get_output_sampling_rate())
-  {
-    inFilter.set_input_sampling_rate(sampling_rate);
-    inFilter.set_output_sampling_rate(sampling_rate);
-    noiseGenerator.set_input_sampling_rate(sampling_rate);
-    noiseGenerator.set_output_sampling_rate(sampling_rate);
-    lowPass.set_input_sampling_rate(sampling_rate);
-    lowPass.set_output_sampling_rate(sampling_rate);
-    offsetFilter.set_input_sampling_rate(sampling_rate);
-    delayFilter.set_input_sampling_rate(sampling_rate);
-    delayFilter.set_output_sampling_rate(sampling_rate);
-    outFilter.set_input_sampling_rate(sampling_rate);
-    outFilter.set_output_sampling_rate(sampling_rate);
-  }
-  
-  delayFilter.full_setup();
+
+  dsp.set_sampling_rate(GetSampleRate());
+  stereo_dsp.set_sampling_rate(GetSampleRate());
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKChorus::OnParamChange(int paramIdx)
 {
-  IMutexLock lock(this);
-
+  // Keep the delay larger than the depth, the DSP would apply the same correction
   switch (paramIdx)
   {
   case kDelay:
-    if (GetParam(kDepth)->Value() > GetParam(kDelay)->Value() - 0.1)
-    {
-      GetParam(kDelay)->Set(GetParam(kDepth)->Value() + 0.1);
-      offsetFilter.set_volume(GetParam(kDepth)->Value() / 1000. * GetSampleRate());
-    }
-    offsetFilter.set_offset(GetParam(kDelay)->Value() / 1000. * GetSampleRate());
-    delayFilter.set_central_delay(GetParam(kDelay)->Value() / 1000. * GetSampleRate());
-    break;
   case kDepth:
-    if (GetParam(kDepth)->Value() > GetParam(kDelay)->Value() - 0.1)
-    {
-      GetParam(kDepth)->Set(GetParam(kDelay)->Value() - 0.1);
-      offsetFilter.set_offset(GetParam(kDelay)->Value() / 1000. * GetSampleRate());
-      delayFilter.set_central_delay(GetParam(kDelay)->Value() / 1000. * GetSampleRate());
-    }
-    offsetFilter.set_volume(GetParam(kDepth)->Value() / 1000. * GetSampleRate());
-    break;
-  case kMod:
-    lowPass.set_cut_frequency(GetParam(kMod)->Value());
-    break;
-  case kBlend:
-    delayFilter.set_blend((GetParam(kBlend)->Value()) / 100.);
-    break;
-  case kFeedforward:
-    delayFilter.set_feedforward((GetParam(kFeedforward)->Value()) / 100.);
-    break;
-  case kFeedback:
-    delayFilter.set_feedback((GetParam(kFeedback)->Value()) / 100.);
+    GetParam(paramIdx)->Set(constrained_parameter(paramIdx, GetParam(kDelay)->Value(), GetParam(kDepth)->Value()));
     break;
 
   default:
     break;
   }
+
+  dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+  stereo_dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+}
+
+void ATKChorus::UpdateTailSize(int64_t tail_length)
+{
+  // the host is only told when the tail changes, not after every block
+  if (tail_length != this->tail_length)
+  {
+    this->tail_length = tail_length;
+    SetTailSize(static_cast<int>(tail_length));
+  }
 }
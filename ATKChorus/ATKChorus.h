@@ -3,15 +3,9 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 
-#include <ATK/Core/InPointerFilter.h>
-#include <ATK/Core/OutPointerFilter.h>
-#include <ATK/Delay/UniversalVariableDelayLineFilter.h>
-#include <ATK/EQ/IIRFilter.h>
-#include <ATK/EQ/SecondOrderFilter.h>
-#include <ATK/Tools/OffsetVolumeFilter.h>
-#include <ATK/Tools/WhiteNoiseGeneratorFilter.h>
+#include "ATKChorusDSP.h"
 
-class ATKChorus : public IPlug
+class ATKChorus : public IPlug, public ATKChorusParameters
 {
 public:
   ATKChorus(IPlugInstanceInfo instanceInfo);
@@ -22,12 +16,11 @@ public:
   void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
-  ATK::InPointerFilter<double> inFilter;
-  ATK::WhiteNoiseGeneratorFilter<double> noiseGenerator;
-  ATK::IIRFilter<ATK::LowPassCoefficients<double> > lowPass;
-  ATK::OffsetVolumeFilter<double> offsetFilter;
-  ATK::UniversalVariableDelayLineFilter<double> delayFilter;
-  ATK::OutPointerFilter<double> outFilter;
+  void UpdateTailSize(int64_t tail_length);
+
+  ATKChorusDSP<double> dsp;
+  ATKChorusStereoDSP<double> stereo_dsp;
+  int64_t tail_length;
 };
 
 #endif
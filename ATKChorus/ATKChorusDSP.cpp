@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ATKChorusDSP.h"
+
+namespace
+{
+  // the voices are spread over +/-25% of the delay
+  const double voice_delay_spread = .5;
+  const int max_nb_voices = MultiVoiceChorusFilter<double>::max_nb_voices;
+}
+
+const ParameterInfo ATKChorusParameters::parameters[kNumParams] =
+{
+  {"Delay", 10, 0.2, 100.0, 0.1, "ms", 2., false, NULL},
+  {"Depth", 5, 0.1, 99.9, 0.1, "ms", 2., false, NULL},
+  {"Modulation", 2, 0.1, 5.0, 0.1, "Hz", 1., false, NULL},
+  {"Blend", 70, -100, 100, 0.01, "%", 1., false, NULL},
+  {"Feedforward", 100., -100, 100, 0.01, "%", 1., false, NULL},
+  {"Feedback", 0., -90., 90., 0.01, "%", 1., false, NULL},
+  {"Voices", 1, 1, max_nb_voices, 1, "", 1., false, NULL},
+  {"Spread", 100., 0., 100., 0.01, "%", 1., false, NULL}
+};
+
+double ATKChorusParameters::constrained_parameter(int paramIdx, double delay, double depth)
+{
+  if (paramIdx == kDelay && depth > delay - 0.1)
+  {
+    return depth + 0.1;
+  }
+  if (paramIdx == kDepth && depth > delay - 0.1)
+  {
+    return delay - 0.1;
+  }
+  return paramIdx == kDelay ? delay : depth;
+}
+
+template<typename DataType_, int nb_channels_>
+ATKChorusDSP<DataType_, nb_channels_>::ATKChorusDSP()
+  :nb_voices(max_nb_voices), lfoFilter(max_nb_voices), voicesFilter(nb_channels, 0)
+{
+  for (int channel = 0; channel < nb_channels; ++channel)
+  {
+    inFilters[channel].reset(new ATK::InPointerFilter<DataType>(nullptr, 1, 0, false));
+    outFilters[channel].reset(new ATK::OutPointerFilter<DataType>(nullptr, 1, 0, false));
+    endpoint.add_filter(outFilters[channel].get());
+
+    voicesFilter.set_input_port(channel, inFilters[channel].get(), 0);
+    outFilters[channel]->set_input_port(0, &voicesFilter, channel);
+  }
+  // all the voices stay connected, the Voices parameter only changes how many are computed
+  for (int voice = 0; voice < max_nb_voices; ++voice)
+  {
+    voicesFilter.set_input_port(nb_channels + voice, &lfoFilter, voice);
+  }
+  voicesFilter.set_nb_voices(max_nb_voices);
+  lowPass.set_input_port(0, &noiseGenerator, 0);
+  offsetFilter.set_input_port(0, &lowPass, 0);
+
+  noiseGenerator.set_offset(0);
+  noiseGenerator.set_volume(1);
+  lowPass.set_cut_frequency(1);
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kDelay);
+  ramps.set_ramped(kDepth);
+  ramps.set_ramped(kBlend);
+  ramps.set_ramped(kFeedforward);
+  ramps.set_ramped(kFeedback);
+  ramps.set_ramped(kSpread);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_, int nb_channels_>
+ATKChorusDSP<DataType_, nb_channels_>::~ATKChorusDSP() {}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // silent inputs, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, nb_inputs, nFrames, get_tail_length()))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    for (int channel = 0; channel < nb_channels; ++channel)
+    {
+      inFilters[channel]->set_pointer(inputs[channel] + offset, size);
+      outFilters[channel]->set_pointer(outputs[channel] + offset, size);
+    }
+    endpoint.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::set_sampling_rate(int sampling_rate)
+{
+  ramps.set_sampling_rate(sampling_rate);
+
+  if(sampling_rate != endpoint.get_output_sampling_rate())
+  {
+    for (int channel = 0; channel < nb_channels; ++channel)
+    {
+      inFilters[channel]->set_input_sampling_rate(sampling_rate);
+      inFilters[channel]->set_output_sampling_rate(sampling_rate);
+      outFilters[channel]->set_input_sampling_rate(sampling_rate);
+      outFilters[channel]->set_output_sampling_rate(sampling_rate);
+    }
+    lfoFilter.set_input_sampling_rate(sampling_rate);
+    lfoFilter.set_output_sampling_rate(sampling_rate);
+    noiseGenerator.set_input_sampling_rate(sampling_rate);
+    noiseGenerator.set_output_sampling_rate(sampling_rate);
+    lowPass.set_input_sampling_rate(sampling_rate);
+    lowPass.set_output_sampling_rate(sampling_rate);
+    offsetFilter.set_input_sampling_rate(sampling_rate);
+    voicesFilter.set_input_sampling_rate(sampling_rate);
+    voicesFilter.set_output_sampling_rate(sampling_rate);
+    endpoint.set_input_sampling_rate(sampling_rate);
+    endpoint.set_output_sampling_rate(sampling_rate);
+  }
+
+  // the largest delay spread by the voices, modulated by the largest depth
+  double max_delay = parameters[kDelay].max_value * (1 + voice_delay_spread / 2) + parameters[kDepth].max_value;
+  voicesFilter.set_max_delay(static_cast<int64_t>(std::ceil(max_delay / 1000. * sampling_rate)));
+  lfoFilter.full_setup();
+  voicesFilter.full_setup();
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_, int nb_channels_>
+double ATKChorusDSP<DataType_, nb_channels_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_, int nb_channels_>
+int64_t ATKChorusDSP<DataType_, nb_channels_>::get_tail_length() const
+{
+  // the longest voice, once for each pass through the feedback
+  double delay = (parameter_values[kDelay] * 1.25 + parameter_values[kDepth]) / 1000. * endpoint.get_output_sampling_rate();
+  return static_cast<int64_t>(delay * (1 + SilenceDetector<DataType>::decay_count(parameter_values[kFeedback] / 100.)));
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::set_modulation_period(int period)
+{
+  lfoFilter.set_period(period);
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::set_audio_rate_modulation(bool audio_rate)
+{
+  if (audio_rate)
+  {
+    voicesFilter.set_input_port(nb_channels, &offsetFilter, 0);
+  }
+  else
+  {
+    voicesFilter.set_input_port(nb_channels, &lfoFilter, 0);
+  }
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::set_nb_voices(int nb_voices)
+{
+  if (nb_voices == this->nb_voices)
+  {
+    return;
+  }
+  this->nb_voices = nb_voices;
+
+  lfoFilter.set_nb_active_outputs(nb_voices);
+  voicesFilter.set_nb_voices(nb_voices);
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+  if (paramIdx == kDelay || paramIdx == kDepth)
+  {
+    parameter_values[paramIdx] = constrained_parameter(paramIdx, parameter_values[kDelay], parameter_values[kDepth]);
+  }
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, parameter_values[paramIdx]);
+  }
+  else
+  {
+    apply_parameter(paramIdx, parameter_values[paramIdx]);
+  }
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKChorusDSP<DataType_, nb_channels_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+  case kDelay:
+  case kDepth:
+  {
+    // both ramps move independently, keep the depth below the delay on the way
+    double delay = ramps.get_value(kDelay);
+    double depth = std::min(ramps.get_value(kDepth), delay - 0.1);
+    double sampling_rate = endpoint.get_output_sampling_rate();
+    lfoFilter.set_offset(delay / 1000. * sampling_rate);
+    offsetFilter.set_offset(delay / 1000. * sampling_rate);
+    voicesFilter.set_central_delay(delay / 1000. * sampling_rate);
+    voicesFilter.set_delay_spread(voice_delay_spread * delay / 1000. * sampling_rate);
+    lfoFilter.set_volume(depth / 1000. * sampling_rate);
+    offsetFilter.set_volume(depth / 1000. * sampling_rate);
+    break;
+  }
+  case kMod:
+    lfoFilter.set_cut_frequency(value);
+    lowPass.set_cut_frequency(value);
+    break;
+  case kBlend:
+    voicesFilter.set_blend((value) / 100.);
+    break;
+  case kFeedforward:
+    voicesFilter.set_feedforward((value) / 100.);
+    break;
+  case kFeedback:
+    voicesFilter.set_feedback((value) / 100.);
+    break;
+  case kVoices:
+    set_nb_voices(std::min(std::max(static_cast<int>(value + .5), 1), max_nb_voices));
+    break;
+  case kSpread:
+    voicesFilter.set_spread(value / 100.);
+    break;
+
+  default:
+    break;
+  }
+}
+
+template class ATKChorusDSP<float>;
+template class ATKChorusDSP<double>;
+template class ATKChorusDSP<float, 2>;
+template class ATKChorusDSP<double, 2>;
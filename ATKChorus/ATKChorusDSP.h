@@ -0,0 +1,103 @@
+#ifndef __ATKChorusDSP__
+#define __ATKChorusDSP__
+
+#include <memory>
+
+#include "../common/ControlRateRamps.h"
+#include "../common/ParameterInfo.h"
+#include "../common/ParameterQueue.h"
+#include "../common/SilenceDetector.h"
+#include "MultiVoiceChorusFilter.h"
+#include "RandomLFOFilter.h"
+
+#include <ATK/Core/InPointerFilter.h>
+#include <ATK/Core/OutPointerFilter.h>
+#include <ATK/Core/PipelineGlobalSinkFilter.h>
+#include <ATK/EQ/IIRFilter.h>
+#include <ATK/EQ/SecondOrderFilter.h>
+#include <ATK/Tools/OffsetVolumeFilter.h>
+#include <ATK/Tools/WhiteNoiseGeneratorFilter.h>
+
+struct ATKChorusParameters
+{
+  enum EParams
+  {
+    kDelay = 0,
+    kDepth,
+    kMod,
+    kBlend,
+    kFeedforward,
+    kFeedback,
+    kVoices,
+    kSpread,
+    kNumParams
+  };
+
+  static const ParameterInfo parameters[kNumParams];
+
+  // The delay must stay larger than the depth: returns the value of paramIdx (kDelay or kDepth)
+  // once corrected so that it does not cross the other one
+  static double constrained_parameter(int paramIdx, double delay, double depth);
+};
+
+// GUI-free processing graph of ATKChorus, shared by the plugin and the offline tools
+// All the voices read the same delay line, each with its own random modulation and with their
+// delays spread over +/-25% of the Delay parameter. The delay line is sized in
+// set_sampling_rate() for the longest delay at that rate
+template<typename DataType_, int nb_channels_ = 1>
+class ATKChorusDSP : public ATKChorusParameters
+{
+public:
+  typedef DataType_ DataType;
+  static const int nb_channels = nb_channels_;
+
+  static const int nb_inputs = nb_channels;
+  static const int nb_sidechain_inputs = 0;
+  static const int nb_outputs = nb_channels;
+
+  ATKChorusDSP();
+  ~ATKChorusDSP();
+
+  void set_sampling_rate(int sampling_rate);
+  void set_parameter(int paramIdx, double value);
+  double get_parameter(int paramIdx) const;
+  // Can be called from any thread, the value is applied at the start of the next process call
+  void post_parameter(int paramIdx, double value);
+  // Shape and duration of the ramps following a parameter change
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  // Samples for the output and the state of the graph to fall below the silence threshold once the input stops
+  int64_t get_tail_length() const;
+  // Samples between two values of the random modulation, interpolated in between (32 by default)
+  void set_modulation_period(int period);
+  // The original modulation graph (white noise, low pass and offset filters at the audio rate)
+  // instead of the control rate RandomLFOFilter for the first voice, kept as the reference.
+  // Not while processing
+  void set_audio_rate_modulation(bool audio_rate);
+  void process(DataType** inputs, DataType** outputs, int nFrames);
+
+private:
+  void apply_parameter(int paramIdx, double value);
+  void set_nb_voices(int nb_voices);
+
+  double parameter_values[kNumParams];
+  ParameterQueue<kNumParams> parameter_queue;
+  ControlRateRamps<kNumParams> ramps;
+  SilenceDetector<DataType> silence;
+  int nb_voices;
+
+  std::unique_ptr<ATK::InPointerFilter<DataType> > inFilters[nb_channels];
+  // one modulation per voice
+  RandomLFOFilter<DataType> lfoFilter;
+  ATK::WhiteNoiseGeneratorFilter<DataType> noiseGenerator;
+  ATK::IIRFilter<ATK::LowPassCoefficients<DataType> > lowPass;
+  ATK::OffsetVolumeFilter<DataType> offsetFilter;
+  MultiVoiceChorusFilter<DataType> voicesFilter;
+  std::unique_ptr<ATK::OutPointerFilter<DataType> > outFilters[nb_channels];
+
+  ATK::PipelineGlobalSinkFilter endpoint;
+};
+
+template<typename DataType>
+using ATKChorusStereoDSP = ATKChorusDSP<DataType, 2>;
+
+#endif
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "MultiVoiceChorusFilter.h"
+
+namespace
+{
+  const double pi = 3.14159265358979323846;
+}
+
+template<typename DataType_>
+MultiVoiceChorusFilter<DataType_>::MultiVoiceChorusFilter(int nb_channels, int64_t max_delay)
+  :Parent(nb_channels + max_nb_voices, nb_channels), nb_channels(nb_channels), nb_voices(1), spread(1), delay_spread(0), central_delay(1),
+  blend(0), feedback(0), feedforward(1)
+{
+  if (nb_channels < 1 || nb_channels > 2)
+  {
+    throw std::runtime_error("MultiVoiceChorusFilter processes one or two channels");
+  }
+  set_max_delay(max_delay);
+  update_voices();
+}
+
+template<typename DataType_>
+MultiVoiceChorusFilter<DataType_>::~MultiVoiceChorusFilter() {}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::set_max_delay(int64_t max_delay)
+{
+  buffer.set_max_delay(std::max<int64_t>(max_delay, 1));
+  central_delay = std::min(central_delay, buffer.get_max_delay());
+}
+
+template<typename DataType_>
+int64_t MultiVoiceChorusFilter<DataType_>::get_max_delay() const
+{
+  return buffer.get_max_delay();
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::set_nb_voices(int nb_voices)
+{
+  if (nb_voices < 1 || nb_voices > max_nb_voices)
+  {
+    throw std::runtime_error("Wrong number of chorus voices");
+  }
+  this->nb_voices = nb_voices;
+  update_voices();
+}
+
+template<typename DataType_>
+int MultiVoiceChorusFilter<DataType_>::get_nb_voices() const
+{
+  return nb_voices;
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::set_spread(double spread)
+{
+  this->spread = spread;
+  update_voices();
+}
+
+template<typename DataType_>
+double MultiVoiceChorusFilter<DataType_>::get_spread() const
+{
+  return spread;
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::set_delay_spread(double delay_spread)
+{
+  this->delay_spread = delay_spread;
+  update_voices();
+}
+
+template<typename DataType_>
+double MultiVoiceChorusFilter<DataType_>::get_delay_spread() const
+{
+  return delay_spread;
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::set_central_delay(int64_t central_delay)
+{
+  this->central_delay = std::max<int64_t>(1, std::min(central_delay, buffer.get_max_delay()));
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::set_blend(DataType blend)
+{
+  this->blend = blend;
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::set_feedback(DataType feedback)
+{
+  this->feedback = feedback;
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::set_feedforward(DataType feedforward)
+{
+  this->feedforward = feedforward;
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::full_setup()
+{
+  Parent::full_setup();
+  buffer.clear();
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::update_voices()
+{
+  double scale = 1 / std::sqrt(static_cast<double>(nb_voices));
+  for (int voice = 0; voice < nb_voices; ++voice)
+  {
+    // -1 for the first voice, 1 for the last one
+    double position = nb_voices == 1 ? 0 : 2. * voice / (nb_voices - 1) - 1;
+    delay_offsets[voice] = static_cast<DataType>(delay_spread * position / 2);
+    if (nb_channels == 1)
+    {
+      gains[0][voice] = static_cast<DataType>(scale);
+    }
+    else
+    {
+      // constant power pan law, a centered voice has a gain of 1 on both sides
+      double angle = (spread * position + 1) * pi / 4;
+      gains[0][voice] = static_cast<DataType>(std::sqrt(2.) * std::cos(angle) * scale);
+      gains[1][voice] = static_cast<DataType>(std::sqrt(2.) * std::sin(angle) * scale);
+    }
+  }
+}
+
+template<typename DataType_>
+void MultiVoiceChorusFilter<DataType_>::process_impl(int64_t size) const
+{
+  switch (nb_voices)
+  {
+  case 1:
+    process_voices<1>(size);
+    break;
+  case 2:
+    process_voices<2>(size);
+    break;
+  case 3:
+    process_voices<3>(size);
+    break;
+  case 4:
+    process_voices<4>(size);
+    break;
+  case 5:
+    process_voices<5>(size);
+    break;
+  case 6:
+    process_voices<6>(size);
+    break;
+  case 7:
+    process_voices<7>(size);
+    break;
+  default:
+    process_voices<8>(size);
+    break;
+  }
+}
+
+template<typename DataType_>
+template<int nb_voices_>
+void MultiVoiceChorusFilter<DataType_>::process_voices(int64_t size) const
+{
+  const DataType* delays[nb_voices_];
+  for (int voice = 0; voice < nb_voices_; ++voice)
+  {
+    delays[voice] = converted_inputs[nb_channels + voice];
+  }
+  const DataType max_delay = static_cast<DataType>(buffer.get_max_delay());
+  const DataType channel_scale = static_cast<DataType>(1. / nb_channels);
+
+  for (int64_t i = 0; i < size; ++i)
+  {
+    DataType delayed = buffer.read(central_delay);
+
+    DataType taps[nb_voices_];
+    for (int voice = 0; voice < nb_voices_; ++voice)
+    {
+      DataType delay = std::min(std::max(delays[voice][i] + delay_offsets[voice], static_cast<DataType>(1)), max_delay);
+      int64_t integer_delay = static_cast<int64_t>(delay);
+      DataType fractional_delay = delay - integer_delay;
+      DataType first = buffer.read(integer_delay);
+      DataType second = buffer.read(integer_delay + 1);
+      taps[voice] = first + fractional_delay * (second - first);
+    }
+
+    DataType mean = 0;
+    for (int channel = 0; channel < nb_channels; ++channel)
+    {
+      DataType processed = converted_inputs[channel][i] + feedback * delayed;
+      DataType voices = 0;
+      for (int voice = 0; voice < nb_voices_; ++voice)
+      {
+        voices += gains[channel][voice] * taps[voice];
+      }
+      outputs[channel][i] = blend * processed + feedforward * voices;
+      mean += processed;
+    }
+    buffer.write(mean * channel_scale);
+  }
+}
+
+template class MultiVoiceChorusFilter<float>;
+template class MultiVoiceChorusFilter<double>;
@@ -0,0 +1,81 @@
+#ifndef __MultiVoiceChorusFilter__
+#define __MultiVoiceChorusFilter__
+
+#include <cstdint>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+#include "../common/DelayRingBuffer.h"
+
+// Several voices of a universal delay line (UniversalVariableDelayLineFilter) reading the same
+// delay line, for one or two channels
+// Inputs: the nb_channels signals, then the delay of each of the max_nb_voices voices in samples,
+// only the first get_nb_voices() ones are read
+// The delay line holds the mean of the channels plus the feedback taken at the central delay.
+// Each output is blend * (input + feedback) + feedforward * the voices, panned by the spread and
+// scaled so that uncorrelated voices keep the power of a single one
+// All the voices are computed by the same loops, one lane per voice, their count being a template
+// parameter so that the compiler unrolls and vectorizes the read positions and the interpolations
+template<typename DataType_>
+class MultiVoiceChorusFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+
+public:
+  static const int max_nb_voices = 8;
+
+  MultiVoiceChorusFilter(int nb_channels, int64_t max_delay);
+  ~MultiVoiceChorusFilter();
+
+  // Longest delay of a voice or of the feedback. Allocates, not while processing
+  void set_max_delay(int64_t max_delay);
+  int64_t get_max_delay() const;
+
+  // Number of voices read, the delay inputs of all the voices stay connected. Does not allocate
+  void set_nb_voices(int nb_voices);
+  int get_nb_voices() const;
+  // Width of the stereo image, from 0 (all the voices in the center) to 1 (the first voice on
+  // the left, the last one on the right)
+  void set_spread(double spread);
+  double get_spread() const;
+  // The voices read at their delay input plus an offset from -delay_spread / 2 for the first
+  // one to delay_spread / 2 for the last one, so that they do not all sit at the same delay
+  void set_delay_spread(double delay_spread);
+  double get_delay_spread() const;
+
+  void set_central_delay(int64_t central_delay);
+  void set_blend(DataType blend);
+  void set_feedback(DataType feedback);
+  void set_feedforward(DataType feedforward);
+
+  void full_setup();
+
+protected:
+  void process_impl(int64_t size) const;
+
+private:
+  template<int nb_voices_>
+  void process_voices(int64_t size) const;
+  void update_voices();
+
+  int nb_channels;
+  int nb_voices;
+  double spread;
+  double delay_spread;
+  int64_t central_delay;
+  DataType blend;
+  DataType feedback;
+  DataType feedforward;
+
+  // for each channel (at most 2), the gain of each voice
+  DataType gains[2][max_nb_voices];
+  DataType delay_offsets[max_nb_voices];
+
+  mutable DelayRingBuffer<DataType> buffer;
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+
+#include "RandomLFOFilter.h"
+
+namespace
+{
+  const double pi = 3.14159265358979323846;
+}
+
+template<typename DataType_>
+RandomLFOFilter<DataType_>::RandomLFOFilter(int nb_channels)
+  :Parent(0, nb_channels), period(32), nb_active_outputs(nb_channels), cut_frequency(1), offset(0), volume(1), b0(0), a1(0), a2(0),
+  last_noises(2 * nb_channels), last_values(2 * nb_channels), distribution(-1, 1),
+  values(nb_channels), increments(nb_channels), remaining(0)
+{
+}
+
+template<typename DataType_>
+RandomLFOFilter<DataType_>::~RandomLFOFilter() {}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::set_period(int period)
+{
+  this->period = std::max(period, 1);
+  setup();
+}
+
+template<typename DataType_>
+int RandomLFOFilter<DataType_>::get_period() const
+{
+  return period;
+}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::set_cut_frequency(double cut_frequency)
+{
+  this->cut_frequency = cut_frequency;
+  setup();
+}
+
+template<typename DataType_>
+double RandomLFOFilter<DataType_>::get_cut_frequency() const
+{
+  return cut_frequency;
+}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::set_offset(double offset)
+{
+  this->offset = static_cast<DataType>(offset);
+}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::set_volume(double volume)
+{
+  this->volume = static_cast<DataType>(volume);
+}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::set_nb_active_outputs(int nb_active_outputs)
+{
+  nb_active_outputs = std::min(std::max(nb_active_outputs, 1), static_cast<int>(values.size()));
+  // the outputs computed again stay at their last value until the end of the current segment
+  for (int channel = this->nb_active_outputs; channel < nb_active_outputs; ++channel)
+  {
+    increments[channel] = 0;
+    last_values[2 * channel] = values[channel];
+  }
+  this->nb_active_outputs = nb_active_outputs;
+}
+
+template<typename DataType_>
+int RandomLFOFilter<DataType_>::get_nb_active_outputs() const
+{
+  return nb_active_outputs;
+}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::full_setup()
+{
+  Parent::full_setup();
+  std::fill(last_noises.begin(), last_noises.end(), 0);
+  std::fill(last_values.begin(), last_values.end(), 0);
+  std::fill(values.begin(), values.end(), 0);
+  std::fill(increments.begin(), increments.end(), 0);
+  remaining = 0;
+}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::setup()
+{
+  Parent::setup();
+  int sampling_rate = this->get_output_sampling_rate();
+  if (sampling_rate == 0)
+  {
+    return;
+  }
+  // bilinear transform at the control rate
+  double w = std::tan(pi * cut_frequency * period / sampling_rate);
+  double norm = 1 / (1 + std::sqrt(2.) * w + w * w);
+  b0 = w * w * norm;
+  a1 = 2 * (w * w - 1) * norm;
+  a2 = (1 - std::sqrt(2.) * w + w * w) * norm;
+}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::next_values() const
+{
+  for (int channel = 0; channel < nb_active_outputs; ++channel)
+  {
+    double* noises = &last_noises[2 * channel];
+    double* filtered_values = &last_values[2 * channel];
+    double noise = distribution(generator) / std::sqrt(static_cast<double>(period));
+    double filtered = b0 * (noise + 2 * noises[0] + noises[1]) - a1 * filtered_values[0] - a2 * filtered_values[1];
+    noises[1] = noises[0];
+    noises[0] = noise;
+    filtered_values[1] = filtered_values[0];
+    filtered_values[0] = filtered;
+
+    increments[channel] = (filtered - values[channel]) / period;
+  }
+  remaining = period;
+}
+
+template<typename DataType_>
+void RandomLFOFilter<DataType_>::process_impl(int64_t size) const
+{
+  for (int64_t i = 0; i < size; )
+  {
+    if (remaining == 0)
+    {
+      next_values();
+    }
+    int64_t chunk = std::min<int64_t>(remaining, size - i);
+    remaining -= static_cast<int>(chunk);
+    for (int channel = 0; channel < nb_active_outputs; ++channel)
+    {
+      DataType* output = outputs[channel] + i;
+      // from the start of the chunk, so that the samples do not depend on each other
+      DataType start = static_cast<DataType>(values[channel]);
+      DataType step = static_cast<DataType>(increments[channel]);
+      for (int64_t j = 0; j < chunk; ++j)
+      {
+        output[j] = offset + volume * (start + (j + 1) * step);
+      }
+      // the end of a segment is the control value itself, the increments do not accumulate
+      values[channel] = remaining == 0 ? last_values[2 * channel] : values[channel] + chunk * increments[channel];
+    }
+    i += chunk;
+  }
+}
+
+template class RandomLFOFilter<float>;
+template class RandomLFOFilter<double>;
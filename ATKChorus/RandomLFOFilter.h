@@ -0,0 +1,73 @@
+#ifndef __RandomLFOFilter__
+#define __RandomLFOFilter__
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+// Random modulation, offset + volume * low passed white noise, like a WhiteNoiseGeneratorFilter
+// followed by a second order low pass and an OffsetVolumeFilter, but with the noise and the low
+// pass computed once every period samples and linearly interpolated in between
+// The noise is scaled by 1 / sqrt(period) so that its density, and the variance of the low
+// passed noise, stay the same as at the audio rate
+// Each output is an independent modulation, all of them share the parameters and the period
+template<typename DataType_>
+class RandomLFOFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::outputs;
+
+public:
+  RandomLFOFilter(int nb_channels = 1);
+  ~RandomLFOFilter();
+
+  // Samples between two values of the low passed noise
+  void set_period(int period);
+  int get_period() const;
+  // Cut frequency of the low pass, must stay well below the control rate
+  void set_cut_frequency(double cut_frequency);
+  double get_cut_frequency() const;
+  void set_offset(double offset);
+  void set_volume(double volume);
+  // Number of outputs computed, from the first one. The others keep their state and hold their
+  // last value when they are computed again. Does not allocate
+  void set_nb_active_outputs(int nb_active_outputs);
+  int get_nb_active_outputs() const;
+
+  void full_setup();
+
+protected:
+  void setup();
+  void process_impl(int64_t size) const;
+
+private:
+  // Starts the interpolation towards the next control values
+  void next_values() const;
+
+  int period;
+  int nb_active_outputs;
+  double cut_frequency;
+  DataType offset;
+  DataType volume;
+
+  // second order Butterworth low pass at the control rate, numerator b0 (1 + 2 z^-1 + z^-2)
+  double b0;
+  double a1;
+  double a2;
+  // two per output
+  mutable std::vector<double> last_noises;
+  mutable std::vector<double> last_values;
+  mutable std::mt19937 generator;
+  mutable std::uniform_real_distribution<double> distribution;
+
+  // one per output
+  mutable std::vector<double> values;
+  mutable std::vector<double> increments;
+  mutable int remaining;
+};
+
+#endif
@@ -1,28 +1,12 @@
-#include <cmath>
-
 #include "ATKColoredCompressor.h"
 #include "IPlug_include_in_plug_src.h"
 #include "IControl.h"
 #include "controls.h"
 #include "resource.h"
+#include "../common/IPlugParameters.h"
 
 const int kNumPrograms = 2;
 
-enum EParams
-{
-  kPower = 0,
-  kAttack,
-  kRelease,
-  kThreshold,
-  kSlope,
-  kSoftness,
-  kColored,
-  kQuality,
-  kMakeup,
-  kDryWet,
-  kNumParams
-};
-
 enum ELayout
 {
   kWidth = GUI_WIDTH,
@@ -54,27 +38,11 @@ enum ELayout
 };
 
 ATKColoredCompressor::ATKColoredCompressor(IPlugInstanceInfo instanceInfo)
-  :	IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo),
-inFilter(nullptr, 1, 0, false), outFilter(nullptr, 1, 0, false), gainCompressorFilter(1, 256*1024)
+  :	IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), tail_length(-1)
 {
   TRACE;
   
-  //arguments are: name, defaultVal, minVal, maxVal, step, label
-  GetParam(kPower)->InitDouble("Power", 10., 0., 100.0, 0.1, "ms");
-  GetParam(kPower)->SetShape(2.);
-  GetParam(kAttack)->InitDouble("Attack", 10., 1., 100.0, 0.1, "ms");
-  GetParam(kAttack)->SetShape(2.);
-  GetParam(kRelease)->InitDouble("Release", 10, 1., 100.0, 0.1, "ms");
-  GetParam(kRelease)->SetShape(2.);
-  GetParam(kThreshold)->InitDouble("Threshold", 0., -40., 0.0, 0.1, "dB"); // threshold is actually power
-  GetParam(kSlope)->InitDouble("Slope", 2., 1.5, 100, .1, "-");
-  GetParam(kSlope)->SetShape(2.);
-  GetParam(kColored)->InitDouble("Color", 0, -.5, .5, 0.01, "-");
-  GetParam(kQuality)->InitDouble("Quality", 0.1, 0.01, .2, 0.01, "-");
-  GetParam(kSoftness)->InitDouble("Softness", -2, -4, 0, 0.1, "-");
-  GetParam(kSoftness)->SetShape(2.);
-  GetParam(kMakeup)->InitDouble("Makeup Gain", 0, 0, 40, 0.1, "dB"); // Makeup is expressed in amplitude
-  GetParam(kDryWet)->InitDouble("Dry/Wet", 1, 0, 1, 0.01, "-");
+  InitParameters(this, parameters, kNumParams);
   
   IGraphics* pGraphics = MakeGraphics(this, kWidth, kHeight);
   pGraphics->AttachBackground(COLORED_COMPRESSOR_ID, COLORED_COMPRESSOR_FN);
@@ -100,17 +68,7 @@ inFilter(nullptr, 1, 0, false), outFilter(nullptr, 1, 0, false), gainCompressorF
   //MakePreset("preset 1", ... );
   MakePreset("Serial Compression", 10., 10., 10., 0., 2., .1, 0., .01, 0., 1.);
   MakePreset("Parallel Compression", 10., 10., 10., 0., 2., .1, 0., .01, 0., 0.5);
-  
-  powerFilter.set_input_port(0, &inFilter, 0);
-  attackReleaseFilter.set_input_port(0, &powerFilter, 0);
-  gainCompressorFilter.set_input_port(0, &attackReleaseFilter, 0);
-  applyGainFilter.set_input_port(0, &gainCompressorFilter, 0);
-  applyGainFilter.set_input_port(1, &inFilter, 0);
-  volumeFilter.set_input_port(0, &applyGainFilter, 0);
-  drywetFilter.set_input_port(0, &volumeFilter, 0);
-  drywetFilter.set_input_port(1, &inFilter, 0);
-  outFilter.set_input_port(0, &drywetFilter, 0);
-  
+
   Reset();
 }
 
@@ -118,102 +76,32 @@ ATKColoredCompressor::~ATKColoredCompressor() {}
 
 void ATKColoredCompressor::ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames)
 {
-  inFilter.set_pointer(inputs[0], nFrames);
-  outFilter.set_pointer(outputs[0], nFrames);
-  outFilter.process(nFrames);
+  // Mutex is already locked for us.
+
+  dsp.process(inputs, outputs, nFrames);
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKColoredCompressor::Reset()
 {
   TRACE;
   IMutexLock lock(this);
-  
-  int sampling_rate = GetSampleRate();
-  
-  if(sampling_rate != outFilter.get_output_sampling_rate())
-  {
-    inFilter.set_input_sampling_rate(sampling_rate);
-    inFilter.set_output_sampling_rate(sampling_rate);
-    powerFilter.set_input_sampling_rate(sampling_rate);
-    powerFilter.set_output_sampling_rate(sampling_rate);
-    attackReleaseFilter.set_input_sampling_rate(sampling_rate);
-    attackReleaseFilter.set_output_sampling_rate(sampling_rate);
-    gainCompressorFilter.set_input_sampling_rate(sampling_rate);
-    gainCompressorFilter.set_output_sampling_rate(sampling_rate);
-    applyGainFilter.set_input_sampling_rate(sampling_rate);
-    applyGainFilter.set_output_sampling_rate(sampling_rate);
-    volumeFilter.set_input_sampling_rate(sampling_rate);
-    volumeFilter.set_output_sampling_rate(sampling_rate);
-    drywetFilter.set_input_sampling_rate(sampling_rate);
-    drywetFilter.set_output_sampling_rate(sampling_rate);
-    outFilter.set_input_sampling_rate(sampling_rate);
-    outFilter.set_output_sampling_rate(sampling_rate);
-    
-    auto power = GetParam(kPower)->Value();
-    if (power == 0)
-    {
-      powerFilter.set_memory(0);
-    }
-    else
-    {
-      powerFilter.set_memory(std::exp(-1e3 / (power * sampling_rate)));
-    }
-    attackReleaseFilter.set_release(std::exp(-1e3/(GetParam(kRelease)->Value() * sampling_rate))); // in ms
-    attackReleaseFilter.set_attack(std::exp(-1e3/(GetParam(kAttack)->Value() * sampling_rate))); // in ms
-  }
-  
-  powerFilter.full_setup();
-  attackReleaseFilter.full_setup();
+
+  dsp.set_sampling_rate(GetSampleRate());
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKColoredCompressor::OnParamChange(int paramIdx)
 {
-  IMutexLock lock(this);
-  
-  switch (paramIdx)
+  dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+}
+
+void ATKColoredCompressor::UpdateTailSize(int64_t tail_length)
+{
+  // the host is only told when the tail changes, not after every block
+  if (tail_length != this->tail_length)
   {
-    case kPower:
-    {
-      auto power = GetParam(kPower)->Value();
-      if (power == 0)
-      {
-        powerFilter.set_memory(0);
-      }
-      else
-      {
-        powerFilter.set_memory(std::exp(-1e3 / (power * GetSampleRate())));
-      }
-      break;
-    }
-    case kThreshold:
-      gainCompressorFilter.set_threshold(std::pow(10, GetParam(kThreshold)->Value() / 10));
-      break;
-    case kSlope:
-      gainCompressorFilter.set_ratio(GetParam(kSlope)->Value());
-      break;
-    case kSoftness:
-      gainCompressorFilter.set_softness(std::pow(10, GetParam(kSoftness)->Value()));
-      break;
-    case kColored:
-      gainCompressorFilter.set_color(GetParam(kColored)->Value());
-      break;
-    case kQuality:
-      gainCompressorFilter.set_quality(GetParam(kQuality)->Value());
-      break;
-    case kAttack:
-      attackReleaseFilter.set_attack(std::exp(-1e3/(GetParam(kAttack)->Value() * GetSampleRate()))); // in ms
-      break;
-    case kRelease:
-      attackReleaseFilter.set_release(std::exp(-1e3/(GetParam(kRelease)->Value() * GetSampleRate()))); // in ms
-      break;
-    case kMakeup:
-      volumeFilter.set_volume_db(GetParam(kMakeup)->Value());
-      break;
-    case kDryWet:
-      drywetFilter.set_dry(GetParam(kDryWet)->Value());
-      break;
-      
-    default:
-      break;
+    this->tail_length = tail_length;
+    SetTailSize(static_cast<int>(tail_length));
   }
 }
@@ -0,0 +1,221 @@
+#include <cmath>
+
+#include "ATKColoredExpanderDSP.h"
+
+const ParameterInfo ATKColoredExpanderParameters::parameters[kNumParams] =
+{
+  {"Power", 10., 0., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Attack", 10., 1., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Release", 10, 1., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Threshold", 0., -40., 0.0, 0.1, "dB", 1., false, NULL}, // threshold is actually power
+  {"Slope", 2., 1.5, 100, .1, "-", 2., false, NULL},
+  {"Softness", -2, -4, 0, 0.1, "-", 2., false, NULL},
+  {"Color", 0, -.5, .5, 0.01, "-", 1., false, NULL},
+  {"Quality", 0.1, 0.01, .2, 0.01, "-", 1., false, NULL},
+  {"Max reduction", -60, -60, 0, 0.1, "dB", 1., false, NULL},
+  {"Makeup Gain", 0, 0, 40, 0.1, "dB", 1., false, NULL}, // Makeup is expressed in amplitude
+  {"Dry/Wet", 1, 0, 1, 0.01, "-", 1., false, NULL}
+};
+
+template<typename DataType_>
+ATKColoredExpanderDSP<DataType_>::ATKColoredExpanderDSP()
+  :inFilter(nullptr, 1, 0, false), gainExpanderFilter(1, 256*1024), outFilter(nullptr, 1, 0, false)
+{
+  powerFilter.set_input_port(0, &inFilter, 0);
+  attackReleaseFilter.set_input_port(0, &powerFilter, 0);
+  gainExpanderFilter.set_input_port(0, &attackReleaseFilter, 0);
+  applyGainFilter.set_input_port(0, &gainExpanderFilter, 0);
+  applyGainFilter.set_input_port(1, &inFilter, 0);
+  volumeFilter.set_input_port(0, &applyGainFilter, 0);
+  drywetFilter.set_input_port(0, &volumeFilter, 0);
+  drywetFilter.set_input_port(1, &inFilter, 0);
+  outFilter.set_input_port(0, &drywetFilter, 0);
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kThreshold);
+  ramps.set_ramped(kSlope);
+  ramps.set_ramped(kSoftness);
+  ramps.set_ramped(kColored);
+  ramps.set_ramped(kQuality);
+  ramps.set_ramped(kMaxReduction);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_>
+ATKColoredExpanderDSP<DataType_>::~ATKColoredExpanderDSP() {}
+
+template<typename DataType_>
+void ATKColoredExpanderDSP<DataType_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // inputs silent even after the makeup gain, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, nb_inputs, nFrames, get_tail_length(), std::pow(10., parameter_values[kMakeup] / 20)))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    inFilter.set_pointer(inputs[0] + offset, size);
+    outFilter.set_pointer(outputs[0] + offset, size);
+    outFilter.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_>
+void ATKColoredExpanderDSP<DataType_>::set_sampling_rate(int sampling_rate)
+{
+  ramps.set_sampling_rate(sampling_rate);
+
+  if(sampling_rate != outFilter.get_output_sampling_rate())
+  {
+    inFilter.set_input_sampling_rate(sampling_rate);
+    inFilter.set_output_sampling_rate(sampling_rate);
+    powerFilter.set_input_sampling_rate(sampling_rate);
+    powerFilter.set_output_sampling_rate(sampling_rate);
+    attackReleaseFilter.set_input_sampling_rate(sampling_rate);
+    attackReleaseFilter.set_output_sampling_rate(sampling_rate);
+    gainExpanderFilter.set_input_sampling_rate(sampling_rate);
+    gainExpanderFilter.set_output_sampling_rate(sampling_rate);
+    applyGainFilter.set_input_sampling_rate(sampling_rate);
+    applyGainFilter.set_output_sampling_rate(sampling_rate);
+    volumeFilter.set_input_sampling_rate(sampling_rate);
+    volumeFilter.set_output_sampling_rate(sampling_rate);
+    drywetFilter.set_input_sampling_rate(sampling_rate);
+    drywetFilter.set_output_sampling_rate(sampling_rate);
+    outFilter.set_input_sampling_rate(sampling_rate);
+    outFilter.set_output_sampling_rate(sampling_rate);
+
+    auto power = parameter_values[kPower];
+    if (power == 0)
+    {
+      powerFilter.set_memory(0);
+    }
+    else
+    {
+      powerFilter.set_memory(std::exp(-1e3 / (power * sampling_rate)));
+    }
+    attackReleaseFilter.set_release(std::exp(-1e3/(parameter_values[kRelease] * sampling_rate))); // in ms
+    attackReleaseFilter.set_attack(std::exp(-1e3/(parameter_values[kAttack] * sampling_rate))); // in ms
+  }
+
+  powerFilter.full_setup();
+  attackReleaseFilter.full_setup();
+  volumeFilter.full_setup();
+  drywetFilter.full_setup();
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_>
+double ATKColoredExpanderDSP<DataType_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_>
+void ATKColoredExpanderDSP<DataType_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_>
+void ATKColoredExpanderDSP<DataType_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+  volumeFilter.set_smoothing(mode, time_ms);
+  drywetFilter.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_>
+int64_t ATKColoredExpanderDSP<DataType_>::get_tail_length() const
+{
+  // the power, attack and release filters decay one after the other
+  double time_constant = (parameter_values[kPower] + parameter_values[kAttack] + parameter_values[kRelease]) / 1000.;
+  return static_cast<int64_t>(SilenceDetector<DataType>::decay_time(time_constant) * outFilter.get_output_sampling_rate());
+}
+
+template<typename DataType_>
+void ATKColoredExpanderDSP<DataType_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, value);
+  }
+  else
+  {
+    apply_parameter(paramIdx, value);
+  }
+}
+
+template<typename DataType_>
+void ATKColoredExpanderDSP<DataType_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+    case kPower:
+    {
+      auto power = value;
+      if (power == 0)
+      {
+        powerFilter.set_memory(0);
+      }
+      else
+      {
+        powerFilter.set_memory(std::exp(-1e3 / (power * outFilter.get_output_sampling_rate())));
+      }
+      break;
+    }
+    case kThreshold:
+      gainExpanderFilter.set_threshold(std::pow(10, value / 10));
+      break;
+    case kSlope:
+      gainExpanderFilter.set_ratio(value);
+      break;
+    case kSoftness:
+      gainExpanderFilter.set_softness(std::pow(10, value));
+      break;
+    case kColored:
+      gainExpanderFilter.set_color(value);
+      break;
+    case kQuality:
+      gainExpanderFilter.set_quality(value);
+      break;
+    case kAttack:
+      attackReleaseFilter.set_attack(std::exp(-1e3/(value * outFilter.get_output_sampling_rate()))); // in ms
+      break;
+    case kRelease:
+      attackReleaseFilter.set_release(std::exp(-1e3/(value * outFilter.get_output_sampling_rate()))); // in ms
+      break;
+    case kMaxReduction:
+      gainExpanderFilter.set_max_reduction_db(value);
+      break;
+    case kMakeup:
+      volumeFilter.set_volume_db(value);
+      break;
+    case kDryWet:
+      drywetFilter.set_dry(value);
+      break;
+
+    default:
+      break;
+  }
+}
+
+template class ATKColoredExpanderDSP<float>;
+template class ATKColoredExpanderDSP<double>;
@@ -1,25 +1,12 @@
-#include <cmath>
-
 #include "ATKCompressor.h"
 #include "IPlug_include_in_plug_src.h"
 #include "IControl.h"
 #include "controls.h"
 #include "resource.h"
+#include "../common/IPlugParameters.h"
 
 const int kNumPrograms = 2;
 
-enum EParams
-{
-  kAttack = 0,
-  kRelease,
-  kThreshold,
-  kSlope,
-  kSoftness,
-  kMakeup,
-  kDryWet,
-  kNumParams
-};
-
 enum ELayout
 {
   kWidth = GUI_WIDTH,
@@ -43,26 +30,11 @@ enum ELayout
 };
 
 ATKCompressor::ATKCompressor(IPlugInstanceInfo instanceInfo)
-  :	IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo),
-    inFilter(NULL, 1, 0, false), outFilter(NULL, 1, 0, false)
+  :	IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), tail_length(-1)
 {
   TRACE;
 
-  //arguments are: name, defaultVal, minVal, maxVal, step, label
-  GetParam(kAttack)->InitDouble("Attack", 10., 1., 100.0, 0.1, "ms");
-  GetParam(kAttack)->SetShape(2.);
-  GetParam(kRelease)->InitDouble("Release", 10, 1., 100.0, 0.1, "ms");
-  GetParam(kRelease)->SetShape(2.);
-  GetParam(kThreshold)->InitDouble("Threshold", 0., -40., 0.0, 0.1, "dB"); // threshold is actually power
-  GetParam(kThreshold)->SetShape(2.);
-  GetParam(kSlope)->InitDouble("Slope", 2., 1, 100, 1, "-");
-  GetParam(kSlope)->SetShape(2.);
-  GetParam(kSoftness)->InitDouble("Softness", -2, -4, 0, 0.1, "-");
-  GetParam(kSoftness)->SetShape(2.);
-  GetParam(kMakeup)->InitDouble("Makeup Gain", 0, 0, 40, 0.1, "-"); // Makeup is expressed in amplitude
-  GetParam(kMakeup)->SetShape(2.);
-  GetParam(kDryWet)->InitDouble("Dry/Wet", 1, 0, 1, 0.01, "-");
-  GetParam(kDryWet)->SetShape(1.);
+  InitParameters(this, parameters, kNumParams);
 
   IGraphics* pGraphics = MakeGraphics(this, kWidth, kHeight);
   pGraphics->AttachBackground(COMPRESSOR_ID, COMPRESSOR_FN);
@@ -84,18 +56,6 @@ ATKCompressor::ATKCompressor(IPlugInstanceInfo instanceInfo)
   //MakePreset("preset 1", ... );
   MakePreset("Serial Compression", 10., 10., 0., 2., -2., 0., 0.);
   MakePreset("Parallel Compression", 10., 10., 0., 2., -2., 0., 0.5);
-  
-  powerFilter.set_input_port(0, &inFilter, 0);
-  gainCompressorFilter.set_input_port(0, &powerFilter, 0);
-  attackReleaseFilter.set_input_port(0, &gainCompressorFilter, 0);
-  applyGainFilter.set_input_port(0, &attackReleaseFilter, 0);
-  applyGainFilter.set_input_port(1, &inFilter, 0);
-  volumeFilter.set_input_port(0, &applyGainFilter, 0);
-  drywetFilter.set_input_port(0, &volumeFilter, 0);
-  drywetFilter.set_input_port(1, &inFilter, 0);
-  outFilter.set_input_port(0, &drywetFilter, 0);
-  
-  powerFilter.set_memory(0);
 
   Reset();
 }
@@ -106,74 +66,30 @@ void ATKCompressor::ProcessDoubleReplacing(double** inputs, double** outputs, in
 {
   // Mutex is already locked for us.
 
-  inFilter.set_pointer(inputs[0], nFrames);
-  outFilter.set_pointer(outputs[0], nFrames);
-  outFilter.process(nFrames);
+  dsp.process(inputs, outputs, nFrames);
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKCompressor::Reset()
 {
   TRACE;
   IMutexLock lock(this);
-  
-  int sampling_rate = GetSampleRate();
 
-  if(sampling_rate != outFilter.get_output_sampling_rate())
-  {
-    inFilter.set_input_sampling_rate(sampling_rate);
-    inFilter.set_output_sampling_rate(sampling_rate);
-    powerFilter.set_input_sampling_rate(sampling_rate);
-    powerFilter.set_output_sampling_rate(sampling_rate);
-    attackReleaseFilter.set_input_sampling_rate(sampling_rate);
-    attackReleaseFilter.set_output_sampling_rate(sampling_rate);
-    gainCompressorFilter.set_input_sampling_rate(sampling_rate);
-    gainCompressorFilter.set_output_sampling_rate(sampling_rate);
-    applyGainFilter.set_input_sampling_rate(sampling_rate);
-    applyGainFilter.set_output_sampling_rate(sampling_rate);
-    volumeFilter.set_input_sampling_rate(sampling_rate);
-    volumeFilter.set_output_sampling_rate(sampling_rate);
-    drywetFilter.set_input_sampling_rate(sampling_rate);
-    drywetFilter.set_output_sampling_rate(sampling_rate);
-    outFilter.set_input_sampling_rate(sampling_rate);
-    outFilter.set_output_sampling_rate(sampling_rate);
-    
-    attackReleaseFilter.set_release(std::exp(-1e3 / (GetParam(kAttack)->Value() * sampling_rate))); // in ms
-    attackReleaseFilter.set_attack(std::exp(-1e3 / (GetParam(kRelease)->Value() * sampling_rate))); // in ms
-  }
-  
-  powerFilter.full_setup();
-  attackReleaseFilter.full_setup();
+  dsp.set_sampling_rate(GetSampleRate());
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKCompressor::OnParamChange(int paramIdx)
 {
-  IMutexLock lock(this);
+  dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+}
 
-  switch (paramIdx)
+void ATKCompressor::UpdateTailSize(int64_t tail_length)
+{
+  // the host is only told when the tail changes, not after every block
+  if (tail_length != this->tail_length)
   {
-    case kThreshold:
-      gainCompressorFilter.set_threshold(std::pow(10, GetParam(kThreshold)->Value() / 10));
-      break;
-    case kSlope:
-      gainCompressorFilter.set_ratio(GetParam(kSlope)->Value());
-      break;
-    case kSoftness:
-      gainCompressorFilter.set_softness(std::pow(10, GetParam(kSoftness)->Value()));
-      break;
-    case kAttack:
-      attackReleaseFilter.set_release(std::exp(-1e3 / (GetParam(kAttack)->Value() * GetSampleRate()))); // in ms
-      break;
-    case kRelease:
-      attackReleaseFilter.set_attack(std::exp(-1e3 / (GetParam(kRelease)->Value() * GetSampleRate()))); // in ms
-      break;
-    case kMakeup:
-      volumeFilter.set_volume_db(GetParam(kMakeup)->Value());
-      break;
-    case kDryWet:
-      drywetFilter.set_dry(GetParam(kDryWet)->Value());
-      break;
-
-    default:
-      break;
+    this->tail_length = tail_length;
+    SetTailSize(static_cast<int>(tail_length));
   }
 }
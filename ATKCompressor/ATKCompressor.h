@@ -3,16 +3,9 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 
-#include <ATK/Core/InPointerFilter.h>
-#include <ATK/Core/OutPointerFilter.h>
-#include <ATK/Dynamic/AttackReleaseFilter.h>
-#include <ATK/Dynamic/GainCompressorFilter.h>
-#include <ATK/Dynamic/PowerFilter.h>
-#include <ATK/Tools/ApplyGainFilter.h>
-#include <ATK/Tools/DryWetFilter.h>
-#include <ATK/Tools/VolumeFilter.h>
+#include "ATKCompressorDSP.h"
 
-class ATKCompressor : public IPlug
+class ATKCompressor : public IPlug, public ATKCompressorParameters
 {
 public:
   ATKCompressor(IPlugInstanceInfo instanceInfo);
@@ -23,14 +16,10 @@ public:
   void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
-  ATK::InPointerFilter<double> inFilter;
-  ATK::PowerFilter<double> powerFilter;
-  ATK::AttackReleaseFilter<double> attackReleaseFilter;
-  ATK::GainCompressorFilter<double> gainCompressorFilter;
-  ATK::ApplyGainFilter<double> applyGainFilter;
-  ATK::VolumeFilter<double> volumeFilter;
-  ATK::DryWetFilter<double> drywetFilter;
-  ATK::OutPointerFilter<double> outFilter;
+  void UpdateTailSize(int64_t tail_length);
+
+  ATKCompressorDSP<double> dsp;
+  int64_t tail_length;
 };
 
 #endif
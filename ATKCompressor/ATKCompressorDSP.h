@@ -0,0 +1,88 @@
+#ifndef __ATKCompressorDSP__
+#define __ATKCompressorDSP__
+
+#include "../common/ControlRateRamps.h"
+#include "../common/ParameterInfo.h"
+#include "../common/ParameterQueue.h"
+#include "../common/SilenceDetector.h"
+#include "../common/SmoothedDryWetFilter.h"
+#include "../common/SmoothedVolumeFilter.h"
+#include "FusedCompressorFilter.h"
+
+#include <ATK/Core/InPointerFilter.h>
+#include <ATK/Core/OutPointerFilter.h>
+#include <ATK/Dynamic/AttackReleaseFilter.h>
+#include <ATK/Dynamic/GainCompressorFilter.h>
+#include <ATK/Dynamic/PowerFilter.h>
+#include <ATK/Tools/ApplyGainFilter.h>
+
+struct ATKCompressorParameters
+{
+  enum EParams
+  {
+    kAttack = 0,
+    kRelease,
+    kThreshold,
+    kSlope,
+    kSoftness,
+    kMakeup,
+    kDryWet,
+    kNumParams
+  };
+
+  static const ParameterInfo parameters[kNumParams];
+};
+
+// GUI-free processing graph of ATKCompressor, shared by the plugin and the offline tools
+template<typename DataType_>
+class ATKCompressorDSP : public ATKCompressorParameters
+{
+public:
+  typedef DataType_ DataType;
+
+  static const int nb_inputs = 1;
+  static const int nb_sidechain_inputs = 0;
+  static const int nb_outputs = 1;
+
+  ATKCompressorDSP();
+  ~ATKCompressorDSP();
+
+  void set_sampling_rate(int sampling_rate);
+  void set_parameter(int paramIdx, double value);
+  double get_parameter(int paramIdx) const;
+  // Can be called from any thread, the value is applied at the start of the next process call
+  void post_parameter(int paramIdx, double value);
+  // Shape and duration of the ramps following a parameter change
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  // Samples for the output and the state of the graph to fall below the silence threshold once the input stops
+  int64_t get_tail_length() const;
+  // Processes with the original filter graph (default) or with FusedCompressorFilter, which is
+  // only checked against the graph of the ATK stand-in used by the tools so far
+  void set_fused_kernel(bool fused);
+  bool is_fused_kernel() const;
+  // Gain curve of the fused kernel read from a table, rebuilt by a background thread or, for the
+  // offline tools, synchronously when the ratio or the softness change. Not while processing
+  void set_gain_curve_table(bool tabulated, bool background_build = true);
+  void process(DataType** inputs, DataType** outputs, int nFrames);
+
+private:
+  void apply_parameter(int paramIdx, double value);
+
+  double parameter_values[kNumParams];
+  ParameterQueue<kNumParams> parameter_queue;
+  ControlRateRamps<kNumParams> ramps;
+  SilenceDetector<DataType> silence;
+  bool fused;
+
+  ATK::InPointerFilter<DataType> inFilter;
+  ATK::PowerFilter<DataType> powerFilter;
+  ATK::AttackReleaseFilter<DataType> attackReleaseFilter;
+  ATK::GainCompressorFilter<DataType> gainCompressorFilter;
+  ATK::ApplyGainFilter<DataType> applyGainFilter;
+  SmoothedVolumeFilter<DataType> volumeFilter;
+  SmoothedDryWetFilter<DataType> drywetFilter;
+  FusedCompressorFilter<DataType> fusedFilter;
+  ATK::OutPointerFilter<DataType> outFilter;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include <cmath>
+
+#include "FusedCompressorFilter.h"
+
+template<typename DataType_>
+FusedCompressorFilter<DataType_>::FusedCompressorFilter()
+  :Parent(1, 1), memory(0), threshold(1), ratio(1), softness(static_cast<DataType>(.0001)), attack(1), release(1), tabulated(false), power(0), gain(0)
+{
+  makeup.set_target(1);
+  makeup.snap();
+  dry.set_target(1);
+  dry.snap();
+}
+
+template<typename DataType_>
+FusedCompressorFilter<DataType_>::~FusedCompressorFilter() {}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_memory(DataType memory)
+{
+  this->memory = memory;
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_threshold(DataType threshold)
+{
+  this->threshold = threshold;
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_ratio(DataType ratio)
+{
+  this->ratio = ratio;
+  request_curve();
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_softness(DataType softness)
+{
+  this->softness = softness;
+  request_curve();
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_attack(DataType attack)
+{
+  this->attack = attack;
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_release(DataType release)
+{
+  this->release = release;
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  makeup.set_smoothing(mode, time_ms);
+  dry.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_volume_db(double volume_db)
+{
+  makeup.set_target(std::pow(10., volume_db / 20));
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_dry(double dry)
+{
+  this->dry.set_target(dry);
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::set_tabulated(bool tabulated, bool background_build)
+{
+  this->tabulated = tabulated;
+  // the first curve is built right away
+  table.set_background_build(false);
+  request_curve();
+  table.set_background_build(tabulated && background_build);
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::request_curve()
+{
+  if (tabulated)
+  {
+    table.request(ratio, softness);
+  }
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::full_setup()
+{
+  Parent::full_setup();
+  power = 0;
+  gain = 0;
+  makeup.snap();
+  dry.snap();
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::setup()
+{
+  Parent::setup();
+  makeup.set_sampling_rate(this->get_output_sampling_rate());
+  makeup.snap();
+  dry.set_sampling_rate(this->get_output_sampling_rate());
+  dry.snap();
+}
+
+template<typename DataType_>
+void FusedCompressorFilter<DataType_>::process_impl(int64_t size) const
+{
+  if (tabulated)
+  {
+    table.acquire();
+    process_loop<true>(size);
+  }
+  else
+  {
+    process_loop<false>(size);
+  }
+}
+
+template<typename DataType_>
+template<bool Tabulated>
+void FusedCompressorFilter<DataType_>::process_loop(int64_t size) const
+{
+  const DataType* input = converted_inputs[0];
+  DataType* output = outputs[0];
+
+  // 10^(-(sqrt(d^2 + softness) + d) / 40 * (ratio - 1) / ratio), with d the distance to the
+  // threshold in dB, computed with natural exponentials and logarithms
+  const DataType db_factor = static_cast<DataType>(10 / std::log(10.));
+  const DataType gain_factor = static_cast<DataType>(-std::log(10.) / 40 * (ratio - 1) / ratio);
+  const DataType inv_threshold = 1 / threshold;
+
+  DataType current_power = power;
+  DataType current_gain = gain;
+  DataType current_makeup = static_cast<DataType>(makeup.get_value());
+  DataType current_dry = static_cast<DataType>(dry.get_value());
+  const bool ramping = makeup.is_smoothing() || dry.is_smoothing();
+
+  for (int64_t i = 0; i < size; ++i)
+  {
+    DataType x = input[i];
+    current_power = (1 - memory) * x * x + memory * current_power;
+
+    DataType static_gain = 1;
+    DataType value = current_power * inv_threshold;
+    if (Tabulated)
+    {
+      static_gain = table.get_gain(value);
+    }
+    else if (value != 0)
+    {
+      DataType diff = db_factor * std::log(value);
+      static_gain = std::exp(gain_factor * (std::sqrt(diff * diff + softness) + diff));
+    }
+
+    if (static_gain > current_gain)
+      current_gain = (1 - attack) * static_gain + attack * current_gain;
+    else
+      current_gain = (1 - release) * static_gain + release * current_gain;
+
+    if (ramping)
+    {
+      current_makeup = static_cast<DataType>(makeup.next());
+      current_dry = static_cast<DataType>(dry.next());
+    }
+    output[i] = current_dry * (current_gain * x * current_makeup) + (1 - current_dry) * x;
+  }
+
+  power = current_power;
+  gain = current_gain;
+}
+
+template class FusedCompressorFilter<float>;
+template class FusedCompressorFilter<double>;
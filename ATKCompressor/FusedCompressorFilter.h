@@ -0,0 +1,64 @@
+#ifndef __FusedCompressorFilter__
+#define __FusedCompressorFilter__
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+#include "../common/GainCurveTable.h"
+#include "../common/ParameterSmoother.h"
+
+// The whole ATKCompressor chain in a single loop: power, gain curve, attack/release, gain, makeup
+// and dry/wet, without the intermediate buffers of the filter graph
+// Same conventions as the ATK filters it replaces (threshold in power, attack and release as
+// one pole coefficients), the makeup gain and the dry/wet are ramped as in the smoothed filters
+template<typename DataType_>
+class FusedCompressorFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+
+public:
+  FusedCompressorFilter();
+  ~FusedCompressorFilter();
+
+  void set_memory(DataType memory);
+  void set_threshold(DataType threshold);
+  void set_ratio(DataType ratio);
+  void set_softness(DataType softness);
+  void set_attack(DataType attack);
+  void set_release(DataType release);
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  void set_volume_db(double volume_db);
+  void set_dry(double dry);
+  // Gain curve read from a GainCurveTable, not to be changed while processing
+  void set_tabulated(bool tabulated, bool background_build);
+
+  void full_setup();
+
+protected:
+  void setup();
+  void process_impl(int64_t size) const;
+
+private:
+  template<bool Tabulated>
+  void process_loop(int64_t size) const;
+  void request_curve();
+
+  DataType memory;
+  DataType threshold;
+  DataType ratio;
+  DataType softness;
+  DataType attack;
+  DataType release;
+  bool tabulated;
+
+  mutable ParameterSmoother makeup;
+  mutable ParameterSmoother dry;
+  mutable DataType power;
+  mutable DataType gain;
+  mutable GainCurveTable<DataType> table;
+};
+
+#endif
@@ -1,23 +1,12 @@
-#include <cmath>
-
 #include "ATKExpander.h"
 #include "IPlug_include_in_plug_src.h"
 #include "IControl.h"
 #include "resource.h"
+#include "../common/IPlugParameters.h"
 #include "controls.h"
 
 const int kNumPrograms = 1;
 
-enum EParams
-{
-  kAttack = 0,
-  kRelease,
-  kThreshold,
-  kSlope,
-  kSoftness,
-  kNumParams
-};
-
 enum ELayout
 {
   kWidth = GUI_WIDTH,
@@ -37,22 +26,11 @@ enum ELayout
 };
 
 ATKExpander::ATKExpander(IPlugInstanceInfo instanceInfo)
-  :	IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo),
-    inFilter(NULL, 1, 0, false), outFilter(NULL, 1, 0, false)
+  :	IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), tail_length(-1)
 {
   TRACE;
 
-  //arguments are: name, defaultVal, minVal, maxVal, step, label
-  GetParam(kAttack)->InitDouble("Attack", 10., 1., 100.0, 0.1, "ms");
-  GetParam(kAttack)->SetShape(2.);
-  GetParam(kRelease)->InitDouble("Release", 10, 1., 100.0, 0.1, "ms");
-  GetParam(kRelease)->SetShape(2.);
-  GetParam(kThreshold)->InitDouble("Threshold", 0., -60., 0.0, 0.1, "dB"); // threshold is actually power
-  GetParam(kThreshold)->SetShape(2.);
-  GetParam(kSlope)->InitDouble("Slope", 2., 1, 100, 1, "-");
-  GetParam(kSlope)->SetShape(2.);
-  GetParam(kSoftness)->InitDouble("Softness", -2, -4, 0, 0.1, "-");
-  GetParam(kSoftness)->SetShape(2.);
+  InitParameters(this, parameters, kNumParams);
 
   IGraphics* pGraphics = MakeGraphics(this, kWidth, kHeight);
   pGraphics->AttachBackground(COMPRESSOR_ID, COMPRESSOR_FN);
@@ -70,15 +48,6 @@ ATKExpander::ATKExpander(IPlugInstanceInfo instanceInfo)
 
   //MakePreset("preset 1", ... );
   MakeDefaultPreset((char *) "-", kNumPrograms);
-  
-  powerFilter.set_input_port(0, &inFilter, 0);
-  gainExpanderFilter.set_input_port(0, &powerFilter, 0);
-  attackReleaseFilter.set_input_port(0, &gainExpanderFilter, 0);
-  applyGainFilter.set_input_port(0, &attackReleaseFilter, 0);
-  applyGainFilter.set_input_port(1, &inFilter, 0);
-  outFilter.set_input_port(0, &applyGainFilter, 0);
-  
-  powerFilter.set_memory(0);
 
   Reset();
 }
@@ -89,58 +58,30 @@ void ATKExpander::ProcessDoubleReplacing(double** inputs, double** outputs, int
 {
   // Mutex is already locked for us.
 
-  inFilter.set_pointer(inputs[0], nFrames);
-  outFilter.set_pointer(outputs[0], nFrames);
-  outFilter.process(nFrames);
+  dsp.process(inputs, outputs, nFrames);
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKExpander::Reset()
 {
   TRACE;
   IMutexLock lock(this);
-  
-  int sampling_rate = GetSampleRate();
-  
-  inFilter.set_input_sampling_rate(sampling_rate);
-  inFilter.set_output_sampling_rate(sampling_rate);
-  powerFilter.set_input_sampling_rate(sampling_rate);
-  powerFilter.set_output_sampling_rate(sampling_rate);
-  attackReleaseFilter.set_input_sampling_rate(sampling_rate);
-  attackReleaseFilter.set_output_sampling_rate(sampling_rate);
-  gainExpanderFilter.set_input_sampling_rate(sampling_rate);
-  gainExpanderFilter.set_output_sampling_rate(sampling_rate);
-  applyGainFilter.set_input_sampling_rate(sampling_rate);
-  applyGainFilter.set_output_sampling_rate(sampling_rate);
-  outFilter.set_input_sampling_rate(sampling_rate);
-  outFilter.set_output_sampling_rate(sampling_rate);
-
-  attackReleaseFilter.set_attack(std::exp(-1e3 / (GetParam(kAttack)->Value() * sampling_rate))); // in ms
-  attackReleaseFilter.set_release(std::exp(-1e3 / (GetParam(kRelease)->Value() * sampling_rate))); // in ms
+
+  dsp.set_sampling_rate(GetSampleRate());
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKExpander::OnParamChange(int paramIdx)
 {
-  IMutexLock lock(this);
+  dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+}
 
-  switch (paramIdx)
+void ATKExpander::UpdateTailSize(int64_t tail_length)
+{
+  // the host is only told when the tail changes, not after every block
+  if (tail_length != this->tail_length)
   {
-    case kThreshold:
-      gainExpanderFilter.set_threshold(std::pow(10, GetParam(kThreshold)->Value() / 10));
-      break;
-    case kSlope:
-      gainExpanderFilter.set_ratio(GetParam(kSlope)->Value());
-      break;
-    case kSoftness:
-      gainExpanderFilter.set_softness(std::pow(10, GetParam(kSoftness)->Value()));
-      break;
-    case kAttack:
-      attackReleaseFilter.set_attack(std::exp(-1e3 / (GetParam(kAttack)->Value() * GetSampleRate()))); // in ms
-      break;
-    case kRelease:
-      attackReleaseFilter.set_release(std::exp(-1e3 / (GetParam(kRelease)->Value() * GetSampleRate()))); // in ms
-      break;
-
-    default:
-      break;
+    this->tail_length = tail_length;
+    SetTailSize(static_cast<int>(tail_length));
   }
 }
@@ -3,14 +3,9 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 
-#include <ATK/Core/InPointerFilter.h>
-#include <ATK/Core/OutPointerFilter.h>
-#include <ATK/Dynamic/AttackReleaseFilter.h>
-#include <ATK/Dynamic/GainExpanderFilter.h>
-#include <ATK/Dynamic/PowerFilter.h>
-#include <ATK/Tools/ApplyGainFilter.h>
+#include "ATKExpanderDSP.h"
 
-class ATKExpander : public IPlug
+class ATKExpander : public IPlug, public ATKExpanderParameters
 {
 public:
   ATKExpander(IPlugInstanceInfo instanceInfo);
@@ -21,12 +16,10 @@ public:
   void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
-  ATK::InPointerFilter<double> inFilter;
-  ATK::PowerFilter<double> powerFilter;
-  ATK::AttackReleaseFilter<double> attackReleaseFilter;
-  ATK::GainExpanderFilter<double> gainExpanderFilter;
-  ATK::ApplyGainFilter<double> applyGainFilter;
-  ATK::OutPointerFilter<double> outFilter;
+  void UpdateTailSize(int64_t tail_length);
+
+  ATKExpanderDSP<double> dsp;
+  int64_t tail_length;
 };
 
 #endif
@@ -0,0 +1,160 @@
+#include <cmath>
+
+#include "ATKExpanderDSP.h"
+
+const ParameterInfo ATKExpanderParameters::parameters[kNumParams] =
+{
+  {"Attack", 10., 1., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Release", 10, 1., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Threshold", 0., -60., 0.0, 0.1, "dB", 2., false, NULL}, // threshold is actually power
+  {"Slope", 2., 1, 100, 1, "-", 2., false, NULL},
+  {"Softness", -2, -4, 0, 0.1, "-", 2., false, NULL}
+};
+
+template<typename DataType_>
+ATKExpanderDSP<DataType_>::ATKExpanderDSP()
+  :inFilter(NULL, 1, 0, false), outFilter(NULL, 1, 0, false)
+{
+  powerFilter.set_input_port(0, &inFilter, 0);
+  gainExpanderFilter.set_input_port(0, &powerFilter, 0);
+  attackReleaseFilter.set_input_port(0, &gainExpanderFilter, 0);
+  applyGainFilter.set_input_port(0, &attackReleaseFilter, 0);
+  applyGainFilter.set_input_port(1, &inFilter, 0);
+  outFilter.set_input_port(0, &applyGainFilter, 0);
+
+  powerFilter.set_memory(0);
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kThreshold);
+  ramps.set_ramped(kSlope);
+  ramps.set_ramped(kSoftness);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_>
+ATKExpanderDSP<DataType_>::~ATKExpanderDSP() {}
+
+template<typename DataType_>
+void ATKExpanderDSP<DataType_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // silent inputs, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, nb_inputs, nFrames, get_tail_length()))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    inFilter.set_pointer(inputs[0] + offset, size);
+    outFilter.set_pointer(outputs[0] + offset, size);
+    outFilter.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_>
+void ATKExpanderDSP<DataType_>::set_sampling_rate(int sampling_rate)
+{
+  ramps.set_sampling_rate(sampling_rate);
+
+  inFilter.set_input_sampling_rate(sampling_rate);
+  inFilter.set_output_sampling_rate(sampling_rate);
+  powerFilter.set_input_sampling_rate(sampling_rate);
+  powerFilter.set_output_sampling_rate(sampling_rate);
+  attackReleaseFilter.set_input_sampling_rate(sampling_rate);
+  attackReleaseFilter.set_output_sampling_rate(sampling_rate);
+  gainExpanderFilter.set_input_sampling_rate(sampling_rate);
+  gainExpanderFilter.set_output_sampling_rate(sampling_rate);
+  applyGainFilter.set_input_sampling_rate(sampling_rate);
+  applyGainFilter.set_output_sampling_rate(sampling_rate);
+  outFilter.set_input_sampling_rate(sampling_rate);
+  outFilter.set_output_sampling_rate(sampling_rate);
+
+  attackReleaseFilter.set_attack(std::exp(-1e3 / (parameter_values[kAttack] * sampling_rate))); // in ms
+  attackReleaseFilter.set_release(std::exp(-1e3 / (parameter_values[kRelease] * sampling_rate))); // in ms
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_>
+double ATKExpanderDSP<DataType_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_>
+void ATKExpanderDSP<DataType_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_>
+void ATKExpanderDSP<DataType_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_>
+int64_t ATKExpanderDSP<DataType_>::get_tail_length() const
+{
+  // the attack and release filters decay one after the other
+  double time_constant = (parameter_values[kAttack] + parameter_values[kRelease]) / 1000.;
+  return static_cast<int64_t>(SilenceDetector<DataType>::decay_time(time_constant) * outFilter.get_output_sampling_rate());
+}
+
+template<typename DataType_>
+void ATKExpanderDSP<DataType_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, value);
+  }
+  else
+  {
+    apply_parameter(paramIdx, value);
+  }
+}
+
+template<typename DataType_>
+void ATKExpanderDSP<DataType_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+    case kThreshold:
+      gainExpanderFilter.set_threshold(std::pow(10, value / 10));
+      break;
+    case kSlope:
+      gainExpanderFilter.set_ratio(value);
+      break;
+    case kSoftness:
+      gainExpanderFilter.set_softness(std::pow(10, value));
+      break;
+    case kAttack:
+      attackReleaseFilter.set_attack(std::exp(-1e3 / (value * outFilter.get_output_sampling_rate()))); // in ms
+      break;
+    case kRelease:
+      attackReleaseFilter.set_release(std::exp(-1e3 / (value * outFilter.get_output_sampling_rate()))); // in ms
+      break;
+
+    default:
+      break;
+  }
+}
+
+template class ATKExpanderDSP<float>;
+template class ATKExpanderDSP<double>;
@@ -0,0 +1,72 @@
+#ifndef __ATKExpanderDSP__
+#define __ATKExpanderDSP__
+
+#include "../common/ControlRateRamps.h"
+#include "../common/ParameterInfo.h"
+#include "../common/ParameterQueue.h"
+#include "../common/SilenceDetector.h"
+
+#include <ATK/Core/InPointerFilter.h>
+#include <ATK/Core/OutPointerFilter.h>
+#include <ATK/Dynamic/AttackReleaseFilter.h>
+#include <ATK/Dynamic/GainExpanderFilter.h>
+#include <ATK/Dynamic/PowerFilter.h>
+#include <ATK/Tools/ApplyGainFilter.h>
+
+struct ATKExpanderParameters
+{
+  enum EParams
+  {
+    kAttack = 0,
+    kRelease,
+    kThreshold,
+    kSlope,
+    kSoftness,
+    kNumParams
+  };
+
+  static const ParameterInfo parameters[kNumParams];
+};
+
+// GUI-free processing graph of ATKExpander, shared by the plugin and the offline tools
+template<typename DataType_>
+class ATKExpanderDSP : public ATKExpanderParameters
+{
+public:
+  typedef DataType_ DataType;
+
+  static const int nb_inputs = 1;
+  static const int nb_sidechain_inputs = 0;
+  static const int nb_outputs = 1;
+
+  ATKExpanderDSP();
+  ~ATKExpanderDSP();
+
+  void set_sampling_rate(int sampling_rate);
+  void set_parameter(int paramIdx, double value);
+  double get_parameter(int paramIdx) const;
+  // Can be called from any thread, the value is applied at the start of the next process call
+  void post_parameter(int paramIdx, double value);
+  // Shape and duration of the ramps following a parameter change
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  // Samples for the output and the state of the graph to fall below the silence threshold once the input stops
+  int64_t get_tail_length() const;
+  void process(DataType** inputs, DataType** outputs, int nFrames);
+
+private:
+  void apply_parameter(int paramIdx, double value);
+
+  double parameter_values[kNumParams];
+  ParameterQueue<kNumParams> parameter_queue;
+  ControlRateRamps<kNumParams> ramps;
+  SilenceDetector<DataType> silence;
+
+  ATK::InPointerFilter<DataType> inFilter;
+  ATK::PowerFilter<DataType> powerFilter;
+  ATK::AttackReleaseFilter<DataType> attackReleaseFilter;
+  ATK::GainExpanderFilter<DataType> gainExpanderFilter;
+  ATK::ApplyGainFilter<DataType> applyGainFilter;
+  ATK::OutPointerFilter<DataType> outFilter;
+};
+
+#endif
@@ -3,15 +3,9 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 
-#include <ATK/Core/InPointerFilter.h>
-#include <ATK/Core/OutPointerFilter.h>
-#include <ATK/Dynamic/AttackReleaseFilter.h>
-#include <ATK/Dynamic/GainLimiterFilter.h>
-#include <ATK/Dynamic/PowerFilter.h>
-#include <ATK/Tools/ApplyGainFilter.h>
-#include <ATK/Tools/VolumeFilter.h>
+#include "ATKLimiterDSP.h"
 
-class ATKLimiter : public IPlug
+class ATKLimiter : public IPlug, public ATKLimiterParameters
 {
 public:
   ATKLimiter(IPlugInstanceInfo instanceInfo);
@@ -22,13 +16,10 @@ public:
   void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
-  ATK::InPointerFilter<double> inFilter;
-  ATK::PowerFilter<double> powerFilter;
-  ATK::AttackReleaseFilter<double> attackReleaseFilter;
-  ATK::GainLimiterFilter<double> gainLimiterFilter;
-  ATK::ApplyGainFilter<double> applyGainFilter;
-  ATK::VolumeFilter<double> volumeFilter;
-  ATK::OutPointerFilter<double> outFilter;
+  void UpdateTailSize(int64_t tail_length);
+
+  ATKLimiterDSP<double> dsp;
+  int64_t tail_length;
 };
 
 #endif
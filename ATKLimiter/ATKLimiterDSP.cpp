@@ -0,0 +1,178 @@
+#include <cmath>
+
+#include "ATKLimiterDSP.h"
+
+const ParameterInfo ATKLimiterParameters::parameters[kNumParams] =
+{
+  {"Attack", 10., 0., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Release", 10, 0., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Threshold", 0., -40., 0.0, 0.1, "dB", 2., false, NULL}, // threshold is actually power
+  {"Softness", -2, -4, 0, 0.1, "-", 2., false, NULL},
+  {"Makeup Gain", 0, 0, 40, 0.1, "-", 2., false, NULL} // Makeup is expressed in amplitude
+};
+
+template<typename DataType_>
+ATKLimiterDSP<DataType_>::ATKLimiterDSP()
+  :inFilter(NULL, 1, 0, false), outFilter(NULL, 1, 0, false)
+{
+  powerFilter.set_input_port(0, &inFilter, 0);
+  gainLimiterFilter.set_input_port(0, &powerFilter, 0);
+  attackReleaseFilter.set_input_port(0, &gainLimiterFilter, 0);
+  applyGainFilter.set_input_port(0, &attackReleaseFilter, 0);
+  applyGainFilter.set_input_port(1, &inFilter, 0);
+  volumeFilter.set_input_port(0, &applyGainFilter, 0);
+  outFilter.set_input_port(0, &volumeFilter, 0);
+
+  powerFilter.set_memory(0);
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kThreshold);
+  ramps.set_ramped(kSoftness);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_>
+ATKLimiterDSP<DataType_>::~ATKLimiterDSP() {}
+
+template<typename DataType_>
+void ATKLimiterDSP<DataType_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // inputs silent even after the makeup gain, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, nb_inputs, nFrames, get_tail_length(), std::pow(10., parameter_values[kMakeup] / 20)))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    inFilter.set_pointer(inputs[0] + offset, size);
+    outFilter.set_pointer(outputs[0] + offset, size);
+    outFilter.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_>
+void ATKLimiterDSP<DataType_>::set_sampling_rate(int sampling_rate)
+{
+  ramps.set_sampling_rate(sampling_rate);
+
+  inFilter.set_input_sampling_rate(sampling_rate);
+  inFilter.set_output_sampling_rate(sampling_rate);
+  powerFilter.set_input_sampling_rate(sampling_rate);
+  powerFilter.set_output_sampling_rate(sampling_rate);
+  attackReleaseFilter.set_input_sampling_rate(sampling_rate);
+  attackReleaseFilter.set_output_sampling_rate(sampling_rate);
+  gainLimiterFilter.set_input_sampling_rate(sampling_rate);
+  gainLimiterFilter.set_output_sampling_rate(sampling_rate);
+  applyGainFilter.set_input_sampling_rate(sampling_rate);
+  applyGainFilter.set_output_sampling_rate(sampling_rate);
+  volumeFilter.set_input_sampling_rate(sampling_rate);
+  volumeFilter.set_output_sampling_rate(sampling_rate);
+  outFilter.set_input_sampling_rate(sampling_rate);
+  outFilter.set_output_sampling_rate(sampling_rate);
+
+  attackReleaseFilter.set_release(std::exp(-1e3 / (parameter_values[kAttack] * sampling_rate))); // in ms
+  attackReleaseFilter.set_attack(std::exp(-1e3 / (parameter_values[kRelease] * sampling_rate))); // in ms
+  volumeFilter.full_setup();
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_>
+double ATKLimiterDSP<DataType_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_>
+void ATKLimiterDSP<DataType_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_>
+void ATKLimiterDSP<DataType_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+  volumeFilter.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_>
+int64_t ATKLimiterDSP<DataType_>::get_tail_length() const
+{
+  // the attack and release filters decay one after the other
+  double time_constant = (parameter_values[kAttack] + parameter_values[kRelease]) / 1000.;
+  return static_cast<int64_t>(SilenceDetector<DataType>::decay_time(time_constant) * outFilter.get_output_sampling_rate());
+}
+
+template<typename DataType_>
+void ATKLimiterDSP<DataType_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, value);
+  }
+  else
+  {
+    apply_parameter(paramIdx, value);
+  }
+}
+
+template<typename DataType_>
+void ATKLimiterDSP<DataType_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+    case kThreshold:
+      gainLimiterFilter.set_threshold(std::pow(10, value / 10));
+      break;
+    case kSoftness:
+      gainLimiterFilter.set_softness(std::pow(10, value));
+      break;
+    case kAttack:
+      if (value == 0)
+      {
+        attackReleaseFilter.set_release(0); // in ms
+      }
+      else
+      {
+        attackReleaseFilter.set_release(std::exp(-1e3 / (value * outFilter.get_output_sampling_rate()))); // in ms
+      }
+      break;
+    case kRelease:
+      if (value == 0)
+      {
+        attackReleaseFilter.set_attack(0); // in ms
+      }
+      else
+      {
+        attackReleaseFilter.set_attack(std::exp(-1e3 / (value * outFilter.get_output_sampling_rate()))); // in ms
+      }
+      break;
+    case kMakeup:
+      volumeFilter.set_volume_db(value);
+      break;
+
+    default:
+      break;
+  }
+}
+
+template class ATKLimiterDSP<float>;
+template class ATKLimiterDSP<double>;
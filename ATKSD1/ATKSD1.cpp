@@ -2,17 +2,10 @@
 #include "IPlug_include_in_plug_src.h"
 #include "IControl.h"
 #include "resource.h"
+#include "../common/IPlugParameters.h"
 
 const int kNumPrograms = 1;
 
-enum EParams
-{
-  kDrive = 0,
-  kTone,
-  kLevel,
-  kNumParams
-};
-
 enum ELayout
 {
   kWidth = GUI_WIDTH,
@@ -28,18 +21,11 @@ enum ELayout
 };
 
 ATKSD1::ATKSD1(IPlugInstanceInfo instanceInfo)
-  :	IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), mDrive(0.), mTone(50), mLevel(100),
-    inFilter(NULL, 1, 0, false), outFilter(NULL, 1, 0, false)
+  :	IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), tail_length(-1)
 {
   TRACE;
 
-  //arguments are: name, defaultVal, minVal, maxVal, step, label
-  GetParam(kDrive)->InitDouble("Drive", 0., 0., 100.0, 0.01, "%");
-  GetParam(kDrive)->SetShape(2.);
-  GetParam(kTone)->InitDouble("Tone", 0, -100., 100.0, 0.01, "%");
-  GetParam(kTone)->SetShape(1.);
-  GetParam(kLevel)->InitDouble("Level", 100., 0., 100.0, 0.01, "%");
-  GetParam(kLevel)->SetShape(2.);
+  InitParameters(this, parameters, kNumParams);
 
   IGraphics* pGraphics = MakeGraphics(this, kWidth, kHeight);
   pGraphics->AttachBackground(SD1_ID, SD1_FN);
@@ -50,28 +36,12 @@ ATKSD1::ATKSD1(IPlugInstanceInfo instanceInfo)
   pGraphics->AttachControl(new IKnobMultiControl(this, kDriveX, kDriveY, kDrive, &bigknob));
   pGraphics->AttachControl(new IKnobMultiControl(this, kToneX, kToneY, kTone, &smallknob));
   pGraphics->AttachControl(new IKnobMultiControl(this, kLevelX, kLevelY, kLevel, &bigknob));
+  // Quality and Resampling have no knob on the background, they are set by automation and presets
 
   AttachGraphics(pGraphics);
 
   //MakePreset("preset 1", ... );
   MakeDefaultPreset((char *) "-", kNumPrograms);
-  
-  //SetLatency(3);
-
-  oversamplingFilter.set_input_port(0, &inFilter, 0);
-  overdriveFilter.set_input_port(0, &oversamplingFilter, 0);
-  lowpassFilter.set_input_port(0, &overdriveFilter, 0);
-  decimationFilter.set_input_port(0, &lowpassFilter, 0);
-  toneFilter.set_input_port(0, &decimationFilter, 0);
-  highpassFilter.set_input_port(0, &toneFilter, 0);
-  volumeFilter.set_input_port(0, &highpassFilter, 0);
-  outFilter.set_input_port(0, &volumeFilter, 0);
-  
-  lowpassFilter.set_cut_frequency(20000);
-  lowpassFilter.set_order(6);
-  highpassFilter.select(2);
-  highpassFilter.set_cut_frequency(20);
-  highpassFilter.set_attenuation(1);
 
   Reset();
 }
@@ -82,56 +52,57 @@ void ATKSD1::ProcessDoubleReplacing(double** inputs, double** outputs, int nFram
 {
   // Mutex is already locked for us.
 
-  inFilter.set_pointer(inputs[0], nFrames);
-  outFilter.set_pointer(outputs[0], nFrames);
-  outFilter.process(nFrames);
+  if (IsInChannelConnected(1))
+  {
+    stereo_dsp.process(inputs, outputs, nFrames);
+    UpdateTailSize(stereo_dsp.get_tail_length());
+  }
+  else
+  {
+    dsp.process(inputs, outputs, nFrames);
+    UpdateTailSize(dsp.get_tail_length());
+  }
 }
 
 void ATKSD1::Reset()
 {
   TRACE;
   IMutexLock lock(this);
-  
-  int sampling_rate = GetSampleRate();
-  
-  inFilter.set_input_sampling_rate(sampling_rate);
-  inFilter.set_output_sampling_rate(sampling_rate);
-  oversamplingFilter.set_input_sampling_rate(sampling_rate);
-  oversamplingFilter.set_output_sampling_rate(sampling_rate * 8);
-  overdriveFilter.set_input_sampling_rate(sampling_rate * 8);
-  overdriveFilter.set_output_sampling_rate(sampling_rate * 8);
-  lowpassFilter.set_input_sampling_rate(sampling_rate * 8);
-  lowpassFilter.set_output_sampling_rate(sampling_rate * 8);
-  decimationFilter.set_input_sampling_rate(sampling_rate * 8);
-  decimationFilter.set_output_sampling_rate(sampling_rate);
-  toneFilter.set_input_sampling_rate(sampling_rate);
-  toneFilter.set_output_sampling_rate(sampling_rate);
-  highpassFilter.set_input_sampling_rate(sampling_rate);
-  highpassFilter.set_output_sampling_rate(sampling_rate);
-  volumeFilter.set_input_sampling_rate(sampling_rate);
-  volumeFilter.set_output_sampling_rate(sampling_rate);
-  outFilter.set_input_sampling_rate(sampling_rate);
-  outFilter.set_output_sampling_rate(sampling_rate);
-  overdriveFilter.set_drive(GetParam(kDrive)->Value() / 100.);
+
+  // the oversampling chains are allocated here, switching between them in ProcessDoubleReplacing does not allocate
+  dsp.set_max_block_size(GetBlockSize());
+  dsp.set_offline(IsRenderingOffline());
+  dsp.set_sampling_rate(GetSampleRate());
+  stereo_dsp.set_max_block_size(GetBlockSize());
+  stereo_dsp.set_offline(IsRenderingOffline());
+  stereo_dsp.set_sampling_rate(GetSampleRate());
+  UpdateTailSize(dsp.get_tail_length());
+  UpdateLatency();
 }
 
 void ATKSD1::OnParamChange(int paramIdx)
 {
-  IMutexLock lock(this);
+  dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+  stereo_dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
 
-  switch (paramIdx)
+  if (paramIdx == kResampling)
+  {
+    UpdateLatency();
+  }
+}
+
+void ATKSD1::UpdateLatency()
+{
+  // the same for the mono and the stereo graphs, and for all the Quality values
+  SetLatency(dsp.get_latency(static_cast<PolyphaseOversampling::FilterPhase>(GetParam(kResampling)->Int())));
+}
+
+void ATKSD1::UpdateTailSize(int64_t tail_length)
+{
+  // the host is only told when the tail changes, not after every block
+  if (tail_length != this->tail_length)
   {
-    case kDrive:
-      overdriveFilter.set_drive(GetParam(kDrive)->Value() / 100.);
-      break;
-    case kTone:
-      toneFilter.set_tone((GetParam(kTone)->Value() + 100) / 200.);
-      break;
-    case kLevel:
-      volumeFilter.set_volume(GetParam(kLevel)->Value() / 150.);
-      break;
-
-    default:
-      break;
+    this->tail_length = tail_length;
+    SetTailSize(static_cast<int>(tail_length));
   }
 }
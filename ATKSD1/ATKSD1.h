@@ -3,18 +3,9 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 
-#include <ATK/Core/InPointerFilter.h>
-#include <ATK/Core/OutPointerFilter.h>
-#include <ATK/Tools/OversamplingFilter.h>
-#include <ATK/Tools/DecimationFilter.h>
-#include <ATK/Tools/VolumeFilter.h>
-#include <ATK/EQ/ButterworthFilter.h>
-#include <ATK/EQ/IIRFilter.h>
-#include <ATK/EQ/SD1ToneFilter.h>
-#include <ATK/EQ/ChamberlinFilter.h>
-#include <ATK/Distortion/SD1OverdriveFilter.h>
+#include "ATKSD1DSP.h"
 
-class ATKSD1 : public IPlug
+class ATKSD1 : public IPlug, public ATKSD1Parameters
 {
 public:
   ATKSD1(IPlugInstanceInfo instanceInfo);
@@ -25,19 +16,13 @@ public:
   void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
-  double mDrive;
-  double mTone;
-  double mLevel;
+  void UpdateLatency();
+  void UpdateTailSize(int64_t tail_length);
 
-  ATK::InPointerFilter<double> inFilter;
-  ATK::OversamplingFilter<double, ATK::Oversampling6points5order_8<double> > oversamplingFilter;
-  ATK::SD1OverdriveFilter<double> overdriveFilter;
-  ATK::IIRFilter<ATK::ButterworthLowPassCoefficients<double> > lowpassFilter;
-  ATK::DecimationFilter<double> decimationFilter;
-  ATK::IIRFilter<ATK::SD1ToneCoefficients<double> > toneFilter;
-  ATK::ChamberlinFilter<double> highpassFilter;
-  ATK::VolumeFilter<double> volumeFilter;
-  ATK::OutPointerFilter<double> outFilter;
+  ATKSD1DSP<double> dsp;
+  // both channels of a stereo bus in one graph
+  ATKSD1DSP<double, 2> stereo_dsp;
+  int64_t tail_length;
 };
 
 #endif
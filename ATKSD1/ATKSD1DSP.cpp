@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <vector>
+
+#include "ATKSD1DSP.h"
+
+namespace
+{
+  // oversampling factor 1 << quality
+  const char* const quality_names[] = {"1x", "2x", "4x", "8x", "16x", "32x"};
+  const int max_quality = PolyphaseOversampling::max_nb_stages;
+  const char* const resampling_names[] = {"Linear phase", "Min latency"};
+}
+
+const ParameterInfo ATKSD1Parameters::parameters[kNumParams] =
+{
+  {"Drive", 0., 0., 100.0, 0.01, "%", 2., false, NULL},
+  {"Tone", 0, -100., 100.0, 0.01, "%", 1., false, NULL},
+  {"Level", 100., 0., 100.0, 0.01, "%", 2., false, NULL},
+  {"Quality", 3, 0, max_quality, 1, "", 1., false, quality_names},
+  {"Resampling", 0, 0, 1, 1, "", 1., false, resampling_names}
+};
+
+template<typename DataType_, int nb_channels_>
+ATKSD1DSP<DataType_, nb_channels_>::ATKSD1DSP()
+  :sampling_rate(44100), max_block_size(0), oversampling_factor(0), phase(PolyphaseOversampling::kLinearPhase), offline(false), overdrive_solver(kATKSolver),
+  drive(0), chain(NULL), toneFilter(nb_channels), volumeFilter(nb_channels)
+{
+  for (int channel = 0; channel < nb_channels; ++channel)
+  {
+    inFilters[channel].reset(new ATK::InPointerFilter<DataType>(NULL, 1, 0, false));
+    outFilters[channel].reset(new ATK::OutPointerFilter<DataType>(NULL, 1, 0, false));
+    endpoint.add_filter(outFilters[channel].get());
+
+    for (auto& oversampling : chains)
+    {
+      oversampling.oversamplingFilter.set_input_port(channel, inFilters[channel].get(), 0);
+      oversampling.overdriveFilters[channel].set_input_port(0, &oversampling.oversamplingFilter, channel);
+      oversampling.clipperFilter.set_input_port(channel, &oversampling.oversamplingFilter, channel);
+      oversampling.decimationFilter.set_input_port(channel, &oversampling.overdriveFilters[channel], 0);
+    }
+    highpassFilters[channel].set_input_port(0, &toneFilter, channel);
+    volumeFilter.set_input_port(channel, &highpassFilters[channel], 0);
+    outFilters[channel]->set_input_port(0, &volumeFilter, channel);
+
+    highpassFilters[channel].select(2);
+    highpassFilters[channel].set_cut_frequency(20);
+    highpassFilters[channel].set_attenuation(1);
+  }
+  latencies[PolyphaseOversampling::kLinearPhase] = PolyphaseOversampling::get_latency(PolyphaseOversampling::kLong, PolyphaseOversampling::kLinearPhase);
+  latencies[PolyphaseOversampling::kMinimumPhase] = PolyphaseOversampling::get_latency(PolyphaseOversampling::kLong, PolyphaseOversampling::kMinimumPhase);
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kDrive);
+  ramps.set_ramped(kTone);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_, int nb_channels_>
+ATKSD1DSP<DataType_, nb_channels_>::~ATKSD1DSP() {}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // silent inputs, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, nb_inputs, nFrames, get_tail_length()))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    for (int channel = 0; channel < nb_channels; ++channel)
+    {
+      inFilters[channel]->set_pointer(inputs[channel] + offset, size);
+      outFilters[channel]->set_pointer(outputs[channel] + offset, size);
+    }
+    endpoint.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::set_sampling_rate(int sampling_rate)
+{
+  this->sampling_rate = sampling_rate;
+  ramps.set_sampling_rate(sampling_rate);
+
+  for (int channel = 0; channel < nb_channels; ++channel)
+  {
+    inFilters[channel]->set_input_sampling_rate(sampling_rate);
+    inFilters[channel]->set_output_sampling_rate(sampling_rate);
+    highpassFilters[channel].set_input_sampling_rate(sampling_rate);
+    highpassFilters[channel].set_output_sampling_rate(sampling_rate);
+    outFilters[channel]->set_input_sampling_rate(sampling_rate);
+    outFilters[channel]->set_output_sampling_rate(sampling_rate);
+  }
+  for (int quality = 0; quality <= max_quality; ++quality)
+  {
+    OversamplingChain& oversampling = chains[quality];
+    int factor = 1 << quality;
+    oversampling.oversamplingFilter.set_input_sampling_rate(sampling_rate);
+    oversampling.oversamplingFilter.set_output_sampling_rate(sampling_rate * factor);
+    for (int channel = 0; channel < nb_channels; ++channel)
+    {
+      oversampling.overdriveFilters[channel].set_input_sampling_rate(sampling_rate * factor);
+      oversampling.overdriveFilters[channel].set_output_sampling_rate(sampling_rate * factor);
+    }
+    oversampling.clipperFilter.set_input_sampling_rate(sampling_rate * factor);
+    oversampling.clipperFilter.set_output_sampling_rate(sampling_rate * factor);
+    oversampling.decimationFilter.set_input_sampling_rate(sampling_rate * factor);
+    oversampling.decimationFilter.set_output_sampling_rate(sampling_rate);
+  }
+  prepare_chains();
+  toneFilter.set_input_sampling_rate(sampling_rate);
+  toneFilter.set_output_sampling_rate(sampling_rate);
+  volumeFilter.set_input_sampling_rate(sampling_rate);
+  volumeFilter.set_output_sampling_rate(sampling_rate);
+  endpoint.set_input_sampling_rate(sampling_rate);
+  endpoint.set_output_sampling_rate(sampling_rate);
+  drive = parameter_values[kDrive] / 100.;
+  chain = NULL;
+  select_chain();
+  volumeFilter.full_setup();
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_, int nb_channels_>
+double ATKSD1DSP<DataType_, nb_channels_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+  volumeFilter.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_, int nb_channels_>
+int64_t ATKSD1DSP<DataType_, nb_channels_>::get_tail_length() const
+{
+  // the resampling filters, then the 20 Hz highpass filter
+  double time_constant = 1 / (2 * 3.14159265358979323846 * 20);
+  return get_latency(phase) + static_cast<int64_t>(SilenceDetector<DataType>::decay_time(time_constant) * sampling_rate);
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::set_oversampling_filter_length(PolyphaseOversampling::FilterLength length)
+{
+  latencies[PolyphaseOversampling::kLinearPhase] = PolyphaseOversampling::get_latency(length, PolyphaseOversampling::kLinearPhase);
+  latencies[PolyphaseOversampling::kMinimumPhase] = PolyphaseOversampling::get_latency(length, PolyphaseOversampling::kMinimumPhase);
+  for (auto& oversampling : chains)
+  {
+    oversampling.oversamplingFilter.set_filter_length(length);
+    oversampling.decimationFilter.set_filter_length(length);
+    oversampling.decimationFilter.set_latency(get_latency(phase));
+  }
+  prepare_chains();
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::set_offline(bool offline)
+{
+  if (offline != this->offline)
+  {
+    this->offline = offline;
+    select_chain();
+  }
+}
+
+template<typename DataType_, int nb_channels_>
+int ATKSD1DSP<DataType_, nb_channels_>::get_oversampling_factor() const
+{
+  return oversampling_factor;
+}
+
+template<typename DataType_, int nb_channels_>
+int ATKSD1DSP<DataType_, nb_channels_>::get_latency(PolyphaseOversampling::FilterPhase phase) const
+{
+  return latencies[phase];
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::set_overdrive_solver(OverdriveSolver solver)
+{
+  overdrive_solver = solver;
+  for (auto& oversampling : chains)
+  {
+    oversampling.clipperFilter.set_tabulated(solver == kTableSolver);
+    for (int channel = 0; channel < nb_channels; ++channel)
+    {
+      if (solver == kATKSolver)
+      {
+        oversampling.decimationFilter.set_input_port(channel, &oversampling.overdriveFilters[channel], 0);
+      }
+      else
+      {
+        oversampling.decimationFilter.set_input_port(channel, &oversampling.clipperFilter, channel);
+      }
+    }
+  }
+}
+
+template<typename DataType_, int nb_channels_>
+typename ATKSD1DSP<DataType_, nb_channels_>::OverdriveSolver ATKSD1DSP<DataType_, nb_channels_>::get_overdrive_solver() const
+{
+  return overdrive_solver;
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::set_max_block_size(int max_block_size)
+{
+  this->max_block_size = max_block_size;
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::prepare_chains()
+{
+  // silence through both phases, the buffers of each filter grow to their largest size
+  std::vector<DataType> silent_block(max_block_size, 0);
+  for (int channel = 0; channel < nb_channels; ++channel)
+  {
+    inFilters[channel]->set_pointer(silent_block.data(), max_block_size);
+  }
+  for (int quality = 0; quality <= max_quality; ++quality)
+  {
+    OversamplingChain& oversampling = chains[quality];
+    int factor = 1 << quality;
+    for (int channel = 0; channel < nb_channels; ++channel)
+    {
+      oversampling.overdriveFilters[channel].full_setup();
+    }
+    oversampling.oversamplingFilter.full_setup();
+    oversampling.clipperFilter.full_setup();
+    oversampling.decimationFilter.full_setup();
+
+    if (max_block_size > 0)
+    {
+      const PolyphaseOversampling::FilterPhase phases[] = {PolyphaseOversampling::kLinearPhase, PolyphaseOversampling::kMinimumPhase};
+      for (auto warmed_phase : phases)
+      {
+        oversampling.oversamplingFilter.set_filter_phase(warmed_phase);
+        oversampling.decimationFilter.set_filter_phase(warmed_phase);
+        oversampling.decimationFilter.set_latency(get_latency(warmed_phase));
+        for (int channel = 0; channel < nb_channels; ++channel)
+        {
+          oversampling.overdriveFilters[channel].process(max_block_size * factor);
+        }
+        oversampling.clipperFilter.process(max_block_size * factor);
+        oversampling.decimationFilter.process(max_block_size);
+      }
+    }
+
+    oversampling.oversamplingFilter.set_filter_phase(phase);
+    oversampling.decimationFilter.set_filter_phase(phase);
+    oversampling.decimationFilter.set_latency(get_latency(phase));
+    oversampling.oversamplingFilter.reset_history();
+    oversampling.clipperFilter.reset_history();
+    oversampling.decimationFilter.reset_history();
+  }
+  for (int channel = 0; channel < nb_channels; ++channel)
+  {
+    inFilters[channel]->set_pointer(NULL, 0);
+  }
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::select_chain()
+{
+  int quality = offline ? max_quality : std::min(std::max(static_cast<int>(parameter_values[kQuality] + .5), 0), max_quality);
+  if (chain == &chains[quality])
+  {
+    return;
+  }
+  // the chain left idle keeps its buffers, its history is cleared when it is connected again
+  chain = &chains[quality];
+  oversampling_factor = 1 << quality;
+  for (int channel = 0; channel < nb_channels; ++channel)
+  {
+    chain->overdriveFilters[channel].set_drive(drive);
+  }
+  chain->clipperFilter.set_drive(drive);
+  chain->oversamplingFilter.reset_history();
+  chain->clipperFilter.reset_history();
+  chain->decimationFilter.reset_history();
+  for (int channel = 0; channel < nb_channels; ++channel)
+  {
+    toneFilter.set_input_port(channel, &chain->decimationFilter, channel);
+  }
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::update_phase()
+{
+  PolyphaseOversampling::FilterPhase phase = parameter_values[kResampling] >= .5 ? PolyphaseOversampling::kMinimumPhase : PolyphaseOversampling::kLinearPhase;
+  if (phase == this->phase)
+  {
+    return;
+  }
+  // both phases went through prepare_chains, the delay lines already have their capacity
+  this->phase = phase;
+  for (auto& oversampling : chains)
+  {
+    oversampling.oversamplingFilter.set_filter_phase(phase);
+    oversampling.decimationFilter.set_filter_phase(phase);
+    oversampling.decimationFilter.set_latency(get_latency(phase));
+  }
+  chain->oversamplingFilter.reset_history();
+  chain->decimationFilter.reset_history();
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, value);
+  }
+  else
+  {
+    apply_parameter(paramIdx, value);
+  }
+}
+
+template<typename DataType_, int nb_channels_>
+void ATKSD1DSP<DataType_, nb_channels_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+    case kDrive:
+      drive = value / 100.;
+      for (int channel = 0; channel < nb_channels; ++channel)
+      {
+        chain->overdriveFilters[channel].set_drive(drive);
+      }
+      chain->clipperFilter.set_drive(drive);
+      break;
+    case kTone:
+      toneFilter.set_tone((value + 100) / 200.);
+      break;
+    case kLevel:
+      volumeFilter.set_volume(value / 150.);
+      break;
+    case kQuality:
+      select_chain();
+      break;
+    case kResampling:
+      update_phase();
+      break;
+
+    default:
+      break;
+  }
+}
+
+template class ATKSD1DSP<float>;
+template class ATKSD1DSP<double>;
+template class ATKSD1DSP<float, 2>;
+template class ATKSD1DSP<double, 2>;
@@ -0,0 +1,143 @@
+#ifndef __ATKSD1DSP__
+#define __ATKSD1DSP__
+
+#include <memory>
+
+#include "../common/ControlRateRamps.h"
+#include "../common/ParameterInfo.h"
+#include "../common/ParameterQueue.h"
+#include "../common/SilenceDetector.h"
+#include "../common/SmoothedVolumeFilter.h"
+#include "PolyphaseOversampling.h"
+#include "SD1ClipperFilter.h"
+
+#include <ATK/Core/InPointerFilter.h>
+#include <ATK/Core/OutPointerFilter.h>
+#include <ATK/Core/PipelineGlobalSinkFilter.h>
+#include <ATK/EQ/IIRFilter.h>
+#include <ATK/EQ/SD1ToneFilter.h>
+#include <ATK/EQ/ChamberlinFilter.h>
+#include <ATK/Distortion/SD1OverdriveFilter.h>
+
+struct ATKSD1Parameters
+{
+  enum EParams
+  {
+    kDrive = 0,
+    kTone,
+    kLevel,
+    kQuality,
+    kResampling,
+    kNumParams
+  };
+
+  static const ParameterInfo parameters[kNumParams];
+};
+
+// GUI-free processing graph of ATKSD1, shared by the plugin and the offline tools
+// The channels share the parameters and go through the same multichannel filters
+template<typename DataType_, int nb_channels_ = 1>
+class ATKSD1DSP : public ATKSD1Parameters
+{
+public:
+  typedef DataType_ DataType;
+  static const int nb_channels = nb_channels_;
+
+  enum OverdriveSolver
+  {
+    kATKSolver = 0,
+    kNewtonSolver,
+    kTableSolver
+  };
+
+  static const int nb_inputs = nb_channels;
+  static const int nb_sidechain_inputs = 0;
+  static const int nb_outputs = nb_channels;
+
+  ATKSD1DSP();
+  ~ATKSD1DSP();
+
+  void set_sampling_rate(int sampling_rate);
+  void set_parameter(int paramIdx, double value);
+  double get_parameter(int paramIdx) const;
+  // Can be called from any thread, the value is applied at the start of the next process call
+  void post_parameter(int paramIdx, double value);
+  // Shape and duration of the ramps following a parameter change
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  // Samples for the output and the state of the graph to fall below the silence threshold once the input stops
+  int64_t get_tail_length() const;
+  // Length of the oversampling filters, trades the passband width for CPU. Not while processing
+  void set_oversampling_filter_length(PolyphaseOversampling::FilterLength length);
+  // Largest number of frames per process call, 0 (default) if unknown. Not while processing
+  // The next set_sampling_rate runs a silent block of that size through the filters of every
+  // oversampling factor and resampling phase, so that switching between them does not allocate
+  void set_max_block_size(int max_block_size);
+  // Offline renders run at the highest oversampling factor, whatever the Quality parameter
+  // Switches the oversampling chain like the Quality parameter does
+  void set_offline(bool offline);
+  int get_oversampling_factor() const;
+  // Latency in samples for the linear or minimum phase resampling filters (Resampling parameter)
+  // The lower oversampling factors are delayed to the latency of the highest one, so that it
+  // does not depend on the Quality parameter nor on offline rendering
+  int get_latency(PolyphaseOversampling::FilterPhase phase) const;
+  // Overdrive stage of ATK (default), or SD1ClipperFilter solving the same circuit with Newton
+  // iterations or reading its precomputed clipper table. Not while processing
+  void set_overdrive_solver(OverdriveSolver solver);
+  OverdriveSolver get_overdrive_solver() const;
+  void process(DataType** inputs, DataType** outputs, int nFrames);
+
+private:
+  // The filters running at one oversampling factor
+  struct OversamplingChain
+  {
+    OversamplingChain()
+      :oversamplingFilter(nb_channels), clipperFilter(nb_channels), decimationFilter(nb_channels)
+    {
+    }
+
+    PolyphaseOversamplingFilter<DataType> oversamplingFilter;
+    // the ATK overdrive filters are mono, one per channel
+    ATK::SD1OverdriveFilter<DataType> overdriveFilters[nb_channels];
+    SD1ClipperFilter<DataType> clipperFilter;
+    PolyphaseDecimationFilter<DataType> decimationFilter;
+  };
+
+  void apply_parameter(int paramIdx, double value);
+  // Connects the chain of the Quality parameter, or the highest one offline
+  void select_chain();
+  void update_phase();
+  // Allocates the buffers of all the chains for max_block_size, then clears their state
+  void prepare_chains();
+
+  double parameter_values[kNumParams];
+  ParameterQueue<kNumParams> parameter_queue;
+  ControlRateRamps<kNumParams> ramps;
+  SilenceDetector<DataType> silence;
+  int sampling_rate;
+  int max_block_size;
+  int oversampling_factor;
+  PolyphaseOversampling::FilterPhase phase;
+  // for each phase, computed with the filter length as the minimum phase ones are designed for it
+  int latencies[2];
+  bool offline;
+  OverdriveSolver overdrive_solver;
+  // ramped Drive, only applied to the connected chain
+  double drive;
+
+  std::unique_ptr<ATK::InPointerFilter<DataType> > inFilters[nb_channels];
+  // one chain for each Quality, from 1x to 32x, all set up but only the connected one processes
+  OversamplingChain chains[PolyphaseOversampling::max_nb_stages + 1];
+  OversamplingChain* chain;
+  ATK::IIRFilter<ATK::SD1ToneCoefficients<DataType> > toneFilter;
+  // the high pass filters are mono as well
+  ATK::ChamberlinFilter<DataType> highpassFilters[nb_channels];
+  SmoothedVolumeFilter<DataType> volumeFilter;
+  std::unique_ptr<ATK::OutPointerFilter<DataType> > outFilters[nb_channels];
+
+  ATK::PipelineGlobalSinkFilter endpoint;
+};
+
+template<typename DataType>
+using ATKSD1StereoDSP = ATKSD1DSP<DataType, 2>;
+
+#endif
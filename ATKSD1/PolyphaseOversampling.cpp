@@ -0,0 +1,627 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "PolyphaseOversampling.h"
+
+namespace
+{
+  const double pi = 3.14159265358979323846;
+  const double kaiser_beta = 8;
+  const double attenuation = 80;
+  // passband edges of the filter lengths, relative to the base sampling rate
+  const double passbands[] = {15 / 44.1, 18.5 / 44.1, 20.3 / 44.1};
+
+  // modified Bessel function of the first kind, order 0
+  double bessel_i0(double x)
+  {
+    double sum = 1;
+    double term = 1;
+    for (int k = 1; k < 50; ++k)
+    {
+      term *= (x / (2 * k)) * (x / (2 * k));
+      sum += term;
+    }
+    return sum;
+  }
+
+  // Number of 2x stages for a rate ratio, 0 if the rates are not set yet
+  // -1 if the ratio is not supported, which may only be transient while the rates are changed
+  int get_nb_stages(int high_rate, int low_rate)
+  {
+    if (high_rate == 0 || low_rate == 0)
+    {
+      return 0;
+    }
+    for (int nb_stages = 0; nb_stages <= PolyphaseOversampling::max_nb_stages; ++nb_stages)
+    {
+      if (high_rate == low_rate << nb_stages)
+      {
+        return nb_stages;
+      }
+    }
+    return -1;
+  }
+
+  void check_nb_stages(int nb_stages)
+  {
+    if (nb_stages < 0)
+    {
+      throw std::runtime_error("The sampling rates must differ by a power of two factor, up to 32");
+    }
+  }
+
+  // sum of q^(n * n + offset * n) * trigonometric(n) with alternating signs, until the terms vanish
+  template<typename Function>
+  double elliptic_series(double q, int first, int offset, int sign, Function trigonometric)
+  {
+    double sum = 0;
+    for (int n = first; n < 100; ++n, sign = -sign)
+    {
+      double term = std::pow(q, n * n + offset * n) * trigonometric(n) * sign;
+      sum += term;
+      if (std::abs(term) < 1e-100)
+      {
+        break;
+      }
+    }
+    return sum;
+  }
+
+  // all the stages are created up front, the sampling rates only select how many are used
+  // the stages of a channel are contiguous
+  template<typename DataType>
+  void create_stages(std::vector<HalfbandStage<DataType> >& stages, std::vector<AllpassHalfbandStage<DataType> >& allpass_stages,
+    int nb_channels, PolyphaseOversampling::FilterLength length)
+  {
+    stages.resize(nb_channels * PolyphaseOversampling::max_nb_stages);
+    allpass_stages.resize(nb_channels * PolyphaseOversampling::max_nb_stages);
+    for (std::size_t index = 0; index < stages.size(); ++index)
+    {
+      int stage = index % PolyphaseOversampling::max_nb_stages;
+      stages[index].set_nb_coefficients(PolyphaseOversampling::get_stage_length(length, stage));
+      allpass_stages[index].set_transition(PolyphaseOversampling::get_transition(length, stage));
+    }
+  }
+
+  // the whole block goes through a stage before the next one
+  template<typename Stage, typename DataType>
+  void upsample_cascade(Stage* stages, int nb_stages, const DataType* input, int64_t size, DataType* output, std::vector<DataType>* buffers)
+  {
+    const DataType* stage_input = input;
+    int64_t stage_size = size >> nb_stages;
+    for (int stage = 0; stage < nb_stages; ++stage)
+    {
+      DataType* stage_output = output;
+      if (stage != nb_stages - 1)
+      {
+        buffers[stage & 1].resize(2 * stage_size);
+        stage_output = buffers[stage & 1].data();
+      }
+      stages[stage].upsample(stage_input, stage_size, stage_output);
+      stage_input = stage_output;
+      stage_size *= 2;
+    }
+  }
+
+  // the highest rate stage comes first, stage 0 gives the output block
+  template<typename Stage, typename DataType>
+  void downsample_cascade(Stage* stages, int nb_stages, const DataType* input, int64_t size, DataType* output, std::vector<DataType>* buffers)
+  {
+    const DataType* stage_input = input;
+    int64_t stage_size = size << nb_stages;
+    for (int stage = nb_stages - 1; stage >= 0; --stage)
+    {
+      stage_size /= 2;
+      DataType* stage_output = output;
+      if (stage != 0)
+      {
+        buffers[stage & 1].resize(stage_size);
+        stage_output = buffers[stage & 1].data();
+      }
+      stages[stage].downsample(stage_input, stage_size, stage_output);
+      stage_input = stage_output;
+    }
+  }
+}
+
+int PolyphaseOversampling::get_stage_length(FilterLength length, int stage)
+{
+  static const int first_stage_lengths[] = {8, 16, 32};
+  if (stage == 0)
+  {
+    return first_stage_lengths[length];
+  }
+  // at 4x, the images of the passband start at 3/8 of the sampling rate
+  return stage == 1 && length != kShort ? 6 : 5;
+}
+
+std::vector<double> PolyphaseOversampling::design(int nb_coefficients)
+{
+  std::vector<double> coefficients(nb_coefficients);
+  // the window spans the 4 * nb_coefficients - 1 taps of the full filter
+  double half_length = 2 * nb_coefficients;
+  for (int j = 0; j < nb_coefficients; ++j)
+  {
+    double n = 2 * j + 1;
+    double window = bessel_i0(kaiser_beta * std::sqrt(1 - (n / half_length) * (n / half_length))) / bessel_i0(kaiser_beta);
+    coefficients[j] = std::sin(pi * n / 2) / (pi * n) * window;
+  }
+  return coefficients;
+}
+
+double PolyphaseOversampling::get_transition(FilterLength length, int stage)
+{
+  // from the passband edge to its mirror around the half-band center
+  return .5 - passbands[length] / (1 << stage);
+}
+
+std::vector<double> PolyphaseOversampling::design_allpass(double transition, double attenuation)
+{
+  // elliptic filter parameters, see Valenzuela and Constantinides, "Digital signal processing
+  // schemes for efficient interpolation and decimation", 1983
+  double k = std::tan((1 - 2 * transition) * pi / 4);
+  k *= k;
+  double root = std::pow(1 - k * k, .25);
+  double e = .5 * (1 - root) / (1 + root);
+  double e4 = e * e * e * e;
+  double q = e * (1 + e4 * (2 + e4 * (15 + 150 * e4)));
+
+  double power = std::pow(10., -attenuation / 10);
+  power /= 1 - power;
+  int order = static_cast<int>(std::ceil(std::log(power * power / 16) / std::log(q)));
+  order = std::max(order | 1, 3);
+
+  std::vector<double> coefficients((order - 1) / 2);
+  for (std::size_t index = 0; index < coefficients.size(); ++index)
+  {
+    double angle = (index + 1) * pi / order;
+    double numerator = elliptic_series(q, 0, 1, 1, [angle](int n) { return std::sin((2 * n + 1) * angle); }) * std::pow(q, .25);
+    double denominator = elliptic_series(q, 1, 0, -1, [angle](int n) { return std::cos(2 * n * angle); }) + .5;
+    double w = numerator / denominator;
+    double x = std::sqrt((1 - w * w * k) * (1 - w * w / k)) / (1 + w * w);
+    coefficients[index] = (1 - x) / (1 + x);
+  }
+  return coefficients;
+}
+
+double PolyphaseOversampling::get_delay(FilterLength length, FilterPhase phase, int nb_stages)
+{
+  double delay = 0;
+  for (int stage = 0; stage < nb_stages; ++stage)
+  {
+    // in samples of the higher sampling rate of the stage
+    double stage_delay = 2 * get_stage_length(length, stage) - 1;
+    if (phase == kMinimumPhase)
+    {
+      // a section a + z^-2 / 1 + a z^-2 delays the low frequencies by 2 (1 - a) / (1 + a), the
+      // output averages the two paths. The second path is one sample late when oversampling and
+      // read one sample early when decimating, so each filter gets half the delay of the sections
+      std::vector<double> coefficients = design_allpass(get_transition(length, stage), attenuation);
+      stage_delay = 0;
+      for (double coefficient : coefficients)
+      {
+        stage_delay += 2 * (1 - coefficient) / (1 + coefficient);
+      }
+      stage_delay /= 2;
+    }
+    delay += stage_delay / (2 << stage);
+  }
+  return delay;
+}
+
+int PolyphaseOversampling::get_latency(FilterLength length, FilterPhase phase)
+{
+  // the linear phase delays are multiples of 1 / 2^max_nb_stages, exact in double
+  return static_cast<int>(std::ceil(2 * get_delay(length, phase, max_nb_stages) - 1e-9));
+}
+
+template<typename DataType_>
+HalfbandStage<DataType_>::HalfbandStage()
+  :nb_coefficients(0)
+{
+}
+
+template<typename DataType_>
+void HalfbandStage<DataType_>::set_nb_coefficients(int nb_coefficients)
+{
+  this->nb_coefficients = nb_coefficients;
+  std::vector<double> design = PolyphaseOversampling::design(nb_coefficients);
+  coefficients.assign(design.begin(), design.end());
+  buffer.assign(2 * nb_coefficients - 1, 0);
+  odd_buffer.assign(nb_coefficients, 0);
+}
+
+template<typename DataType_>
+void HalfbandStage<DataType_>::reset()
+{
+  std::fill(buffer.begin(), buffer.end(), 0);
+  std::fill(odd_buffer.begin(), odd_buffer.end(), 0);
+}
+
+template<typename DataType_>
+void HalfbandStage<DataType_>::filter(const DataType* window, int64_t size, DataType* output) const
+{
+  // symmetric taps around the center of each 2 * nb_coefficients samples window, one
+  // coefficient at a time so that the consecutive outputs are independent and vectorized
+  for (int j = 0; j < nb_coefficients; ++j)
+  {
+    const DataType coefficient = coefficients[j];
+    const DataType* after = window + nb_coefficients + j;
+    const DataType* before = window + nb_coefficients - 1 - j;
+    for (int64_t i = 0; i < size; ++i)
+    {
+      output[i] += coefficient * (after[i] + before[i]);
+    }
+  }
+}
+
+template<typename DataType_>
+void HalfbandStage<DataType_>::keep_history(std::vector<DataType>& buffer, int64_t size, int history_size)
+{
+  std::copy(buffer.begin() + size, buffer.begin() + size + history_size, buffer.begin());
+}
+
+template<typename DataType_>
+void HalfbandStage<DataType_>::upsample(const DataType* input, int64_t size, DataType* output)
+{
+  const int history_size = 2 * nb_coefficients - 1;
+  if (buffer.size() < static_cast<std::size_t>(history_size + size))
+  {
+    buffer.resize(history_size + size);
+    filtered.resize(size);
+  }
+  std::copy(input, input + size, buffer.begin() + history_size);
+
+  std::fill(filtered.begin(), filtered.begin() + size, 0);
+  filter(buffer.data(), size, filtered.data());
+  for (int64_t i = 0; i < size; ++i)
+  {
+    // zero stuffing halves the gain, compensated here
+    output[2 * i] = 2 * filtered[i];
+    output[2 * i + 1] = buffer[i + nb_coefficients];
+  }
+  keep_history(buffer, size, history_size);
+}
+
+template<typename DataType_>
+void HalfbandStage<DataType_>::downsample(const DataType* input, int64_t size, DataType* output)
+{
+  const int history_size = 2 * nb_coefficients - 1;
+  if (buffer.size() < static_cast<std::size_t>(history_size + size))
+  {
+    buffer.resize(history_size + size);
+    odd_buffer.resize(nb_coefficients + size);
+  }
+  for (int64_t i = 0; i < size; ++i)
+  {
+    buffer[history_size + i] = input[2 * i];
+    odd_buffer[nb_coefficients + i] = input[2 * i + 1];
+  }
+
+  // the odd samples only go through the center tap
+  for (int64_t i = 0; i < size; ++i)
+  {
+    output[i] = static_cast<DataType>(.5) * odd_buffer[i];
+  }
+  filter(buffer.data(), size, output);
+  keep_history(buffer, size, history_size);
+  keep_history(odd_buffer, size, nb_coefficients);
+}
+
+template<typename DataType_>
+AllpassHalfbandStage<DataType_>::AllpassHalfbandStage()
+{
+}
+
+template<typename DataType_>
+void AllpassHalfbandStage<DataType_>::set_transition(double transition)
+{
+  std::vector<double> design = PolyphaseOversampling::design_allpass(transition, attenuation);
+  coefficients.assign(design.begin(), design.end());
+  last_inputs.assign(coefficients.size(), 0);
+  last_outputs.assign(coefficients.size(), 0);
+}
+
+template<typename DataType_>
+void AllpassHalfbandStage<DataType_>::reset()
+{
+  std::fill(last_inputs.begin(), last_inputs.end(), 0);
+  std::fill(last_outputs.begin(), last_outputs.end(), 0);
+}
+
+template<typename DataType_>
+void AllpassHalfbandStage<DataType_>::filter(DataType* paths)
+{
+  for (std::size_t section = 0; section < coefficients.size(); ++section)
+  {
+    DataType& sample = paths[section & 1];
+    DataType output = (sample - last_outputs[section]) * coefficients[section] + last_inputs[section];
+    last_inputs[section] = sample;
+    last_outputs[section] = output;
+    sample = output;
+  }
+}
+
+template<typename DataType_>
+void AllpassHalfbandStage<DataType_>::upsample(const DataType* input, int64_t size, DataType* output)
+{
+  for (int64_t i = 0; i < size; ++i)
+  {
+    DataType paths[2] = {input[i], input[i]};
+    filter(paths);
+    output[2 * i] = paths[0];
+    output[2 * i + 1] = paths[1];
+  }
+}
+
+template<typename DataType_>
+void AllpassHalfbandStage<DataType_>::downsample(const DataType* input, int64_t size, DataType* output)
+{
+  for (int64_t i = 0; i < size; ++i)
+  {
+    DataType paths[2] = {input[2 * i + 1], input[2 * i]};
+    filter(paths);
+    output[i] = static_cast<DataType>(.5) * (paths[0] + paths[1]);
+  }
+}
+
+template<typename DataType_>
+PolyphaseOversamplingFilter<DataType_>::PolyphaseOversamplingFilter(int nb_channels)
+  :Parent(nb_channels, nb_channels), length(PolyphaseOversampling::kLong), phase(PolyphaseOversampling::kLinearPhase), nb_stages(0)
+{
+  create_stages(stages, allpass_stages, nb_output_ports, length);
+}
+
+template<typename DataType_>
+PolyphaseOversamplingFilter<DataType_>::~PolyphaseOversamplingFilter() {}
+
+template<typename DataType_>
+void PolyphaseOversamplingFilter<DataType_>::set_filter_length(PolyphaseOversampling::FilterLength length)
+{
+  this->length = length;
+  create_stages(stages, allpass_stages, nb_output_ports, length);
+}
+
+template<typename DataType_>
+PolyphaseOversampling::FilterLength PolyphaseOversamplingFilter<DataType_>::get_filter_length() const
+{
+  return length;
+}
+
+template<typename DataType_>
+void PolyphaseOversamplingFilter<DataType_>::set_filter_phase(PolyphaseOversampling::FilterPhase phase)
+{
+  this->phase = phase;
+}
+
+template<typename DataType_>
+PolyphaseOversampling::FilterPhase PolyphaseOversamplingFilter<DataType_>::get_filter_phase() const
+{
+  return phase;
+}
+
+template<typename DataType_>
+double PolyphaseOversamplingFilter<DataType_>::get_delay() const
+{
+  return PolyphaseOversampling::get_delay(length, phase, nb_stages);
+}
+
+template<typename DataType_>
+void PolyphaseOversamplingFilter<DataType_>::full_setup()
+{
+  Parent::full_setup();
+  reset_history();
+}
+
+template<typename DataType_>
+void PolyphaseOversamplingFilter<DataType_>::reset_history()
+{
+  for (auto& stage : stages)
+  {
+    stage.reset();
+  }
+  for (auto& stage : allpass_stages)
+  {
+    stage.reset();
+  }
+}
+
+template<typename DataType_>
+void PolyphaseOversamplingFilter<DataType_>::setup()
+{
+  Parent::setup();
+  nb_stages = get_nb_stages(this->get_output_sampling_rate(), this->get_input_sampling_rate());
+}
+
+template<typename DataType_>
+void PolyphaseOversamplingFilter<DataType_>::process_impl(int64_t size) const
+{
+  check_nb_stages(nb_stages);
+
+  for (int channel = 0; channel < nb_output_ports; ++channel)
+  {
+    const DataType* input = converted_inputs[channel];
+    DataType* output = outputs[channel];
+    if (nb_stages == 0)
+    {
+      std::copy(input, input + size, output);
+    }
+    else if (phase == PolyphaseOversampling::kLinearPhase)
+    {
+      upsample_cascade(&stages[channel * PolyphaseOversampling::max_nb_stages], nb_stages, input, size, output, buffers);
+    }
+    else
+    {
+      upsample_cascade(&allpass_stages[channel * PolyphaseOversampling::max_nb_stages], nb_stages, input, size, output, buffers);
+    }
+  }
+}
+
+template<typename DataType_>
+PolyphaseDecimationFilter<DataType_>::PolyphaseDecimationFilter(int nb_channels)
+  :Parent(nb_channels, nb_channels), length(PolyphaseOversampling::kLong), phase(PolyphaseOversampling::kLinearPhase), nb_stages(0),
+  latency(0), extra_delay(0), delay_buffers(nb_channels)
+{
+  create_stages(stages, allpass_stages, nb_output_ports, length);
+  update_stage_delays();
+}
+
+template<typename DataType_>
+PolyphaseDecimationFilter<DataType_>::~PolyphaseDecimationFilter() {}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::set_filter_length(PolyphaseOversampling::FilterLength length)
+{
+  this->length = length;
+  create_stages(stages, allpass_stages, nb_output_ports, length);
+  update_stage_delays();
+  update_extra_delay();
+}
+
+template<typename DataType_>
+PolyphaseOversampling::FilterLength PolyphaseDecimationFilter<DataType_>::get_filter_length() const
+{
+  return length;
+}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::set_filter_phase(PolyphaseOversampling::FilterPhase phase)
+{
+  this->phase = phase;
+  update_extra_delay();
+}
+
+template<typename DataType_>
+PolyphaseOversampling::FilterPhase PolyphaseDecimationFilter<DataType_>::get_filter_phase() const
+{
+  return phase;
+}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::set_latency(int latency)
+{
+  this->latency = latency;
+  update_extra_delay();
+}
+
+template<typename DataType_>
+int PolyphaseDecimationFilter<DataType_>::get_latency() const
+{
+  return latency;
+}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::update_stage_delays()
+{
+  stage_delays[PolyphaseOversampling::kLinearPhase] = PolyphaseOversampling::get_delay(length, PolyphaseOversampling::kLinearPhase, nb_stages);
+  stage_delays[PolyphaseOversampling::kMinimumPhase] = PolyphaseOversampling::get_delay(length, PolyphaseOversampling::kMinimumPhase, nb_stages);
+}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::update_extra_delay()
+{
+  int delay = 0;
+  if (latency > 0 && nb_stages >= 0)
+  {
+    // the oversampling filter has the same delay as this one
+    delay = static_cast<int>(std::lround((latency - 2 * stage_delays[phase]) * (1 << nb_stages)));
+    delay = std::max(delay, 0);
+  }
+  if (delay != extra_delay)
+  {
+    extra_delay = delay;
+    for (auto& buffer : delay_buffers)
+    {
+      buffer.assign(extra_delay, 0);
+    }
+  }
+}
+
+template<typename DataType_>
+double PolyphaseDecimationFilter<DataType_>::get_delay() const
+{
+  return stage_delays[phase] + extra_delay / static_cast<double>(1 << std::max(nb_stages, 0));
+}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::full_setup()
+{
+  Parent::full_setup();
+  reset_history();
+}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::reset_history()
+{
+  for (auto& stage : stages)
+  {
+    stage.reset();
+  }
+  for (auto& stage : allpass_stages)
+  {
+    stage.reset();
+  }
+  for (auto& buffer : delay_buffers)
+  {
+    std::fill(buffer.begin(), buffer.end(), 0);
+  }
+}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::setup()
+{
+  Parent::setup();
+  nb_stages = get_nb_stages(this->get_input_sampling_rate(), this->get_output_sampling_rate());
+  update_stage_delays();
+  update_extra_delay();
+}
+
+template<typename DataType_>
+void PolyphaseDecimationFilter<DataType_>::process_impl(int64_t size) const
+{
+  check_nb_stages(nb_stages);
+
+  const int64_t input_size = size << nb_stages;
+
+  for (int channel = 0; channel < nb_output_ports; ++channel)
+  {
+    const DataType* input = converted_inputs[channel];
+    DataType* output = outputs[channel];
+    if (extra_delay > 0)
+    {
+      std::vector<DataType>& buffer = delay_buffers[channel];
+      buffer.resize(extra_delay + input_size);
+      std::copy(input, input + input_size, buffer.begin() + extra_delay);
+      input = buffer.data();
+    }
+
+    if (nb_stages == 0)
+    {
+      std::copy(input, input + size, output);
+    }
+    else if (phase == PolyphaseOversampling::kLinearPhase)
+    {
+      downsample_cascade(&stages[channel * PolyphaseOversampling::max_nb_stages], nb_stages, input, size, output, buffers);
+    }
+    else
+    {
+      downsample_cascade(&allpass_stages[channel * PolyphaseOversampling::max_nb_stages], nb_stages, input, size, output, buffers);
+    }
+
+    if (extra_delay > 0)
+    {
+      std::vector<DataType>& buffer = delay_buffers[channel];
+      std::copy(buffer.begin() + input_size, buffer.begin() + input_size + extra_delay, buffer.begin());
+    }
+  }
+}
+
+template class HalfbandStage<float>;
+template class HalfbandStage<double>;
+template class AllpassHalfbandStage<float>;
+template class AllpassHalfbandStage<double>;
+template class PolyphaseOversamplingFilter<float>;
+template class PolyphaseOversamplingFilter<double>;
+template class PolyphaseDecimationFilter<float>;
+template class PolyphaseDecimationFilter<double>;
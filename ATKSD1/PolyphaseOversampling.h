@@ -0,0 +1,214 @@
+#ifndef __PolyphaseOversampling__
+#define __PolyphaseOversampling__
+
+#include <cstdint>
+#include <vector>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+// Half-band FIR cascades changing the sampling rate by a power of two (up to 32), 2x per stage
+// Every other coefficient of a half-band filter is zero and the center one is 0.5, so the
+// upsampler only filters one of its two output phases and the downsampler only computes the
+// samples it keeps. The stage next to the base rate has the sharpest filter, the higher ones
+// only have to reject images far from the audio band
+// All the filters attenuate by 80 dB beyond the mirror of their passband edge, the length sets
+// the passband: about 15 kHz (short), 18.5 kHz (medium) or 20.3 kHz (long) at 44.1 kHz
+// The linear phase stages are FIR filters, the minimum phase ones polyphase IIR filters (two
+// paths of allpass sections) with the same passbands, much shorter delays but phase distortion
+struct PolyphaseOversampling
+{
+  enum FilterLength
+  {
+    kShort = 0,
+    kMedium,
+    kLong
+  };
+
+  enum FilterPhase
+  {
+    kLinearPhase = 0,
+    kMinimumPhase
+  };
+
+  static const int max_nb_stages = 5;
+
+  // Number of distinct coefficients of a stage, stage 0 runs next to the base sampling rate
+  static int get_stage_length(FilterLength length, int stage);
+  // Kaiser windowed half-band, the nb_coefficients odd taps on one side of the center
+  static std::vector<double> design(int nb_coefficients);
+
+  // Width of the transition band of a minimum phase stage, relative to its higher sampling rate
+  static double get_transition(FilterLength length, int stage);
+  // Elliptic polyphase half-band, the coefficients of the allpass sections alternate between
+  // the two paths. The order is the lowest one reaching the attenuation (in dB)
+  static std::vector<double> design_allpass(double transition, double attenuation);
+
+  // Delay of nb_stages stages in samples of the base sampling rate, exact for the linear phase
+  // filters, the group delay at low frequencies for the minimum phase ones
+  static double get_delay(FilterLength length, FilterPhase phase, int nb_stages);
+  // Smallest whole number of samples at the base sampling rate covering the delay of an
+  // oversampling cascade followed by a decimation cascade, whatever their factor
+  static int get_latency(FilterLength length, FilterPhase phase);
+};
+
+// One 2x half-band stage, in the direction given by the function called
+// Blocks are copied after the stage history so that the filter windows never wrap
+template<typename DataType_>
+class HalfbandStage
+{
+public:
+  typedef DataType_ DataType;
+
+  HalfbandStage();
+
+  void set_nb_coefficients(int nb_coefficients);
+  void reset();
+
+  // size input samples in, 2 * size output samples out
+  void upsample(const DataType* input, int64_t size, DataType* output);
+  // 2 * size input samples in, size output samples out
+  void downsample(const DataType* input, int64_t size, DataType* output);
+
+private:
+  // Adds the filtered blocks to output
+  void filter(const DataType* window, int64_t size, DataType* output) const;
+  void keep_history(std::vector<DataType>& buffer, int64_t size, int history_size);
+
+  int nb_coefficients;
+  std::vector<DataType> coefficients;
+  // history of the filtered samples, then the current block
+  std::vector<DataType> buffer;
+  // downsampling only, the odd samples delayed to line up with the filtered ones
+  std::vector<DataType> odd_buffer;
+  // upsampling only, the filtered phase before it is interleaved
+  std::vector<DataType> filtered;
+};
+
+// One 2x minimum phase half-band stage, same interface as HalfbandStage
+// Both paths run at the lower sampling rate, each one giving a phase of the higher rate signal
+template<typename DataType_>
+class AllpassHalfbandStage
+{
+public:
+  typedef DataType_ DataType;
+
+  AllpassHalfbandStage();
+
+  void set_transition(double transition);
+  void reset();
+
+  void upsample(const DataType* input, int64_t size, DataType* output);
+  void downsample(const DataType* input, int64_t size, DataType* output);
+
+private:
+  // Runs the two paths on one sample each
+  void filter(DataType* paths);
+
+  std::vector<DataType> coefficients;
+  // last input and output of each allpass section
+  std::vector<DataType> last_inputs;
+  std::vector<DataType> last_outputs;
+};
+
+// Replaces ATK::OversamplingFilter followed by the anti-imaging low pass
+// The oversampling factor is the ratio of the output and input sampling rates
+template<typename DataType_>
+class PolyphaseOversamplingFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+  using Parent::nb_output_ports;
+
+public:
+  PolyphaseOversamplingFilter(int nb_channels = 1);
+  ~PolyphaseOversamplingFilter();
+
+  // Not to be changed while processing
+  void set_filter_length(PolyphaseOversampling::FilterLength length);
+  PolyphaseOversampling::FilterLength get_filter_length() const;
+  // Both kinds of stages always exist, the phase can be changed before a full_setup()
+  void set_filter_phase(PolyphaseOversampling::FilterPhase phase);
+  PolyphaseOversampling::FilterPhase get_filter_phase() const;
+  // Group delay in samples at the input sampling rate
+  double get_delay() const;
+
+  void full_setup();
+  // Clears the stage histories but keeps the buffers, can be called while processing
+  void reset_history();
+
+protected:
+  void setup();
+  void process_impl(int64_t size) const;
+
+private:
+  PolyphaseOversampling::FilterLength length;
+  PolyphaseOversampling::FilterPhase phase;
+  int nb_stages;
+  // max_nb_stages per channel, for each phase
+  mutable std::vector<HalfbandStage<DataType> > stages;
+  mutable std::vector<AllpassHalfbandStage<DataType> > allpass_stages;
+  mutable std::vector<DataType> buffers[2];
+};
+
+// Replaces the anti-aliasing low pass followed by ATK::DecimationFilter
+// The decimation factor is the ratio of the input and output sampling rates
+template<typename DataType_>
+class PolyphaseDecimationFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+  using Parent::nb_output_ports;
+
+public:
+  PolyphaseDecimationFilter(int nb_channels = 1);
+  ~PolyphaseDecimationFilter();
+
+  // Not to be changed while processing
+  void set_filter_length(PolyphaseOversampling::FilterLength length);
+  PolyphaseOversampling::FilterLength get_filter_length() const;
+  // Both kinds of stages always exist, the phase can be changed before a full_setup()
+  void set_filter_phase(PolyphaseOversampling::FilterPhase phase);
+  PolyphaseOversampling::FilterPhase get_filter_phase() const;
+  // Delays the input so that a PolyphaseOversamplingFilter with the same settings followed by
+  // this filter delay by latency samples of the output sampling rate, whatever the factor
+  // At least PolyphaseOversampling::get_latency(), 0 adds no delay. Not while processing
+  void set_latency(int latency);
+  int get_latency() const;
+  // Group delay in samples at the output sampling rate, including the delay added for the latency
+  double get_delay() const;
+
+  void full_setup();
+  // Clears the stage histories and the delay line but keeps the buffers, can be called while processing
+  void reset_history();
+
+protected:
+  void setup();
+  void process_impl(int64_t size) const;
+
+private:
+  void update_stage_delays();
+  void update_extra_delay();
+
+  PolyphaseOversampling::FilterLength length;
+  PolyphaseOversampling::FilterPhase phase;
+  int nb_stages;
+  // max_nb_stages per channel, for each phase
+  mutable std::vector<HalfbandStage<DataType> > stages;
+  mutable std::vector<AllpassHalfbandStage<DataType> > allpass_stages;
+  mutable std::vector<DataType> buffers[2];
+  // delay of the nb_stages stages for each phase, the minimum phase ones are designed to compute it
+  double stage_delays[2];
+  int latency;
+  // in samples of the input sampling rate
+  int extra_delay;
+  // for each channel, the last extra_delay input samples then the current block
+  mutable std::vector<std::vector<DataType> > delay_buffers;
+};
+
+#endif
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cmath>
+
+#include "SD1ClipperFilter.h"
+
+namespace
+{
+  // component values of the SD1 schematic
+  const double branch_resistor = 4.7e3;
+  const double branch_capacitor = .047e-6;
+  const double drive_resistor = 51e3;
+  const double drive_potentiometer = 500e3;
+  const double feedback_capacitor_value = 51e-12;
+  const double saturation_current = 1e-12;
+  const double thermal_voltage = 26e-3;
+
+  const double min_sampling_rate = 8000;
+  const double max_sampling_rate = 6.4e6;
+  const double min_conductance = SD1ClipperTable<double>::get_conductance(1, min_sampling_rate);
+  const double max_conductance = SD1ClipperTable<double>::get_conductance(0, max_sampling_rate);
+
+  // one diode in one direction, two in series in the other one
+  double diodes(double voltage)
+  {
+    return saturation_current * (std::exp(voltage / thermal_voltage) - std::exp(-voltage / (2 * thermal_voltage)));
+  }
+
+  double diodes_derivative(double voltage)
+  {
+    return saturation_current / thermal_voltage * (std::exp(voltage / thermal_voltage) + .5 * std::exp(-voltage / (2 * thermal_voltage)));
+  }
+
+  double get_row_position(double conductance)
+  {
+    double position = std::log(conductance / min_conductance) / std::log(max_conductance / min_conductance) * (SD1ClipperTable<double>::nb_rows - 1);
+    return std::min(std::max(position, 0.), SD1ClipperTable<double>::nb_rows - 1.);
+  }
+
+  // solutions for all the rows, against value = current / conductance
+  // built by the first table, layout of SD1ClipperTable::row
+  const std::vector<double>& get_surface()
+  {
+    static const std::vector<double> surface = []()
+    {
+      typedef SD1ClipperTable<double> Table;
+      std::vector<double> surface(Table::nb_rows * 2 * (Table::nb_nodes + 1));
+      for (int row = 0; row < Table::nb_rows; ++row)
+      {
+        double conductance = min_conductance * std::pow(max_conductance / min_conductance, row / (Table::nb_rows - 1.));
+        for (int sign = 0; sign < 2; ++sign)
+        {
+          double* voltages = &surface[(row * 2 + sign) * (Table::nb_nodes + 1)];
+          double voltage = 0;
+          for (int i = 0; i < Table::nb_nodes; ++i)
+          {
+            double mantissa = 1 + static_cast<double>(i & ((1 << Table::segments_bits) - 1)) / (1 << Table::segments_bits);
+            double value = std::ldexp(sign ? -mantissa : mantissa, Table::min_exponent + (i >> Table::segments_bits));
+            voltage = Table::solve(value * conductance, conductance, voltage);
+            voltages[i] = voltage;
+          }
+          voltages[Table::nb_nodes] = voltages[Table::nb_nodes - 1];
+        }
+      }
+      return surface;
+    }();
+    return surface;
+  }
+}
+
+template<typename DataType_>
+SD1ClipperTable<DataType_>::SD1ClipperTable()
+  :row(2 * (nb_nodes + 1))
+{
+  get_surface();
+  set_conductance(min_conductance);
+}
+
+template<typename DataType_>
+double SD1ClipperTable<DataType_>::get_conductance(double drive, double sampling_rate)
+{
+  return 1 / (drive_resistor + drive * drive_potentiometer) + 2 * feedback_capacitor_value * sampling_rate;
+}
+
+template<typename DataType_>
+double SD1ClipperTable<DataType_>::solve(double current, double conductance, double guess)
+{
+  double voltage = guess;
+  for (int i = 0; i < 200; ++i)
+  {
+    double error = conductance * voltage + diodes(voltage) - current;
+    double step = error / (conductance + diodes_derivative(voltage));
+    // the exponentials make the full steps overshoot from far away
+    step = std::min(std::max(step, -.1), .1);
+    voltage -= step;
+    if (std::abs(step) < 1e-12)
+    {
+      break;
+    }
+  }
+  return voltage;
+}
+
+template<typename DataType_>
+void SD1ClipperTable<DataType_>::set_conductance(double conductance)
+{
+  const std::vector<double>& surface = get_surface();
+  double position = get_row_position(conductance);
+  int index = std::min(static_cast<int>(position), nb_rows - 2);
+  double fraction = position - index;
+
+  const double* lower = &surface[index * row.size()];
+  const double* upper = lower + row.size();
+  for (std::size_t i = 0; i < row.size(); ++i)
+  {
+    row[i] = static_cast<DataType>(lower[i] + fraction * (upper[i] - lower[i]));
+  }
+  inv_conductance = static_cast<DataType>(1 / conductance);
+  // below the first node, v is proportional to current / conductance
+  low_slopes[0] = static_cast<DataType>(row[0] / min_value);
+  low_slopes[1] = static_cast<DataType>(-row[nb_nodes + 1] / min_value);
+}
+
+template<typename DataType_>
+SD1ClipperFilter<DataType_>::SD1ClipperFilter(int nb_channels)
+  :Parent(nb_channels, nb_channels), drive(0), tabulated(false), branch_conductance(0), branch_step(0), feedback_capacitor(0), conductance(min_conductance),
+  states(nb_channels)
+{
+}
+
+template<typename DataType_>
+SD1ClipperFilter<DataType_>::~SD1ClipperFilter() {}
+
+template<typename DataType_>
+void SD1ClipperFilter<DataType_>::set_drive(DataType drive)
+{
+  this->drive = drive;
+  update_conductance();
+}
+
+template<typename DataType_>
+typename SD1ClipperFilter<DataType_>::DataType SD1ClipperFilter<DataType_>::get_drive() const
+{
+  return drive;
+}
+
+template<typename DataType_>
+void SD1ClipperFilter<DataType_>::set_tabulated(bool tabulated)
+{
+  this->tabulated = tabulated;
+  update_conductance();
+}
+
+template<typename DataType_>
+bool SD1ClipperFilter<DataType_>::is_tabulated() const
+{
+  return tabulated;
+}
+
+template<typename DataType_>
+void SD1ClipperFilter<DataType_>::full_setup()
+{
+  Parent::full_setup();
+  reset_history();
+}
+
+template<typename DataType_>
+void SD1ClipperFilter<DataType_>::reset_history()
+{
+  std::fill(states.begin(), states.end(), State());
+}
+
+template<typename DataType_>
+void SD1ClipperFilter<DataType_>::setup()
+{
+  Parent::setup();
+  double dt = 1. / this->get_input_sampling_rate();
+  branch_step = static_cast<DataType>(dt / (2 * branch_capacitor));
+  branch_conductance = static_cast<DataType>(1 / (branch_resistor + dt / (2 * branch_capacitor)));
+  feedback_capacitor = static_cast<DataType>(2 * feedback_capacitor_value / dt);
+  update_conductance();
+}
+
+template<typename DataType_>
+void SD1ClipperFilter<DataType_>::update_conductance()
+{
+  conductance = SD1ClipperTable<DataType>::get_conductance(drive, this->get_input_sampling_rate());
+  if (tabulated)
+  {
+    table.set_conductance(conductance);
+  }
+}
+
+template<typename DataType_>
+void SD1ClipperFilter<DataType_>::process_impl(int64_t size) const
+{
+  if (tabulated)
+  {
+    process_channels<true>(size);
+  }
+  else
+  {
+    process_channels<false>(size);
+  }
+}
+
+template<typename DataType_>
+template<bool Tabulated>
+void SD1ClipperFilter<DataType_>::process_channels(int64_t size) const
+{
+  // the channels go by groups of 4 or 2 in lockstep, so that the compiler can put them in the
+  // lanes of the same vector registers (AVX or SSE2), the recursion of a channel being too serial
+  int channel = 0;
+  for (; channel + 4 <= nb_output_ports; channel += 4)
+  {
+    process_lanes<Tabulated, 4>(channel, size);
+  }
+  for (; channel + 2 <= nb_output_ports; channel += 2)
+  {
+    process_lanes<Tabulated, 2>(channel, size);
+  }
+  if (channel < nb_output_ports)
+  {
+    process_lanes<Tabulated, 1>(channel, size);
+  }
+}
+
+template<typename DataType_>
+template<bool Tabulated, int Lanes>
+void SD1ClipperFilter<DataType_>::process_lanes(int first_channel, int64_t size) const
+{
+  const DataType* input[Lanes];
+  DataType* output[Lanes];
+  DataType branch_voltage[Lanes];
+  DataType branch_current[Lanes];
+  DataType feedback_voltage[Lanes];
+  DataType feedback_current[Lanes];
+  for (int lane = 0; lane < Lanes; ++lane)
+  {
+    input[lane] = converted_inputs[first_channel + lane];
+    output[lane] = outputs[first_channel + lane];
+    const State& state = states[first_channel + lane];
+    branch_voltage[lane] = state.branch_voltage;
+    branch_current[lane] = state.branch_current;
+    feedback_voltage[lane] = state.feedback_voltage;
+    feedback_current[lane] = state.feedback_current;
+  }
+
+  for (int64_t i = 0; i < size; ++i)
+  {
+    DataType clipper_current[Lanes];
+    for (int lane = 0; lane < Lanes; ++lane)
+    {
+      // the op-amp keeps the input voltage on the R-C branch, its current flows in the feedback loop
+      DataType current = (input[lane][i] - branch_voltage[lane] - branch_step * branch_current[lane]) * branch_conductance;
+      branch_voltage[lane] += branch_step * (current + branch_current[lane]);
+      branch_current[lane] = current;
+      clipper_current[lane] = current + feedback_capacitor * feedback_voltage[lane] + feedback_current[lane];
+    }
+
+    DataType voltage[Lanes];
+    for (int lane = 0; lane < Lanes; ++lane)
+    {
+      voltage[lane] = Tabulated ? table.get_voltage(clipper_current[lane])
+        : static_cast<DataType>(SD1ClipperTable<DataType>::solve(clipper_current[lane], conductance, feedback_voltage[lane]));
+    }
+
+    for (int lane = 0; lane < Lanes; ++lane)
+    {
+      feedback_current[lane] = feedback_capacitor * (voltage[lane] - feedback_voltage[lane]) - feedback_current[lane];
+      feedback_voltage[lane] = voltage[lane];
+      output[lane][i] = input[lane][i] + voltage[lane];
+    }
+  }
+
+  for (int lane = 0; lane < Lanes; ++lane)
+  {
+    State& state = states[first_channel + lane];
+    state.branch_voltage = branch_voltage[lane];
+    state.branch_current = branch_current[lane];
+    state.feedback_voltage = feedback_voltage[lane];
+    state.feedback_current = feedback_current[lane];
+  }
+}
+
+template class SD1ClipperTable<float>;
+template class SD1ClipperTable<double>;
+template class SD1ClipperFilter<float>;
+template class SD1ClipperFilter<double>;
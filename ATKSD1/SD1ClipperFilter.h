@@ -0,0 +1,137 @@
+#ifndef __SD1ClipperFilter__
+#define __SD1ClipperFilter__
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+// Solution of the nonlinear equation of the SD1 clipper, conductance * v + diodes(v) = current,
+// where v is the voltage across the feedback loop and the conductance combines the drive resistor
+// and the discretized feedback capacitor (so it depends on the drive and on the sampling rate)
+// The solution is precomputed once for 32 conductances, log spaced over all the drives and the
+// sampling rates from 8 kHz to 6.4 MHz, against current / conductance indexed by the bits of its
+// magnitude as a float (64 segments per octave from 1/64 V to 4096 V, linear below)
+// set_conductance() interpolates the row of a conductance, get_voltage() interpolates in the row
+template<typename DataType_>
+class SD1ClipperTable
+{
+public:
+  typedef DataType_ DataType;
+
+  SD1ClipperTable();
+
+  // Conductance of the equation for a drive (from 0 to 1) and a sampling rate
+  static double get_conductance(double drive, double sampling_rate);
+  // Reference Newton solver, starting from guess
+  static double solve(double current, double conductance, double guess);
+
+  void set_conductance(double conductance);
+
+  // Tabulated solution for the last conductance
+  DataType get_voltage(DataType current) const
+  {
+    DataType value = current * inv_conductance;
+    int sign = value < 0;
+    DataType magnitude = sign ? -value : value;
+    if (magnitude < static_cast<DataType>(min_value))
+    {
+      return value * low_slopes[sign];
+    }
+    // the comparison also sends NaN to the last entry
+    magnitude = magnitude < static_cast<DataType>(max_value) ? magnitude : static_cast<DataType>(max_value);
+    float single = static_cast<float>(magnitude);
+    uint32_t bits;
+    std::memcpy(&bits, &single, sizeof(bits));
+
+    uint32_t position = bits - min_bits;
+    uint32_t index = position >> fraction_bits;
+    DataType fraction = static_cast<DataType>(position & fraction_mask) * static_cast<DataType>(1. / (1 << fraction_bits));
+    const DataType* voltages = &row[sign * (nb_nodes + 1)];
+    return voltages[index] + fraction * (voltages[index + 1] - voltages[index]);
+  }
+
+  static const int segments_bits = 6;
+  static const int fraction_bits = 23 - segments_bits;
+  static const uint32_t fraction_mask = (uint32_t(1) << fraction_bits) - 1;
+  static const int min_exponent = -6;
+  static const int max_exponent = 12;
+  static const int nb_nodes = ((max_exponent - min_exponent) << segments_bits) + 1;
+  static const uint32_t min_bits = uint32_t(127 + min_exponent) << 23;
+  static const int nb_rows = 32;
+
+  static constexpr double min_value = 1. / (1 << -min_exponent);
+  static constexpr double max_value = 1 << max_exponent;
+
+private:
+  // positive then negative values, each with a last node read as the upper end of the clamped values
+  std::vector<DataType> row;
+  DataType inv_conductance;
+  DataType low_slopes[2];
+};
+
+// SD1 overdrive stage (op-amp with the drive resistor, the feedback capacitor and the asymmetric
+// diodes in its feedback loop, R-C branch to the ground), discretized with the trapezoidal rule
+// Same drive convention as ATK::SD1OverdriveFilter, from 0 to 1. The clipper equation is solved
+// by Newton iterations, or read from a SD1ClipperTable shared by the channels
+template<typename DataType_>
+class SD1ClipperFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+  using Parent::nb_output_ports;
+
+public:
+  SD1ClipperFilter(int nb_channels = 1);
+  ~SD1ClipperFilter();
+
+  void set_drive(DataType drive);
+  DataType get_drive() const;
+  void set_tabulated(bool tabulated);
+  bool is_tabulated() const;
+
+  void full_setup();
+  // Clears the capacitor states, can be called while processing
+  void reset_history();
+
+protected:
+  void setup();
+  void process_impl(int64_t size) const;
+
+private:
+  template<bool Tabulated>
+  void process_channels(int64_t size) const;
+  template<bool Tabulated, int Lanes>
+  void process_lanes(int first_channel, int64_t size) const;
+  void update_conductance();
+
+  DataType drive;
+  bool tabulated;
+
+  DataType branch_conductance; // R-C branch to the ground
+  DataType branch_step; // dt / 2C of the branch capacitor
+  DataType feedback_capacitor; // 2C / dt of the feedback capacitor
+  double conductance; // of the clipper equation
+  SD1ClipperTable<DataType> table;
+
+  // capacitor voltages and currents of the previous sample
+  struct State
+  {
+    DataType branch_voltage;
+    DataType branch_current;
+    DataType feedback_voltage;
+    DataType feedback_current;
+
+    State()
+      :branch_voltage(0), branch_current(0), feedback_voltage(0), feedback_current(0)
+    {
+    }
+  };
+  mutable std::vector<State> states;
+};
+
+#endif
@@ -43,10 +43,11 @@
 instrument determined by PLUG _IS _INST
 */
 
-#define PLUG_CHANNEL_IO "1-1"
+#define PLUG_CHANNEL_IO "1-1 2-2"
 
-// Should be retrieved from ATK when the time comes
-#define PLUG_LATENCY 3
+// Latency of the default long linear phase resampling filters, ATKSD1::UpdateLatency() reports the
+// latency of the selected ones
+#define PLUG_LATENCY 73
 #define PLUG_IS_INST 0
 
 // if this is 0 RTAS can't get tempo info
@@ -0,0 +1,531 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ATKSideChainCompressorDSP.h"
+
+const ParameterInfo ATKSideChainCompressorParameters::parameters[kNumParams] =
+{
+  {"Middle/Side processing", 0, 0, 1, 1, "", 1, true, NULL},
+  {"Link channels", 0, 0, 1, 1, "", 1, true, NULL},
+  {"Enable Channel 1", 1, 0, 1, 1, "", 1, true, NULL},
+  {"Enable Channel 2", 1, 0, 1, 1, "", 1, true, NULL},
+  {"Attack ch1", 10., 1., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Release ch1", 10, 1., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Threshold ch1", 0., -40., 0.0, 0.1, "dB", 2., false, NULL}, // threshold is actually power
+  {"Ratio ch1", 2., .1, 100, .1, "-", 2., false, NULL},
+  {"Softness ch1", -2, -4, 0, 0.1, "-", 2., false, NULL},
+  {"Makeup Gain ch1", 0, 0, 40, 0.1, "-", 2., false, NULL}, // Makeup is expressed in amplitude
+  {"Attack ch2", 10., 1., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Release ch2", 10, 1., 100.0, 0.1, "ms", 2., false, NULL},
+  {"Threshold ch2", 0., -40., 0.0, 0.1, "dB", 2., false, NULL}, // threshold is actually power
+  {"Ratio ch2", 2., .1, 100, .1, "-", 2., false, NULL},
+  {"Softness ch2", -2, -4, 0, 0.1, "-", 2., false, NULL},
+  {"Makeup Gain ch2", 0, 0, 40, 0.1, "-", 2., false, NULL}, // Makeup is expressed in amplitude
+  {"Dry/Wet", 1, 0, 1, 0.01, "-", 1., false, NULL}
+};
+
+template<typename DataType_>
+ATKSideChainCompressorDSP<DataType_>::ATKSideChainCompressorDSP()
+  :fused(true), tabulated(false), background_build(false), sidechain_connected(true),
+  inLFilter(nullptr, 1, 0, false), inRFilter(nullptr, 1, 0, false), inSideChainLFilter(nullptr, 1, 0, false), inSideChainRFilter(nullptr, 1, 0, false),
+  volumesplitFilter(2), sidechainvolumesplitFilter(2), volumemergeFilter(2), drywetFilter(2), fusedFilter(true), outLFilter(nullptr, 1, 0, false), outRFilter(nullptr, 1, 0, false)
+{
+  volumesplitFilter.set_volume(std::sqrt(.5));
+  sidechainvolumesplitFilter.set_volume(std::sqrt(.5));
+  volumemergeFilter.set_volume(std::sqrt(.5));
+  endpoint.add_filter(&outLFilter);
+  endpoint.add_filter(&outRFilter);
+
+  powerFilter1.set_input_port(0, &inSideChainLFilter, 0);
+  gainCompressorFilter1.set_input_port(0, &powerFilter1, 0);
+  attackReleaseFilter1.set_input_port(0, &gainCompressorFilter1, 0);
+  applyGainFilter1.set_input_port(0, &attackReleaseFilter1, 0);
+  applyGainFilter1.set_input_port(1, &inLFilter, 0);
+  makeupFilter1.set_input_port(0, &applyGainFilter1, 0);
+  drywetFilter.set_input_port(0, &makeupFilter1, 0);
+  drywetFilter.set_input_port(1, &inLFilter, 0);
+
+  powerFilter2.set_input_port(0, &inSideChainRFilter, 0);
+  gainCompressorFilter2.set_input_port(0, &powerFilter2, 0);
+  attackReleaseFilter2.set_input_port(0, &gainCompressorFilter2, 0);
+  applyGainFilter2.set_input_port(0, &attackReleaseFilter2, 0);
+  applyGainFilter2.set_input_port(1, &inRFilter, 0);
+  makeupFilter2.set_input_port(0, &applyGainFilter2, 0);
+  drywetFilter.set_input_port(2, &makeupFilter2, 0);
+  drywetFilter.set_input_port(3, &inRFilter, 0);
+
+  middlesidesplitFilter.set_input_port(0, &inLFilter, 0);
+  middlesidesplitFilter.set_input_port(1, &inRFilter, 0);
+  sidechainmiddlesidesplitFilter.set_input_port(0, &inSideChainLFilter, 0);
+  sidechainmiddlesidesplitFilter.set_input_port(1, &inSideChainRFilter, 0);
+  volumesplitFilter.set_input_port(0, &middlesidesplitFilter, 0);
+  volumesplitFilter.set_input_port(1, &middlesidesplitFilter, 1);
+  sidechainvolumesplitFilter.set_input_port(0, &sidechainmiddlesidesplitFilter, 0);
+  sidechainvolumesplitFilter.set_input_port(1, &sidechainmiddlesidesplitFilter, 1);
+  middlesidemergeFilter.set_input_port(0, &makeupFilter1, 0);
+  middlesidemergeFilter.set_input_port(1, &makeupFilter2, 0);
+  volumemergeFilter.set_input_port(0, &middlesidemergeFilter, 0);
+  volumemergeFilter.set_input_port(1, &middlesidemergeFilter, 1);
+  sumFilter.set_input_port(0, &powerFilter1, 0);
+  sumFilter.set_input_port(1, &powerFilter2, 0);
+
+  fusedFilter.set_input_port(0, &inLFilter, 0);
+  fusedFilter.set_input_port(1, &inRFilter, 0);
+  fusedFilter.set_input_port(2, &inSideChainLFilter, 0);
+  fusedFilter.set_input_port(3, &inSideChainRFilter, 0);
+  outLFilter.set_input_port(0, &fusedFilter, 0);
+  outRFilter.set_input_port(0, &fusedFilter, 1);
+
+  powerFilter1.set_memory(0);
+  powerFilter2.set_memory(0);
+  fusedFilter.set_memory(0);
+
+  nodes = {
+    {"inLFilter", &inLFilter},
+    {"inRFilter", &inRFilter},
+    {"inSideChainLFilter", &inSideChainLFilter},
+    {"inSideChainRFilter", &inSideChainRFilter},
+    {"middlesidesplitFilter", &middlesidesplitFilter},
+    {"sidechainmiddlesidesplitFilter", &sidechainmiddlesidesplitFilter},
+    {"volumesplitFilter", &volumesplitFilter},
+    {"sidechainvolumesplitFilter", &sidechainvolumesplitFilter},
+    {"powerFilter1", &powerFilter1},
+    {"powerFilter2", &powerFilter2},
+    {"sumFilter", &sumFilter},
+    {"attackReleaseFilter1", &attackReleaseFilter1},
+    {"attackReleaseFilter2", &attackReleaseFilter2},
+    {"gainCompressorFilter1", &gainCompressorFilter1},
+    {"gainCompressorFilter2", &gainCompressorFilter2},
+    {"applyGainFilter1", &applyGainFilter1},
+    {"applyGainFilter2", &applyGainFilter2},
+    {"makeupFilter1", &makeupFilter1},
+    {"makeupFilter2", &makeupFilter2},
+    {"middlesidemergeFilter", &middlesidemergeFilter},
+    {"volumemergeFilter", &volumemergeFilter},
+    {"drywetFilter", &drywetFilter},
+    {"fusedFilter", &fusedFilter},
+    {"outLFilter", &outLFilter},
+    {"outRFilter", &outRFilter}
+  };
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kThreshold1);
+  ramps.set_ramped(kRatio1);
+  ramps.set_ramped(kSoftness1);
+  ramps.set_ramped(kThreshold2);
+  ramps.set_ramped(kRatio2);
+  ramps.set_ramped(kSoftness2);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_>
+ATKSideChainCompressorDSP<DataType_>::~ATKSideChainCompressorDSP() {}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // inputs silent even after the makeup gain, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, sidechain_connected ? nb_inputs : nb_inputs - nb_sidechain_inputs, nFrames, get_tail_length(), std::pow(10., std::max(parameter_values[kMakeup1], parameter_values[kMakeup2]) / 20)))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    if (sidechain_connected)
+    {
+      inSideChainLFilter.set_pointer(inputs[2] + offset, size);
+      inSideChainRFilter.set_pointer(inputs[3] + offset, size);
+    }
+    inLFilter.set_pointer(inputs[0] + offset, size);
+    outLFilter.set_pointer(outputs[0] + offset, size);
+    inRFilter.set_pointer(inputs[1] + offset, size);
+    outRFilter.set_pointer(outputs[1] + offset, size);
+    endpoint.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::set_sampling_rate(int sampling_rate)
+{
+  ramps.set_sampling_rate(sampling_rate);
+
+  if (sampling_rate != endpoint.get_input_sampling_rate())
+  {
+    inLFilter.set_input_sampling_rate(sampling_rate);
+    inLFilter.set_output_sampling_rate(sampling_rate);
+    inRFilter.set_input_sampling_rate(sampling_rate);
+    inRFilter.set_output_sampling_rate(sampling_rate);
+    inSideChainLFilter.set_input_sampling_rate(sampling_rate);
+    inSideChainLFilter.set_output_sampling_rate(sampling_rate);
+    inSideChainRFilter.set_input_sampling_rate(sampling_rate);
+    inSideChainRFilter.set_output_sampling_rate(sampling_rate);
+    outLFilter.set_input_sampling_rate(sampling_rate);
+    outLFilter.set_output_sampling_rate(sampling_rate);
+    outRFilter.set_input_sampling_rate(sampling_rate);
+    outRFilter.set_output_sampling_rate(sampling_rate);
+
+    middlesidesplitFilter.set_input_sampling_rate(sampling_rate);
+    middlesidesplitFilter.set_output_sampling_rate(sampling_rate);
+    sidechainmiddlesidesplitFilter.set_input_sampling_rate(sampling_rate);
+    sidechainmiddlesidesplitFilter.set_output_sampling_rate(sampling_rate);
+    volumesplitFilter.set_input_sampling_rate(sampling_rate);
+    volumesplitFilter.set_output_sampling_rate(sampling_rate);
+    sidechainvolumesplitFilter.set_input_sampling_rate(sampling_rate);
+    sidechainvolumesplitFilter.set_output_sampling_rate(sampling_rate);
+    middlesidemergeFilter.set_input_sampling_rate(sampling_rate);
+    middlesidemergeFilter.set_output_sampling_rate(sampling_rate);
+    volumemergeFilter.set_input_sampling_rate(sampling_rate);
+    volumemergeFilter.set_output_sampling_rate(sampling_rate);
+    sumFilter.set_input_sampling_rate(sampling_rate);
+    sumFilter.set_output_sampling_rate(sampling_rate);
+
+    powerFilter1.set_input_sampling_rate(sampling_rate);
+    powerFilter1.set_output_sampling_rate(sampling_rate);
+    attackReleaseFilter1.set_input_sampling_rate(sampling_rate);
+    attackReleaseFilter1.set_output_sampling_rate(sampling_rate);
+    gainCompressorFilter1.set_input_sampling_rate(sampling_rate);
+    gainCompressorFilter1.set_output_sampling_rate(sampling_rate);
+    makeupFilter1.set_input_sampling_rate(sampling_rate);
+    makeupFilter1.set_output_sampling_rate(sampling_rate);
+
+    powerFilter2.set_input_sampling_rate(sampling_rate);
+    powerFilter2.set_output_sampling_rate(sampling_rate);
+    attackReleaseFilter2.set_input_sampling_rate(sampling_rate);
+    attackReleaseFilter2.set_output_sampling_rate(sampling_rate);
+    gainCompressorFilter2.set_input_sampling_rate(sampling_rate);
+    gainCompressorFilter2.set_output_sampling_rate(sampling_rate);
+    makeupFilter2.set_input_sampling_rate(sampling_rate);
+    makeupFilter2.set_output_sampling_rate(sampling_rate);
+
+    applyGainFilter1.set_input_sampling_rate(sampling_rate);
+    applyGainFilter1.set_output_sampling_rate(sampling_rate);
+    applyGainFilter2.set_input_sampling_rate(sampling_rate);
+    applyGainFilter2.set_output_sampling_rate(sampling_rate);
+    drywetFilter.set_input_sampling_rate(sampling_rate);
+    drywetFilter.set_output_sampling_rate(sampling_rate);
+    fusedFilter.set_input_sampling_rate(sampling_rate);
+    fusedFilter.set_output_sampling_rate(sampling_rate);
+    endpoint.set_input_sampling_rate(sampling_rate);
+    endpoint.set_output_sampling_rate(sampling_rate);
+
+    attackReleaseFilter1.set_release(std::exp(-1 / (parameter_values[kAttack1] * 1e-3 * sampling_rate))); // in ms
+    attackReleaseFilter1.set_attack(std::exp(-1 / (parameter_values[kRelease1] * 1e-3 * sampling_rate))); // in ms
+    attackReleaseFilter2.set_release(std::exp(-1 / (parameter_values[kAttack2] * 1e-3 * sampling_rate))); // in ms
+    attackReleaseFilter2.set_attack(std::exp(-1 / (parameter_values[kRelease2] * 1e-3 * sampling_rate))); // in ms
+    fusedFilter.set_release(0, std::exp(-1 / (parameter_values[kAttack1] * 1e-3 * sampling_rate))); // in ms
+    fusedFilter.set_attack(0, std::exp(-1 / (parameter_values[kRelease1] * 1e-3 * sampling_rate))); // in ms
+    fusedFilter.set_release(1, std::exp(-1 / (parameter_values[kAttack2] * 1e-3 * sampling_rate))); // in ms
+    fusedFilter.set_attack(1, std::exp(-1 / (parameter_values[kRelease2] * 1e-3 * sampling_rate))); // in ms
+  }
+  attackReleaseFilter1.full_setup();
+  attackReleaseFilter2.full_setup();
+  makeupFilter1.full_setup();
+  makeupFilter2.full_setup();
+  drywetFilter.full_setup();
+  fusedFilter.full_setup();
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_>
+double ATKSideChainCompressorDSP<DataType_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+  makeupFilter1.set_smoothing(mode, time_ms);
+  makeupFilter2.set_smoothing(mode, time_ms);
+  drywetFilter.set_smoothing(mode, time_ms);
+  fusedFilter.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_>
+int64_t ATKSideChainCompressorDSP<DataType_>::get_tail_length() const
+{
+  // the attack and release filters of a channel decay one after the other
+  double time_constant = std::max(parameter_values[kAttack1] + parameter_values[kRelease1], parameter_values[kAttack2] + parameter_values[kRelease2]) / 1000.;
+  return static_cast<int64_t>(SilenceDetector<DataType>::decay_time(time_constant) * endpoint.get_input_sampling_rate());
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::set_fused_kernel(bool fused)
+{
+  this->fused = fused;
+  if (fused)
+  {
+    outLFilter.set_input_port(0, &fusedFilter, 0);
+    outRFilter.set_input_port(0, &fusedFilter, 1);
+  }
+  else
+  {
+    outLFilter.set_input_port(0, &drywetFilter, 0);
+    outRFilter.set_input_port(0, &drywetFilter, 1);
+  }
+  rewire_graph();
+  set_gain_curve_table(tabulated, background_build);
+}
+
+template<typename DataType_>
+bool ATKSideChainCompressorDSP<DataType_>::is_fused_kernel() const
+{
+  return fused;
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::set_gain_curve_table(bool tabulated, bool background_build)
+{
+  this->tabulated = tabulated;
+  this->background_build = background_build;
+  // only the kernel that processes keeps its tables up to date
+  gainCompressorFilter1.set_tabulated(tabulated && !fused, background_build);
+  gainCompressorFilter2.set_tabulated(tabulated && !fused, background_build);
+  fusedFilter.set_tabulated(tabulated && fused, background_build);
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::set_routing_crossfade(double time_ms)
+{
+  fusedFilter.set_routing_crossfade(time_ms);
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::set_sidechain_connected(bool connected)
+{
+  if (connected != sidechain_connected)
+  {
+    sidechain_connected = connected;
+    fusedFilter.set_sidechain(connected);
+    rewire_graph();
+  }
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::rewire_graph()
+{
+  // without a side chain, nothing pulls the side chain filters
+  fusedFilter.set_input_port(2, sidechain_connected ? &inSideChainLFilter : &inLFilter, 0);
+  fusedFilter.set_input_port(3, sidechain_connected ? &inSideChainRFilter : &inRFilter, 0);
+
+  // the fused kernel switches between its routings by itself
+  if (fused)
+  {
+    return;
+  }
+
+  bool middleside = parameter_values[kMiddleside] > .5;
+  bool linked = parameter_values[kLinkChannels] > .5;
+  bool enabled1 = parameter_values[kActivateChannel1] > .5;
+  bool enabled2 = parameter_values[kActivateChannel2] > .5;
+
+  // without a side chain, the channels are detected on the signals they process
+  if (middleside)
+  {
+    powerFilter1.set_input_port(0, sidechain_connected ? &sidechainvolumesplitFilter : &volumesplitFilter, 0);
+    powerFilter2.set_input_port(0, sidechain_connected ? &sidechainvolumesplitFilter : &volumesplitFilter, 1);
+    applyGainFilter1.set_input_port(1, &volumesplitFilter, 0);
+    applyGainFilter2.set_input_port(1, &volumesplitFilter, 1);
+    drywetFilter.set_input_port(0, &volumemergeFilter, 0);
+    drywetFilter.set_input_port(2, &volumemergeFilter, 1);
+  }
+  else
+  {
+    powerFilter1.set_input_port(0, sidechain_connected ? &inSideChainLFilter : &inLFilter, 0);
+    powerFilter2.set_input_port(0, sidechain_connected ? &inSideChainRFilter : &inRFilter, 0);
+    applyGainFilter1.set_input_port(1, &inLFilter, 0);
+    applyGainFilter2.set_input_port(1, &inRFilter, 0);
+    if (enabled1)
+    {
+      drywetFilter.set_input_port(0, &makeupFilter1, 0);
+    }
+    else
+    {
+      drywetFilter.set_input_port(0, &inLFilter, 0);
+    }
+    if (enabled2)
+    {
+      drywetFilter.set_input_port(2, &makeupFilter2, 0);
+    }
+    else
+    {
+      drywetFilter.set_input_port(2, &inRFilter, 0);
+    }
+  }
+
+  if (enabled1)
+  {
+    middlesidemergeFilter.set_input_port(0, &makeupFilter1, 0);
+  }
+  else
+  {
+    middlesidemergeFilter.set_input_port(0, &volumesplitFilter, 0);
+  }
+  if (enabled2)
+  {
+    middlesidemergeFilter.set_input_port(1, &makeupFilter2, 0);
+  }
+  else
+  {
+    middlesidemergeFilter.set_input_port(1, &volumesplitFilter, 1);
+  }
+
+  if (linked)
+  {
+    gainCompressorFilter1.set_input_port(0, &sumFilter, 0);
+    applyGainFilter2.set_input_port(0, &attackReleaseFilter1, 0);
+  }
+  else
+  {
+    gainCompressorFilter1.set_input_port(0, &powerFilter1, 0);
+    applyGainFilter2.set_input_port(0, &attackReleaseFilter2, 0);
+  }
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, value);
+  }
+  else
+  {
+    apply_parameter(paramIdx, value);
+  }
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+  case kMiddleside:
+    fusedFilter.set_middleside(value > .5);
+    rewire_graph();
+    break;
+  case kLinkChannels:
+    fusedFilter.set_linked(value > .5);
+    makeupFilter2.set_volume_db(parameter_values[value > .5 ? kMakeup1 : kMakeup2]);
+    fusedFilter.set_volume_db(1, parameter_values[value > .5 ? kMakeup1 : kMakeup2]);
+    rewire_graph();
+    break;
+  case kActivateChannel1:
+    fusedFilter.set_enabled(0, value > .5);
+    rewire_graph();
+    break;
+  case kActivateChannel2:
+    fusedFilter.set_enabled(1, value > .5);
+    rewire_graph();
+    break;
+
+  case kThreshold1:
+    gainCompressorFilter1.set_threshold(std::pow(10, value / 10));
+    fusedFilter.set_threshold(0, std::pow(10, value / 10));
+    break;
+  case kRatio1:
+    gainCompressorFilter1.set_ratio(value);
+    fusedFilter.set_ratio(0, value);
+    break;
+  case kSoftness1:
+    gainCompressorFilter1.set_softness(std::pow(10, value));
+    fusedFilter.set_softness(0, std::pow(10, value));
+    break;
+  case kAttack1:
+    attackReleaseFilter1.set_release(std::exp(-1 / (value * 1e-3 * endpoint.get_input_sampling_rate()))); // in ms
+    fusedFilter.set_release(0, std::exp(-1 / (value * 1e-3 * endpoint.get_input_sampling_rate()))); // in ms
+    break;
+  case kRelease1:
+    attackReleaseFilter1.set_attack(std::exp(-1 / (value * 1e-3 * endpoint.get_input_sampling_rate()))); // in ms
+    fusedFilter.set_attack(0, std::exp(-1 / (value * 1e-3 * endpoint.get_input_sampling_rate()))); // in ms
+    break;
+  case kMakeup1:
+    makeupFilter1.set_volume_db(value);
+    fusedFilter.set_volume_db(0, value);
+    if (parameter_values[kLinkChannels] > .5)
+    {
+      makeupFilter2.set_volume_db(value);
+      fusedFilter.set_volume_db(1, value);
+    }
+    break;
+  case kThreshold2:
+    gainCompressorFilter2.set_threshold(std::pow(10, value / 10));
+    fusedFilter.set_threshold(1, std::pow(10, value / 10));
+    break;
+  case kRatio2:
+    gainCompressorFilter2.set_ratio(value);
+    fusedFilter.set_ratio(1, value);
+    break;
+  case kSoftness2:
+    gainCompressorFilter2.set_softness(std::pow(10, value));
+    fusedFilter.set_softness(1, std::pow(10, value));
+    break;
+  case kAttack2:
+    attackReleaseFilter2.set_release(std::exp(-1 / (value * 1e-3 * endpoint.get_input_sampling_rate()))); // in ms
+    fusedFilter.set_release(1, std::exp(-1 / (value * 1e-3 * endpoint.get_input_sampling_rate()))); // in ms
+    break;
+  case kRelease2:
+    attackReleaseFilter2.set_attack(std::exp(-1 / (value * 1e-3 * endpoint.get_input_sampling_rate()))); // in ms
+    fusedFilter.set_attack(1, std::exp(-1 / (value * 1e-3 * endpoint.get_input_sampling_rate()))); // in ms
+    break;
+  case kMakeup2:
+    makeupFilter2.set_volume_db(value);
+    fusedFilter.set_volume_db(1, value);
+    break;
+  case kDryWet:
+    drywetFilter.set_dry(value);
+    fusedFilter.set_dry(value);
+    break;
+
+  default:
+    break;
+  }
+}
+
+template<typename DataType_>
+std::vector<std::pair<std::string, int64_t> > ATKSideChainCompressorDSP<DataType_>::get_node_runs() const
+{
+  std::vector<std::pair<std::string, int64_t> > runs;
+  for (const auto& node : nodes)
+  {
+    runs.push_back(std::make_pair(node.first, node.second->get_nb_runs()));
+  }
+  return runs;
+}
+
+template<typename DataType_>
+void ATKSideChainCompressorDSP<DataType_>::reset_node_runs()
+{
+  for (const auto& node : nodes)
+  {
+    node.second->reset_nb_runs();
+  }
+}
+
+template class ATKSideChainCompressorDSP<float>;
+template class ATKSideChainCompressorDSP<double>;
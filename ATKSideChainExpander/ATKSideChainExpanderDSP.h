@@ -0,0 +1,135 @@
+#ifndef __ATKSideChainExpanderDSP__
+#define __ATKSideChainExpanderDSP__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../common/ControlRateRamps.h"
+#include "../common/CountedFilter.h"
+#include "../common/ParameterInfo.h"
+#include "../common/ParameterQueue.h"
+#include "../common/SilenceDetector.h"
+#include "../common/SmoothedDryWetFilter.h"
+#include "../common/SmoothedVolumeFilter.h"
+
+#include <ATK/Core/InPointerFilter.h>
+#include <ATK/Core/OutPointerFilter.h>
+#include <ATK/Core/PipelineGlobalSinkFilter.h>
+
+#include <ATK/Dynamic/AttackReleaseFilter.h>
+#include <ATK/Dynamic/GainExpanderFilter.h>
+#include <ATK/Dynamic/PowerFilter.h>
+
+#include <ATK/Tools/ApplyGainFilter.h>
+#include <ATK/Tools/MSFilter.h>
+#include <ATK/Tools/SumFilter.h>
+#include <ATK/Tools/VolumeFilter.h>
+
+struct ATKSideChainExpanderParameters
+{
+  enum EParams
+  {
+    kMiddleside = 0,
+    kLinkChannels,
+    kActivateChannel1,
+    kActivateChannel2,
+    kAttack1,
+    kRelease1,
+    kThreshold1,
+    kRatio1,
+    kSoftness1,
+    kMakeup1,
+    kAttack2,
+    kRelease2,
+    kThreshold2,
+    kRatio2,
+    kSoftness2,
+    kMakeup2,
+    kDryWet,
+    kNumParams
+  };
+
+  static const ParameterInfo parameters[kNumParams];
+};
+
+// GUI-free processing graph of ATKSideChainExpander, shared by the plugin and the offline tools
+template<typename DataType_>
+class ATKSideChainExpanderDSP : public ATKSideChainExpanderParameters
+{
+public:
+  typedef DataType_ DataType;
+
+  static const int nb_inputs = 4;
+  static const int nb_sidechain_inputs = 2;
+  static const int nb_outputs = 2;
+
+  ATKSideChainExpanderDSP();
+  ~ATKSideChainExpanderDSP();
+
+  void set_sampling_rate(int sampling_rate);
+  void set_parameter(int paramIdx, double value);
+  double get_parameter(int paramIdx) const;
+  // Can be called from any thread, the value is applied at the start of the next process call
+  void post_parameter(int paramIdx, double value);
+  // Shape and duration of the ramps following a parameter change
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  // Samples for the output and the state of the graph to fall below the silence threshold once the input stops
+  int64_t get_tail_length() const;
+  // Without a side chain (the default is connected), the channels are detected on the main inputs
+  // and inputs[2] and inputs[3] are not read. The graph is only rewired when the connection
+  // changes, so the plugin can pass the host's connection state before each process call
+  void set_sidechain_connected(bool connected);
+  void process(DataType** inputs, DataType** outputs, int nFrames);
+  // Blocks processed by each filter of the graph since the last reset, 0 for the filters that the
+  // routing parameters disconnect from the outputs
+  std::vector<std::pair<std::string, int64_t> > get_node_runs() const;
+  void reset_node_runs();
+
+private:
+  void apply_parameter(int paramIdx, double value);
+  // Connects the filters of the graph for the current routing parameters and side chain
+  void rewire_graph();
+
+  double parameter_values[kNumParams];
+  ParameterQueue<kNumParams> parameter_queue;
+  ControlRateRamps<kNumParams> ramps;
+  SilenceDetector<DataType> silence;
+  bool sidechain_connected;
+
+  CountedFilter<ATK::InPointerFilter<DataType> > inLFilter;
+  CountedFilter<ATK::InPointerFilter<DataType> > inRFilter;
+  CountedFilter<ATK::InPointerFilter<DataType> > inSideChainLFilter;
+  CountedFilter<ATK::InPointerFilter<DataType> > inSideChainRFilter;
+
+  CountedFilter<ATK::MiddleSideFilter<DataType> > middlesidesplitFilter;
+  CountedFilter<ATK::MiddleSideFilter<DataType> > sidechainmiddlesidesplitFilter;
+  CountedFilter<ATK::VolumeFilter<DataType> > volumesplitFilter;
+  CountedFilter<ATK::VolumeFilter<DataType> > sidechainvolumesplitFilter;
+
+  CountedFilter<ATK::PowerFilter<DataType> > powerFilter1;
+  CountedFilter<ATK::PowerFilter<DataType> > powerFilter2;
+  CountedFilter<ATK::SumFilter<DataType> > sumFilter; // in case we link both channels
+
+  CountedFilter<ATK::AttackReleaseFilter<DataType> > attackReleaseFilter1;
+  CountedFilter<ATK::AttackReleaseFilter<DataType> > attackReleaseFilter2;
+  CountedFilter<ATK::GainExpanderFilter<DataType> > gainExpanderFilter1;
+  CountedFilter<ATK::GainExpanderFilter<DataType> > gainExpanderFilter2;
+  CountedFilter<ATK::ApplyGainFilter<DataType> > applyGainFilter1;
+  CountedFilter<ATK::ApplyGainFilter<DataType> > applyGainFilter2;
+  CountedFilter<SmoothedVolumeFilter<DataType> > makeupFilter1;
+  CountedFilter<SmoothedVolumeFilter<DataType> > makeupFilter2;
+
+  CountedFilter<ATK::MiddleSideFilter<DataType> > middlesidemergeFilter;
+  CountedFilter<ATK::VolumeFilter<DataType> > volumemergeFilter;
+
+  CountedFilter<SmoothedDryWetFilter<DataType> > drywetFilter;
+
+  CountedFilter<ATK::OutPointerFilter<DataType> > outLFilter;
+  CountedFilter<ATK::OutPointerFilter<DataType> > outRFilter;
+
+  ATK::PipelineGlobalSinkFilter endpoint;
+  std::vector<std::pair<const char*, RunCounter*> > nodes;
+};
+
+#endif
@@ -2,14 +2,9 @@
 #include "IPlug_include_in_plug_src.h"
 #include "IControl.h"
 #include "resource.h"
+#include "../common/IPlugParameters.h"
 
-const int kNumPrograms = 1;
-
-enum EParams
-{
-  kModulation = 0,
-  kNumParams
-};
+const int kNumPrograms = 3;
 
 enum ELayout
 {
@@ -22,13 +17,11 @@ enum ELayout
 };
 
 ATKStereoPhaser::ATKStereoPhaser(IPlugInstanceInfo instanceInfo)
-: IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), inFilter(nullptr, 1, 0, false), applyGainFilter(2), out1Filter(nullptr, 1, 0, false), out2Filter(nullptr, 1, 0, false)
+: IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), tail_length(-1)
 {
   TRACE;
 
-  //arguments are: name, defaultVal, minVal, maxVal, step, label
-  GetParam(kModulation)->InitDouble("Modulation", 1, 0., 100.0, 0.1, "Hz");
-  GetParam(kModulation)->SetShape(2.);
+  InitParameters(this, parameters, kNumParams);
 
   IGraphics* pGraphics = MakeGraphics(this, kWidth, kHeight);
   pGraphics->AttachBackground(STEREOPHASER_ID, STEREOPHASER_FN);
@@ -39,56 +32,9 @@ ATKStereoPhaser::ATKStereoPhaser(IPlugInstanceInfo instanceInfo)
 
   AttachGraphics(pGraphics);
 
-  //MakePreset("preset 1", ... );
-  MakeDefaultPreset((char *) "-", kNumPrograms);
-
-  allpass1Filter.set_input_port(0, &inFilter, 0);
-  allpass2Filter.set_input_port(0, &inFilter, 0);
-  applyGainFilter.set_input_port(0, &allpass1Filter, 0);
-  applyGainFilter.set_input_port(1, &sinusFilter, 1);
-  applyGainFilter.set_input_port(2, &allpass2Filter, 0);
-  applyGainFilter.set_input_port(3, &sinusFilter, 0);
-  volumeFilter.set_input_port(0, &applyGainFilter, 1);
-  sum1Filter.set_input_port(0, &applyGainFilter, 0);
-  sum1Filter.set_input_port(1, &volumeFilter, 0);
-  sum2Filter.set_input_port(0, &applyGainFilter, 0);
-  sum2Filter.set_input_port(1, &applyGainFilter, 1);
-  out1Filter.set_input_port(0, &sum1Filter, 0);
-  out2Filter.set_input_port(0, &sum2Filter, 0);
-  sinkFilter.add_filter(&out1Filter);
-  sinkFilter.add_filter(&out2Filter);
-
-  volumeFilter.set_volume(-1);
-  std::vector<double> coeffs;
-  coeffs.push_back(1);
-  coeffs.push_back(0);
-  coeffs.push_back(1.3313);
-  coeffs.push_back(0);
-  coeffs.push_back(0.3855);
-  coeffs.push_back(0);
-  allpass1Filter.set_coefficients_in(coeffs);
-  coeffs.clear();
-  coeffs.push_back(-0.3855);
-  coeffs.push_back(0);
-  coeffs.push_back(-1.3313);
-  coeffs.push_back(0);
-  allpass1Filter.set_coefficients_out(coeffs);
-  coeffs.clear();
-
-  coeffs.push_back(1);
-  coeffs.push_back(0);
-  coeffs.push_back(0.8335);
-  coeffs.push_back(0);
-  coeffs.push_back(0.0947);
-  coeffs.push_back(0);
-  allpass2Filter.set_coefficients_in(coeffs);
-  coeffs.clear();
-  coeffs.push_back(0);
-  coeffs.push_back(-0.0947);
-  coeffs.push_back(0);
-  coeffs.push_back(-0.8335);
-  coeffs.push_back(0);
-  allpass2Filter.set_coefficients_out(coeffs);
+  MakePreset("Quadrature", 1., kQuadratureMode, 8., 800., 2., 0., 90., 50.);
+  MakePreset("Phaser", 0.5, kStagesMode, 6., 800., 2., 40., 90., 50.);
+  MakePreset("Deep pad", 0.1, kStagesMode, 24., 600., 2.5, 60., 120., 50.);
 
   Reset();
 }
@@ -98,57 +44,31 @@ ATKStereoPhaser::~ATKStereoPhaser() {}
 void ATKStereoPhaser::ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames)
 {
   // Mutex is already locked for us.
-  inFilter.set_pointer(inputs[0], nFrames);
-  out1Filter.set_pointer(outputs[0], nFrames);
-  out2Filter.set_pointer(outputs[1], nFrames);
-  sinkFilter.process(nFrames);
+
+  dsp.process(inputs, outputs, nFrames);
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKStereoPhaser::Reset()
 {
   TRACE;
   IMutexLock lock(this);
-  
-  int sampling_rate = GetSampleRate();
-  
-  if (sampling_rate != sinkFilter.get_input_sampling_rate())
-  {
-    inFilter.set_input_sampling_rate(sampling_rate);
-    inFilter.set_output_sampling_rate(sampling_rate);
-    allpass1Filter.set_input_sampling_rate(sampling_rate);
-    allpass1Filter.set_output_sampling_rate(sampling_rate);
-    allpass2Filter.set_input_sampling_rate(sampling_rate);
-    allpass2Filter.set_output_sampling_rate(sampling_rate);
-    sinusFilter.set_output_sampling_rate(sampling_rate);
-    applyGainFilter.set_input_sampling_rate(sampling_rate);
-    applyGainFilter.set_output_sampling_rate(sampling_rate);
-    volumeFilter.set_input_sampling_rate(sampling_rate);
-    volumeFilter.set_output_sampling_rate(sampling_rate);
-    sum1Filter.set_input_sampling_rate(sampling_rate);
-    sum1Filter.set_output_sampling_rate(sampling_rate);
-    sum2Filter.set_input_sampling_rate(sampling_rate);
-    sum2Filter.set_output_sampling_rate(sampling_rate);
-    out1Filter.set_input_sampling_rate(sampling_rate);
-    out1Filter.set_output_sampling_rate(sampling_rate);
-    out2Filter.set_input_sampling_rate(sampling_rate);
-    out2Filter.set_output_sampling_rate(sampling_rate);
-    sinkFilter.set_input_sampling_rate(sampling_rate);
-    sinkFilter.set_output_sampling_rate(sampling_rate);
-  }
-  sinusFilter.full_setup();
+
+  dsp.set_sampling_rate(GetSampleRate());
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKStereoPhaser::OnParamChange(int paramIdx)
 {
-  IMutexLock lock(this);
+  dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+}
 
-  switch (paramIdx)
+void ATKStereoPhaser::UpdateTailSize(int64_t tail_length)
+{
+  // the host is only told when the tail changes, not after every block
+  if (tail_length != this->tail_length)
   {
-  case kModulation:
-    sinusFilter.set_frequency(GetParam(kModulation)->Value());
-    break;
-
-  default:
-    break;
+    this->tail_length = tail_length;
+    SetTailSize(static_cast<int>(tail_length));
   }
 }
@@ -3,17 +3,9 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 
-#include <ATK/Core/PipelineGlobalSinkFilter.h>
-#include <ATK/Core/InPointerFilter.h>
-#include <ATK/Core/OutPointerFilter.h>
-#include <ATK/EQ/IIRFilter.h>
-#include <ATK/EQ/CustomIIRFilter.h>
-#include <ATK/Tools/ApplyGainFilter.h>
-#include <ATK/Tools/SinusGeneratorFilter.h>
-#include <ATK/Tools/SumFilter.h>
-#include <ATK/Tools/VolumeFilter.h>
+#include "ATKStereoPhaserDSP.h"
 
-class ATKStereoPhaser : public IPlug
+class ATKStereoPhaser : public IPlug, public ATKStereoPhaserParameters
 {
 public:
   ATKStereoPhaser(IPlugInstanceInfo instanceInfo);
@@ -24,17 +16,10 @@ public:
   void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
-  ATK::InPointerFilter<double> inFilter;
-  ATK::IIRFilter<ATK::CustomIIRCoefficients<double> > allpass1Filter;
-  ATK::IIRFilter<ATK::CustomIIRCoefficients<double> > allpass2Filter;
-  ATK::SinusGeneratorFilter<double> sinusFilter;
-  ATK::ApplyGainFilter<double> applyGainFilter;
-  ATK::VolumeFilter<double> volumeFilter;
-  ATK::SumFilter<double> sum1Filter;
-  ATK::SumFilter<double> sum2Filter;
-  ATK::OutPointerFilter<double> out1Filter;
-  ATK::OutPointerFilter<double> out2Filter;
-  ATK::PipelineGlobalSinkFilter sinkFilter;
+  void UpdateTailSize(int64_t tail_length);
+
+  ATKStereoPhaserDSP<double> dsp;
+  int64_t tail_length;
 };
 
 #endif
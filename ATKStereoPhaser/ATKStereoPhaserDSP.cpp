@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ATKStereoPhaserDSP.h"
+
+namespace
+{
+  // ATKStereoPhaserParameters::PhaserMode
+  const char* const mode_names[] = {"Quadrature", "Stages"};
+  const int min_nb_stages = ModulatedPhaserFilter<double>::min_nb_stages;
+  const int max_nb_stages = ModulatedPhaserFilter<double>::max_nb_stages;
+}
+
+const ParameterInfo ATKStereoPhaserParameters::parameters[kNumParams] =
+{
+  {"Modulation", 1, 0., 100.0, 0.1, "Hz", 2., false, NULL},
+  {"Mode", kQuadratureMode, 0, kStagesMode, 1, "", 1., false, mode_names},
+  {"Stages", 8, min_nb_stages, max_nb_stages, 1, "", 1., false, NULL},
+  {"Frequency", 800, 50, 5000, 1, "Hz", 2., false, NULL},
+  {"Depth", 2, 0, 4, 0.01, "oct", 1., false, NULL},
+  {"Feedback", 0., -90., 90., 0.01, "%", 1., false, NULL},
+  {"Offset", 90, 0, 180, 0.1, "deg", 1., false, NULL},
+  {"Mix", 50, 0, 100, 0.01, "%", 1., false, NULL}
+};
+
+template<typename DataType_>
+ATKStereoPhaserDSP<DataType_>::ATKStereoPhaserDSP()
+  :mode(-1), inFilter(nullptr, 1, 0, false), applyGainFilter(2), phaserFilter(2), out1Filter(nullptr, 1, 0, false), out2Filter(nullptr, 1, 0, false)
+{
+  allpassFilter.set_input_port(0, &inFilter, 0);
+  applyGainFilter.set_input_port(0, &allpassFilter, 0);
+  applyGainFilter.set_input_port(1, &sinusFilter, 1);
+  applyGainFilter.set_input_port(2, &allpassFilter, 1);
+  applyGainFilter.set_input_port(3, &sinusFilter, 0);
+  volumeFilter.set_input_port(0, &applyGainFilter, 1);
+  sum1Filter.set_input_port(0, &applyGainFilter, 0);
+  sum1Filter.set_input_port(1, &volumeFilter, 0);
+  sum2Filter.set_input_port(0, &applyGainFilter, 0);
+  sum2Filter.set_input_port(1, &applyGainFilter, 1);
+  phaserFilter.set_input_port(0, &inFilter, 0);
+  phaserFilter.set_input_port(1, &inFilter, 0);
+  sinkFilter.add_filter(&out1Filter);
+  sinkFilter.add_filter(&out2Filter);
+
+  volumeFilter.set_volume(-1);
+  allpassFilter.set_coefficients(0, 1.3313, 0.3855);
+  allpassFilter.set_coefficients(1, 0.8335, 0.0947);
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kModulation);
+  ramps.set_ramped(kFrequency);
+  ramps.set_ramped(kDepth);
+  ramps.set_ramped(kFeedback);
+  ramps.set_ramped(kOffset);
+  ramps.set_ramped(kMix);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_>
+ATKStereoPhaserDSP<DataType_>::~ATKStereoPhaserDSP() {}
+
+template<typename DataType_>
+void ATKStereoPhaserDSP<DataType_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // silent inputs, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, nb_inputs, nFrames, get_tail_length()))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    inFilter.set_pointer(inputs[0] + offset, size);
+    out1Filter.set_pointer(outputs[0] + offset, size);
+    out2Filter.set_pointer(outputs[1] + offset, size);
+    sinkFilter.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_>
+void ATKStereoPhaserDSP<DataType_>::set_sampling_rate(int sampling_rate)
+{
+  ramps.set_sampling_rate(sampling_rate);
+
+  if (sampling_rate != sinkFilter.get_input_sampling_rate())
+  {
+    inFilter.set_input_sampling_rate(sampling_rate);
+    inFilter.set_output_sampling_rate(sampling_rate);
+    allpassFilter.set_input_sampling_rate(sampling_rate);
+    allpassFilter.set_output_sampling_rate(sampling_rate);
+    sinusFilter.set_output_sampling_rate(sampling_rate);
+    applyGainFilter.set_input_sampling_rate(sampling_rate);
+    applyGainFilter.set_output_sampling_rate(sampling_rate);
+    volumeFilter.set_input_sampling_rate(sampling_rate);
+    volumeFilter.set_output_sampling_rate(sampling_rate);
+    sum1Filter.set_input_sampling_rate(sampling_rate);
+    sum1Filter.set_output_sampling_rate(sampling_rate);
+    sum2Filter.set_input_sampling_rate(sampling_rate);
+    sum2Filter.set_output_sampling_rate(sampling_rate);
+    phaserFilter.set_input_sampling_rate(sampling_rate);
+    phaserFilter.set_output_sampling_rate(sampling_rate);
+    out1Filter.set_input_sampling_rate(sampling_rate);
+    out1Filter.set_output_sampling_rate(sampling_rate);
+    out2Filter.set_input_sampling_rate(sampling_rate);
+    out2Filter.set_output_sampling_rate(sampling_rate);
+    sinkFilter.set_input_sampling_rate(sampling_rate);
+    sinkFilter.set_output_sampling_rate(sampling_rate);
+  }
+  sinusFilter.full_setup();
+  phaserFilter.full_setup();
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_>
+double ATKStereoPhaserDSP<DataType_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_>
+void ATKStereoPhaserDSP<DataType_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_>
+void ATKStereoPhaserDSP<DataType_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_>
+int64_t ATKStereoPhaserDSP<DataType_>::get_tail_length() const
+{
+  if (mode == kQuadratureMode)
+  {
+    // the poles of the allpass filters are at most at 0.952, below -120 dB after 280 samples
+    return 512;
+  }
+  // each stage delays the decay of the slowest pole, once for each pass through the feedback
+  double pole = std::max<double>(phaserFilter.get_slowest_pole(), SilenceDetector<DataType>::threshold());
+  double decay = std::log(SilenceDetector<DataType>::threshold()) / std::log(pole);
+  return static_cast<int64_t>(decay * phaserFilter.get_nb_stages() * (1 + SilenceDetector<DataType>::decay_count(parameter_values[kFeedback] / 100.)));
+}
+
+template<typename DataType_>
+void ATKStereoPhaserDSP<DataType_>::set_mode(int mode)
+{
+  if (mode == this->mode)
+  {
+    return;
+  }
+  this->mode = mode;
+
+  if (mode == kStagesMode)
+  {
+    out1Filter.set_input_port(0, &phaserFilter, 0);
+    out2Filter.set_input_port(0, &phaserFilter, 1);
+  }
+  else
+  {
+    out1Filter.set_input_port(0, &sum1Filter, 0);
+    out2Filter.set_input_port(0, &sum2Filter, 0);
+  }
+}
+
+template<typename DataType_>
+void ATKStereoPhaserDSP<DataType_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, value);
+  }
+  else
+  {
+    apply_parameter(paramIdx, value);
+  }
+}
+
+template<typename DataType_>
+void ATKStereoPhaserDSP<DataType_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+  case kModulation:
+    sinusFilter.set_frequency(value);
+    phaserFilter.set_lfo_frequency(value);
+    break;
+  case kMode:
+    set_mode(static_cast<int>(value + .5) == kStagesMode ? kStagesMode : kQuadratureMode);
+    break;
+  case kStages:
+    phaserFilter.set_nb_stages(std::min(std::max(static_cast<int>(value + .5), min_nb_stages), max_nb_stages));
+    break;
+  case kFrequency:
+    phaserFilter.set_frequency(value);
+    break;
+  case kDepth:
+    phaserFilter.set_depth(value);
+    break;
+  case kFeedback:
+    phaserFilter.set_feedback(value / 100.);
+    break;
+  case kOffset:
+    phaserFilter.set_phase_offset(value);
+    break;
+  case kMix:
+    phaserFilter.set_mix(value / 100.);
+    break;
+
+  default:
+    break;
+  }
+}
+
+template class ATKStereoPhaserDSP<float>;
+template class ATKStereoPhaserDSP<double>;
@@ -0,0 +1,95 @@
+#ifndef __ATKStereoPhaserDSP__
+#define __ATKStereoPhaserDSP__
+
+#include "../common/ControlRateRamps.h"
+#include "../common/ParameterInfo.h"
+#include "../common/ParameterQueue.h"
+#include "../common/SilenceDetector.h"
+#include "ModulatedPhaserFilter.h"
+#include "QuadratureAllpassFilter.h"
+
+#include <ATK/Core/PipelineGlobalSinkFilter.h>
+#include <ATK/Core/InPointerFilter.h>
+#include <ATK/Core/OutPointerFilter.h>
+#include <ATK/Tools/ApplyGainFilter.h>
+#include <ATK/Tools/SinusGeneratorFilter.h>
+#include <ATK/Tools/SumFilter.h>
+#include <ATK/Tools/VolumeFilter.h>
+
+struct ATKStereoPhaserParameters
+{
+  enum EParams
+  {
+    kModulation = 0,
+    kMode,
+    kStages,
+    kFrequency,
+    kDepth,
+    kFeedback,
+    kOffset,
+    kMix,
+    kNumParams
+  };
+
+  enum PhaserMode
+  {
+    // the two allpass branches in quadrature, modulated by the sine and cosine of the LFO
+    kQuadratureMode = 0,
+    // a chain of Stages allpass filters swept by the LFO on each channel
+    kStagesMode
+  };
+
+  static const ParameterInfo parameters[kNumParams];
+};
+
+// GUI-free processing graph of ATKStereoPhaser, shared by the plugin and the offline tools
+// In the stages mode, both channels run through the same ModulatedPhaserFilter, the LFO of the
+// right one being ahead by the Offset parameter
+template<typename DataType_>
+class ATKStereoPhaserDSP : public ATKStereoPhaserParameters
+{
+public:
+  typedef DataType_ DataType;
+
+  static const int nb_inputs = 1;
+  static const int nb_sidechain_inputs = 0;
+  static const int nb_outputs = 2;
+
+  ATKStereoPhaserDSP();
+  ~ATKStereoPhaserDSP();
+
+  void set_sampling_rate(int sampling_rate);
+  void set_parameter(int paramIdx, double value);
+  double get_parameter(int paramIdx) const;
+  // Can be called from any thread, the value is applied at the start of the next process call
+  void post_parameter(int paramIdx, double value);
+  // Shape and duration of the ramps following a parameter change
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  // Samples for the output and the state of the graph to fall below the silence threshold once the input stops
+  int64_t get_tail_length() const;
+  void process(DataType** inputs, DataType** outputs, int nFrames);
+
+private:
+  void apply_parameter(int paramIdx, double value);
+  void set_mode(int mode);
+
+  double parameter_values[kNumParams];
+  ParameterQueue<kNumParams> parameter_queue;
+  ControlRateRamps<kNumParams> ramps;
+  SilenceDetector<DataType> silence;
+  int mode;
+
+  ATK::InPointerFilter<DataType> inFilter;
+  QuadratureAllpassFilter<DataType> allpassFilter;
+  ATK::SinusGeneratorFilter<DataType> sinusFilter;
+  ATK::ApplyGainFilter<DataType> applyGainFilter;
+  ATK::VolumeFilter<DataType> volumeFilter;
+  ATK::SumFilter<DataType> sum1Filter;
+  ATK::SumFilter<DataType> sum2Filter;
+  ModulatedPhaserFilter<DataType> phaserFilter;
+  ATK::OutPointerFilter<DataType> out1Filter;
+  ATK::OutPointerFilter<DataType> out2Filter;
+  ATK::PipelineGlobalSinkFilter sinkFilter;
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "ModulatedPhaserFilter.h"
+
+namespace
+{
+  const double pi = 3.14159265358979323846;
+  // the break frequencies stay away from DC and Nyquist, where the poles reach the unit circle
+  const double min_break_frequency = 10;
+  const double max_break_ratio = .45;
+}
+
+template<typename DataType_>
+ModulatedPhaserFilter<DataType_>::ModulatedPhaserFilter(int nb_channels)
+  :Parent(nb_channels, nb_channels), nb_channels(nb_channels), nb_stages(min_nb_stages), period(32), frequency(1000), depth(0),
+  lfo_frequency(1), phase_offset(0), feedback(0), mix(.5), phase(0), started(false), remaining(0)
+{
+  if (nb_channels < 1 || nb_channels > max_nb_channels)
+  {
+    throw std::runtime_error("ModulatedPhaserFilter processes one or two channels");
+  }
+  for (int channel = 0; channel < max_nb_channels; ++channel)
+  {
+    coefficients[channel] = 0;
+    targets[channel] = 0;
+    increments[channel] = 0;
+    last_outputs[channel] = 0;
+    for (int stage = 0; stage < max_nb_stages; ++stage)
+    {
+      state[stage][channel] = 0;
+    }
+  }
+}
+
+template<typename DataType_>
+ModulatedPhaserFilter<DataType_>::~ModulatedPhaserFilter() {}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::set_nb_stages(int nb_stages)
+{
+  if (nb_stages < min_nb_stages || nb_stages > max_nb_stages)
+  {
+    throw std::runtime_error("Wrong number of phaser stages");
+  }
+  for (int stage = std::min(nb_stages, this->nb_stages); stage < max_nb_stages; ++stage)
+  {
+    for (int channel = 0; channel < max_nb_channels; ++channel)
+    {
+      state[stage][channel] = 0;
+    }
+  }
+  this->nb_stages = nb_stages;
+}
+
+template<typename DataType_>
+int ModulatedPhaserFilter<DataType_>::get_nb_stages() const
+{
+  return nb_stages;
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::set_period(int period)
+{
+  this->period = std::max(period, 1);
+}
+
+template<typename DataType_>
+int ModulatedPhaserFilter<DataType_>::get_period() const
+{
+  return period;
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::set_frequency(double frequency)
+{
+  this->frequency = frequency;
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::set_depth(double depth)
+{
+  this->depth = depth;
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::set_lfo_frequency(double lfo_frequency)
+{
+  this->lfo_frequency = lfo_frequency;
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::set_phase_offset(double phase_offset)
+{
+  this->phase_offset = phase_offset * pi / 180;
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::set_feedback(DataType feedback)
+{
+  this->feedback = feedback;
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::set_mix(DataType mix)
+{
+  this->mix = mix;
+}
+
+template<typename DataType_>
+double ModulatedPhaserFilter<DataType_>::get_slowest_pole() const
+{
+  // the pole is -a, largest at the lowest break frequency
+  return std::abs(coefficient(frequency * std::pow(2., -std::abs(depth))));
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::full_setup()
+{
+  Parent::full_setup();
+  for (int channel = 0; channel < max_nb_channels; ++channel)
+  {
+    last_outputs[channel] = 0;
+    for (int stage = 0; stage < max_nb_stages; ++stage)
+    {
+      state[stage][channel] = 0;
+    }
+  }
+  phase = 0;
+  started = false;
+  remaining = 0;
+}
+
+template<typename DataType_>
+double ModulatedPhaserFilter<DataType_>::break_frequency(double phase) const
+{
+  return frequency * std::pow(2., depth * std::sin(phase));
+}
+
+template<typename DataType_>
+double ModulatedPhaserFilter<DataType_>::coefficient(double frequency) const
+{
+  double sampling_rate = this->get_output_sampling_rate();
+  if (sampling_rate == 0)
+  {
+    return 0;
+  }
+  frequency = std::min(std::max(frequency, min_break_frequency), max_break_ratio * sampling_rate);
+  // bilinear transform, the phase of a stage is -90 degrees at its break frequency
+  double t = std::tan(pi * frequency / sampling_rate);
+  return (t - 1) / (t + 1);
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::next_coefficients() const
+{
+  if (!started)
+  {
+    for (int channel = 0; channel < nb_channels; ++channel)
+    {
+      coefficients[channel] = static_cast<DataType>(coefficient(break_frequency(phase + channel * phase_offset)));
+    }
+    started = true;
+  }
+
+  double sampling_rate = this->get_output_sampling_rate();
+  phase += sampling_rate == 0 ? 0 : 2 * pi * lfo_frequency * period / sampling_rate;
+  phase = std::fmod(phase, 2 * pi);
+  for (int channel = 0; channel < nb_channels; ++channel)
+  {
+    targets[channel] = static_cast<DataType>(coefficient(break_frequency(phase + channel * phase_offset)));
+    increments[channel] = (targets[channel] - coefficients[channel]) / period;
+  }
+  remaining = period;
+}
+
+template<typename DataType_>
+void ModulatedPhaserFilter<DataType_>::process_impl(int64_t size) const
+{
+  if (nb_channels == 1)
+  {
+    process_channels<1>(size);
+  }
+  else
+  {
+    process_channels<2>(size);
+  }
+}
+
+template<typename DataType_>
+template<int nb_channels_>
+void ModulatedPhaserFilter<DataType_>::process_channels(int64_t size) const
+{
+  const int nb_stages = this->nb_stages;
+  const DataType feedback = this->feedback;
+  const DataType mix = this->mix;
+  const DataType dry = 1 - mix;
+
+  // local copies, so that the stores to the outputs do not alias the state
+  DataType s[max_nb_stages][nb_channels_];
+  DataType last[nb_channels_];
+  for (int channel = 0; channel < nb_channels_; ++channel)
+  {
+    last[channel] = last_outputs[channel];
+    for (int stage = 0; stage < nb_stages; ++stage)
+    {
+      s[stage][channel] = state[stage][channel];
+    }
+  }
+
+  for (int64_t i = 0; i < size; )
+  {
+    if (remaining == 0)
+    {
+      next_coefficients();
+    }
+    int64_t chunk = std::min<int64_t>(remaining, size - i);
+    remaining -= static_cast<int>(chunk);
+
+    DataType start[nb_channels_];
+    DataType step[nb_channels_];
+    for (int channel = 0; channel < nb_channels_; ++channel)
+    {
+      start[channel] = coefficients[channel];
+      step[channel] = increments[channel];
+    }
+
+    for (int64_t j = 0; j < chunk; ++j)
+    {
+      DataType a[nb_channels_];
+      DataType values[nb_channels_];
+      for (int channel = 0; channel < nb_channels_; ++channel)
+      {
+        // from the start of the chunk, the increments do not accumulate
+        a[channel] = start[channel] + (j + 1) * step[channel];
+        values[channel] = converted_inputs[channel][i + j] + feedback * last[channel];
+      }
+
+      for (int stage = 0; stage < nb_stages; ++stage)
+      {
+        for (int channel = 0; channel < nb_channels_; ++channel)
+        {
+          DataType output = a[channel] * values[channel] + s[stage][channel];
+          s[stage][channel] = values[channel] - a[channel] * output;
+          values[channel] = output;
+        }
+      }
+
+      for (int channel = 0; channel < nb_channels_; ++channel)
+      {
+        last[channel] = values[channel];
+        outputs[channel][i + j] = dry * converted_inputs[channel][i + j] + mix * values[channel];
+      }
+    }
+
+    for (int channel = 0; channel < nb_channels_; ++channel)
+    {
+      // the end of a period is the target itself
+      coefficients[channel] = remaining == 0 ? targets[channel] : coefficients[channel] + chunk * increments[channel];
+    }
+    i += chunk;
+  }
+
+  for (int channel = 0; channel < nb_channels_; ++channel)
+  {
+    last_outputs[channel] = last[channel];
+    for (int stage = 0; stage < nb_stages; ++stage)
+    {
+      state[stage][channel] = s[stage][channel];
+    }
+  }
+}
+
+template class ModulatedPhaserFilter<float>;
+template class ModulatedPhaserFilter<double>;
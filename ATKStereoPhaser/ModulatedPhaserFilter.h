@@ -0,0 +1,87 @@
+#ifndef __ModulatedPhaserFilter__
+#define __ModulatedPhaserFilter__
+
+#include <cstdint>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+// Chain of first order allpass stages (a + z^-1) / (1 + a z^-1) swept by a sine LFO, for one or
+// two channels, the output of the last stage being fed back to the first one
+// Inputs and outputs: the nb_channels signals, output = (1 - mix) * input + mix * last stage
+// The break frequency of the stages is frequency * 2^(depth * sin(phase)), the LFO of the second
+// channel being ahead by the phase offset. The coefficients are computed once every period samples
+// and linearly interpolated in between, and the channels are the lanes of the stage loops, their
+// count being a template parameter so that the compiler unrolls them
+template<typename DataType_>
+class ModulatedPhaserFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+
+public:
+  static const int max_nb_channels = 2;
+  static const int min_nb_stages = 2;
+  static const int max_nb_stages = 24;
+
+  ModulatedPhaserFilter(int nb_channels = 1);
+  ~ModulatedPhaserFilter();
+
+  // Between two process calls, the stages that are added start from a cleared state
+  void set_nb_stages(int nb_stages);
+  int get_nb_stages() const;
+  // Samples between two computations of the coefficients
+  void set_period(int period);
+  int get_period() const;
+  // Break frequency of the stages at the center of the sweep, in Hz
+  void set_frequency(double frequency);
+  // Half the width of the sweep, in octaves
+  void set_depth(double depth);
+  void set_lfo_frequency(double lfo_frequency);
+  // Phase of the LFO of the second channel relative to the first one, in degrees
+  void set_phase_offset(double phase_offset);
+  // |feedback| < 1
+  void set_feedback(DataType feedback);
+  void set_mix(DataType mix);
+
+  // Largest magnitude of the poles of the stages over the sweep, for the decay of the chain
+  double get_slowest_pole() const;
+
+  void full_setup();
+
+protected:
+  void process_impl(int64_t size) const;
+
+private:
+  template<int nb_channels_>
+  void process_channels(int64_t size) const;
+  // Starts the interpolation towards the coefficients at the end of the next period
+  void next_coefficients() const;
+  double break_frequency(double phase) const;
+  double coefficient(double frequency) const;
+
+  int nb_channels;
+  int nb_stages;
+  int period;
+  double frequency;
+  double depth;
+  double lfo_frequency;
+  double phase_offset;
+  DataType feedback;
+  DataType mix;
+
+  // LFO phase of the first channel at the end of the current period, in radians
+  mutable double phase;
+  mutable bool started;
+  mutable int remaining;
+  // one per channel
+  mutable DataType coefficients[max_nb_channels];
+  mutable DataType targets[max_nb_channels];
+  mutable DataType increments[max_nb_channels];
+  mutable DataType last_outputs[max_nb_channels];
+  mutable DataType state[max_nb_stages][max_nb_channels];
+};
+
+#endif
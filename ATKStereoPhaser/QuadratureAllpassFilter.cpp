@@ -0,0 +1,121 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "QuadratureAllpassFilter.h"
+
+template<typename DataType_>
+QuadratureAllpassFilter<DataType_>::QuadratureAllpassFilter()
+  :Parent(1, nb_branches), last_input(0)
+{
+  for (int section = 0; section < nb_sections; ++section)
+  {
+    for (int branch = 0; branch < nb_branches; ++branch)
+    {
+      coefficients[section][branch] = 0;
+      state1[section][branch] = 0;
+      state2[section][branch] = 0;
+    }
+  }
+}
+
+template<typename DataType_>
+QuadratureAllpassFilter<DataType_>::~QuadratureAllpassFilter() {}
+
+template<typename DataType_>
+void QuadratureAllpassFilter<DataType_>::set_coefficients(int branch, double a2, double a4)
+{
+  if (branch < 0 || branch >= nb_branches)
+  {
+    throw std::runtime_error("Wrong allpass branch");
+  }
+  // 1 + a2 z^-2 + a4 z^-4 = (1 + c0 z^-2) (1 + c1 z^-2)
+  double discriminant = a2 * a2 - 4 * a4;
+  if (discriminant < 0)
+  {
+    throw std::runtime_error("The allpass sections need real coefficients");
+  }
+  double c0 = (a2 + std::sqrt(discriminant)) / 2;
+  double c1 = (a2 - std::sqrt(discriminant)) / 2;
+  if (std::abs(c0) >= 1 || std::abs(c1) >= 1)
+  {
+    throw std::runtime_error("Unstable allpass section");
+  }
+  coefficients[0][branch] = static_cast<DataType>(c0);
+  coefficients[1][branch] = static_cast<DataType>(c1);
+}
+
+template<typename DataType_>
+void QuadratureAllpassFilter<DataType_>::full_setup()
+{
+  Parent::full_setup();
+  last_input = 0;
+  for (int section = 0; section < nb_sections; ++section)
+  {
+    for (int branch = 0; branch < nb_branches; ++branch)
+    {
+      state1[section][branch] = 0;
+      state2[section][branch] = 0;
+    }
+  }
+}
+
+template<typename DataType_>
+void QuadratureAllpassFilter<DataType_>::process_impl(int64_t size) const
+{
+  const DataType* input = converted_inputs[0];
+
+  // local copies, so that the state stays in registers
+  DataType c[nb_sections][nb_branches];
+  DataType s1[nb_sections][nb_branches];
+  DataType s2[nb_sections][nb_branches];
+  for (int section = 0; section < nb_sections; ++section)
+  {
+    for (int branch = 0; branch < nb_branches; ++branch)
+    {
+      c[section][branch] = coefficients[section][branch];
+      s1[section][branch] = state1[section][branch];
+      s2[section][branch] = state2[section][branch];
+    }
+  }
+  DataType previous = last_input;
+
+  for (int64_t i = 0; i < size; ++i)
+  {
+    DataType values[nb_branches];
+    for (int branch = 0; branch < nb_branches; ++branch)
+    {
+      values[branch] = previous;
+    }
+    previous = input[i];
+
+    for (int section = 0; section < nb_sections; ++section)
+    {
+      for (int branch = 0; branch < nb_branches; ++branch)
+      {
+        // b = (c, 0, 1), a = (1, 0, c): the middle state only delays the last one
+        DataType output = c[section][branch] * values[branch] + s1[section][branch];
+        s1[section][branch] = s2[section][branch];
+        s2[section][branch] = values[branch] - c[section][branch] * output;
+        values[branch] = output;
+      }
+    }
+
+    for (int branch = 0; branch < nb_branches; ++branch)
+    {
+      outputs[branch][i] = values[branch];
+    }
+  }
+
+  for (int section = 0; section < nb_sections; ++section)
+  {
+    for (int branch = 0; branch < nb_branches; ++branch)
+    {
+      state1[section][branch] = s1[section][branch];
+      state2[section][branch] = s2[section][branch];
+    }
+  }
+  last_input = previous;
+}
+
+template class QuadratureAllpassFilter<float>;
+template class QuadratureAllpassFilter<double>;
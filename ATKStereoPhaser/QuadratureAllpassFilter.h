@@ -0,0 +1,46 @@
+#ifndef __QuadratureAllpassFilter__
+#define __QuadratureAllpassFilter__
+
+#include <cstdint>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+// The two allpass branches of the phaser, z^-1 (a4 + a2 z^-2 + z^-4) / (1 + a2 z^-2 + a4 z^-4)
+// each, like two CustomIIRFilters but without their zero taps: a branch is factored in two
+// second order sections (c + z^-2) / (1 + c z^-2), computed in transposed direct form II
+// The branches are the lanes of the same loops
+// Input: the signal, outputs: the two branches
+template<typename DataType_>
+class QuadratureAllpassFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+
+public:
+  static const int nb_branches = 2;
+  static const int nb_sections = 2;
+
+  QuadratureAllpassFilter();
+  ~QuadratureAllpassFilter();
+
+  // Denominator of a branch, its roots in z^2 must be real and inside the unit circle
+  void set_coefficients(int branch, double a2, double a4);
+
+  void full_setup();
+
+protected:
+  void process_impl(int64_t size) const;
+
+private:
+  // the c of each section, for each branch
+  DataType coefficients[nb_sections][nb_branches];
+
+  mutable DataType last_input;
+  mutable DataType state1[nb_sections][nb_branches];
+  mutable DataType state2[nb_sections][nb_branches];
+};
+
+#endif
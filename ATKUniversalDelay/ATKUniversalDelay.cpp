@@ -3,17 +3,9 @@
 #include "IControl.h"
 #include "controls.h"
 #include "resource.h"
+#include "../common/IPlugParameters.h"
 
-const int kNumPrograms = 4;
-
-enum EParams
-{
-  kDelay = 0,
-  kBlend,
-  kFeedforward,
-  kFeedback,
-  kNumParams
-};
+const int kNumPrograms = 5;
 
 enum ELayout
 {
@@ -32,19 +24,11 @@ enum ELayout
 };
 
 ATKUniversalDelay::ATKUniversalDelay(IPlugInstanceInfo instanceInfo)
-  :IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), inFilter(nullptr, 1, 0, false), outFilter(nullptr, 1, 0, false), delayFilter(192000)
+  :IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), tail_length(-1)
 {
   TRACE;
 
-  //arguments are: name, defaultVal, minVal, maxVal, step, label
-  GetParam(kDelay)->InitDouble("Delay", 1, 0.1, 1000.0, 0.1, "ms");
-  GetParam(kDelay)->SetShape(2.);
-  GetParam(kBlend)->InitDouble("Blend", 100, 0., 100.0, 0.01, "%");
-  GetParam(kBlend)->SetShape(1.);
-  GetParam(kFeedforward)->InitDouble("Feedforward", 50., -100, 100, 0.01, "%");
-  GetParam(kFeedforward)->SetShape(1.);
-  GetParam(kFeedback)->InitDouble("Feedback", 0., -90., 90., 0.01, "%");
-  GetParam(kFeedback)->SetShape(1.);
+  InitParameters(this, parameters, kNumParams);
 
   IGraphics* pGraphics = MakeGraphics(this, kWidth, kHeight);
   pGraphics->AttachBackground(UNIVERSALDELAY_ID, UNIVERSALDELAY_FN);
@@ -61,14 +45,12 @@ ATKUniversalDelay::ATKUniversalDelay(IPlugInstanceInfo instanceInfo)
   AttachGraphics(pGraphics);
 
   //MakePreset("preset 1", ... );
-  MakePreset("FIR comb filter", 1., 100., 50., 0.);
-  MakePreset("IIR comb filter", 1., 100., 50., 10.);
-  MakePreset("All pass", 1., 10., 100., -10.);
-  MakePreset("Delay", 1., 100., 0., 0.);
-
-  delayFilter.set_input_port(0, &inFilter, 0);
-  outFilter.set_input_port(0, &delayFilter, 0);
-  
+  MakePreset("FIR comb filter", 1., 100., 50., 0., false, 8);
+  MakePreset("IIR comb filter", 1., 100., 50., 10., false, 8);
+  MakePreset("All pass", 1., 10., 100., -10., false, 8);
+  MakePreset("Delay", 1., 100., 0., 0., false, 8);
+  MakePreset("Synced echo", 1., 100., 50., 40., true, 6);
+
   Reset();
 }
 
@@ -77,50 +59,43 @@ ATKUniversalDelay::~ATKUniversalDelay() {}
 void ATKUniversalDelay::ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames)
 {
   // Mutex is already locked for us.
-  inFilter.set_pointer(inputs[0], nFrames);
-  outFilter.set_pointer(outputs[0], nFrames);
-  outFilter.process(nFrames);
+
+  dsp.set_tempo(GetTempo());
+  dsp.process(inputs, outputs, nFrames);
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKUniversalDelay::Reset()
 {
   TRACE;
   IMutexLock lock(this);
-  
-  int sampling_rate = GetSampleRate();
-  
-  if(sampling_rate != inFilter.get_output_sampling_rate())
+
+  dsp.set_tempo(GetTempo());
+  dsp.set_sampling_rate(GetSampleRate());
+  if (GetParam(kSync)->Bool())
   {
-    inFilter.set_input_sampling_rate(sampling_rate);
-    inFilter.set_output_sampling_rate(sampling_rate);
-    delayFilter.set_input_sampling_rate(sampling_rate);
-    delayFilter.set_output_sampling_rate(sampling_rate);
-    outFilter.set_input_sampling_rate(sampling_rate);
-    outFilter.set_output_sampling_rate(sampling_rate);
+    dsp.reserve_synced_delay();
   }
-  delayFilter.full_setup();
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKUniversalDelay::OnParamChange(int paramIdx)
 {
-  IMutexLock lock(this);
+  if (paramIdx == kSync && GetParam(kSync)->Bool())
+  {
+    // the 10 s line is only allocated when Sync is first switched on, outside of the processing
+    IMutexLock lock(this);
+    dsp.reserve_synced_delay();
+  }
+  dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+}
 
-  switch (paramIdx)
+void ATKUniversalDelay::UpdateTailSize(int64_t tail_length)
+{
+  // the host is only told when the tail changes, not after every block
+  if (tail_length != this->tail_length)
   {
-    case kDelay:
-      delayFilter.set_delay(GetParam(kDelay)->Value() / 1000. * GetSampleRate());
-      break;
-    case kBlend:
-      delayFilter.set_blend((GetParam(kBlend)->Value()) / 100.);
-      break;
-    case kFeedforward:
-      delayFilter.set_feedforward((GetParam(kFeedforward)->Value()) / 100.);
-      break;
-    case kFeedback:
-      delayFilter.set_feedback((GetParam(kFeedback)->Value()) / 100.);
-      break;
-
-    default:
-      break;
+    this->tail_length = tail_length;
+    SetTailSize(static_cast<int>(tail_length));
   }
 }
@@ -3,11 +3,9 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 
-#include <ATK/Core/InPointerFilter.h>
-#include <ATK/Core/OutPointerFilter.h>
-#include <ATK/Delay/UniversalFixedDelayLineFilter.h>
+#include "ATKUniversalDelayDSP.h"
 
-class ATKUniversalDelay : public IPlug
+class ATKUniversalDelay : public IPlug, public ATKUniversalDelayParameters
 {
 public:
   ATKUniversalDelay(IPlugInstanceInfo instanceInfo);
@@ -18,9 +16,10 @@ public:
   void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
-  ATK::InPointerFilter<double> inFilter;
-  ATK::UniversalFixedDelayLineFilter<double> delayFilter;
-  ATK::OutPointerFilter<double> outFilter;
+  void UpdateTailSize(int64_t tail_length);
+
+  ATKUniversalDelayDSP<double> dsp;
+  int64_t tail_length;
 };
 
 #endif
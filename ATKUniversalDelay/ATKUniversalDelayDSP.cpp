@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ATKUniversalDelayDSP.h"
+
+namespace
+{
+  const char* const division_names[] = {"1/32", "1/16T", "1/16", "1/16D", "1/8T", "1/8", "1/8D", "1/4T", "1/4", "1/4D",
+    "1/2T", "1/2", "1/2D", "1/1", "1/1D", "2/1", "4/1"};
+  // in beats (quarter notes)
+  const double division_lengths[] = {1. / 8, 1. / 6, 1. / 4, 3. / 8, 1. / 3, 1. / 2, 3. / 4, 2. / 3, 1, 3. / 2,
+    4. / 3, 2, 3, 4, 6, 8, 16};
+  const int nb_divisions = sizeof(division_lengths) / sizeof(division_lengths[0]);
+  // longest synced delay, whatever the tempo and the division
+  const double max_synced_delay_ms = 10000;
+}
+
+const ParameterInfo ATKUniversalDelayParameters::parameters[kNumParams] =
+{
+  {"Delay", 1, 0.1, 1000.0, 0.1, "ms", 2., false, NULL},
+  {"Blend", 100, 0., 100.0, 0.01, "%", 1., false, NULL},
+  {"Feedforward", 50., -100, 100, 0.01, "%", 1., false, NULL},
+  {"Feedback", 0., -90., 90., 0.01, "%", 1., false, NULL},
+  {"Sync", 0, 0, 1, 1, "", 1., true, NULL},
+  {"Division", 8, 0, nb_divisions - 1, 1, "", 1., false, division_names}
+};
+
+template<typename DataType_>
+ATKUniversalDelayDSP<DataType_>::ATKUniversalDelayDSP()
+  :tempo(120), synced_delay_reserved(false), delay(1), inFilter(nullptr, 1, 0, false), delayFilter(1), outFilter(nullptr, 1, 0, false)
+{
+  delayFilter.set_input_port(0, &inFilter, 0);
+  outFilter.set_input_port(0, &delayFilter, 0);
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kBlend);
+  ramps.set_ramped(kFeedforward);
+  ramps.set_ramped(kFeedback);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_>
+ATKUniversalDelayDSP<DataType_>::~ATKUniversalDelayDSP() {}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // silent inputs, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, nb_inputs, nFrames, get_tail_length()))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    inFilter.set_pointer(inputs[0] + offset, size);
+    outFilter.set_pointer(outputs[0] + offset, size);
+    outFilter.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::set_sampling_rate(int sampling_rate)
+{
+  ramps.set_sampling_rate(sampling_rate);
+
+  if(sampling_rate != inFilter.get_output_sampling_rate())
+  {
+    inFilter.set_input_sampling_rate(sampling_rate);
+    inFilter.set_output_sampling_rate(sampling_rate);
+    delayFilter.set_input_sampling_rate(sampling_rate);
+    delayFilter.set_output_sampling_rate(sampling_rate);
+    outFilter.set_input_sampling_rate(sampling_rate);
+    outFilter.set_output_sampling_rate(sampling_rate);
+  }
+  // not ramped, but in samples, the line is long enough for any synced delay at any tempo once Sync
+  // has been on
+  synced_delay_reserved = synced_delay_reserved || parameter_values[kSync] != 0;
+  double max_delay_ms = synced_delay_reserved ? std::max(parameters[kDelay].max_value, max_synced_delay_ms) : parameters[kDelay].max_value;
+  delayFilter.set_max_delay(static_cast<int64_t>(std::ceil(max_delay_ms / 1000. * sampling_rate)));
+  delayFilter.full_setup();
+  update_delay();
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::reserve_synced_delay()
+{
+  if (!synced_delay_reserved)
+  {
+    synced_delay_reserved = true;
+    int sampling_rate = outFilter.get_output_sampling_rate();
+    delayFilter.set_max_delay(static_cast<int64_t>(std::ceil(std::max(parameters[kDelay].max_value, max_synced_delay_ms) / 1000. * sampling_rate)));
+    delayFilter.full_setup();
+    update_delay();
+  }
+}
+
+template<typename DataType_>
+double ATKUniversalDelayDSP<DataType_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_>
+int64_t ATKUniversalDelayDSP<DataType_>::get_tail_length() const
+{
+  // once for each pass through the feedback
+  return static_cast<int64_t>(delay * (1 + SilenceDetector<DataType>::decay_count(parameter_values[kFeedback] / 100.)));
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::set_tempo(double tempo)
+{
+  if (tempo > 0 && tempo != this->tempo)
+  {
+    this->tempo = tempo;
+    update_delay();
+  }
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::update_delay()
+{
+  double delay_ms = parameter_values[kDelay];
+  if (parameter_values[kSync] != 0)
+  {
+    int division = std::min(std::max(static_cast<int>(parameter_values[kDivision] + .5), 0), nb_divisions - 1);
+    delay_ms = std::min(division_lengths[division] * 60000. / tempo, max_synced_delay_ms);
+  }
+  // clamped to the line if the synced delays were not reserved
+  delayFilter.set_delay(static_cast<int64_t>(delay_ms / 1000. * outFilter.get_output_sampling_rate()));
+  delay = delayFilter.get_delay();
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::set_block_processing(bool block_processing)
+{
+  delayFilter.set_block_processing(block_processing);
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, value);
+  }
+  else
+  {
+    apply_parameter(paramIdx, value);
+  }
+}
+
+template<typename DataType_>
+void ATKUniversalDelayDSP<DataType_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+    case kDelay:
+    case kSync:
+    case kDivision:
+      update_delay();
+      break;
+    case kBlend:
+      delayFilter.set_blend((value) / 100.);
+      break;
+    case kFeedforward:
+      delayFilter.set_feedforward((value) / 100.);
+      break;
+    case kFeedback:
+      delayFilter.set_feedback((value) / 100.);
+      break;
+
+    default:
+      break;
+  }
+}
+
+template class ATKUniversalDelayDSP<float>;
+template class ATKUniversalDelayDSP<double>;
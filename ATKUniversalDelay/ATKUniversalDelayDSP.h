@@ -0,0 +1,85 @@
+#ifndef __ATKUniversalDelayDSP__
+#define __ATKUniversalDelayDSP__
+
+#include <cstdint>
+
+#include "../common/ControlRateRamps.h"
+#include "../common/FixedDelayLineFilter.h"
+#include "../common/ParameterInfo.h"
+#include "../common/ParameterQueue.h"
+#include "../common/SilenceDetector.h"
+
+#include <ATK/Core/InPointerFilter.h>
+#include <ATK/Core/OutPointerFilter.h>
+
+struct ATKUniversalDelayParameters
+{
+  enum EParams
+  {
+    kDelay = 0,
+    kBlend,
+    kFeedforward,
+    kFeedback,
+    kSync,
+    kDivision,
+    kNumParams
+  };
+
+  static const ParameterInfo parameters[kNumParams];
+};
+
+// GUI-free processing graph of ATKUniversalDelay, shared by the plugin and the offline tools
+// The delay line is sized in set_sampling_rate() for the largest Delay at that rate, and for the
+// longest synced delay (10 s) once Sync has been on, so that tempo and division changes never
+// allocate while processing
+template<typename DataType_>
+class ATKUniversalDelayDSP : public ATKUniversalDelayParameters
+{
+public:
+  typedef DataType_ DataType;
+
+  static const int nb_inputs = 1;
+  static const int nb_sidechain_inputs = 0;
+  static const int nb_outputs = 1;
+
+  ATKUniversalDelayDSP();
+  ~ATKUniversalDelayDSP();
+
+  void set_sampling_rate(int sampling_rate);
+  // Grows the delay line to the longest synced delay, before Sync is switched on while processing.
+  // Allocates (once), not while processing. Until then, synced delays are clamped to the line
+  void reserve_synced_delay();
+  void set_parameter(int paramIdx, double value);
+  double get_parameter(int paramIdx) const;
+  // Can be called from any thread, the value is applied at the start of the next process call
+  void post_parameter(int paramIdx, double value);
+  // Shape and duration of the ramps following a parameter change
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  // Samples for the output and the state of the graph to fall below the silence threshold once the input stops
+  int64_t get_tail_length() const;
+  // Tempo of the host in beats per minute, for the synced delays. Ignored if not positive
+  void set_tempo(double tempo);
+  // Delays longer than 16 samples are processed in blocks, false runs the sample by sample reference
+  void set_block_processing(bool block_processing);
+  void process(DataType** inputs, DataType** outputs, int nFrames);
+
+private:
+  void apply_parameter(int paramIdx, double value);
+  void update_delay();
+
+  double parameter_values[kNumParams];
+  ParameterQueue<kNumParams> parameter_queue;
+  ControlRateRamps<kNumParams> ramps;
+  SilenceDetector<DataType> silence;
+  double tempo;
+  // the delay line is long enough for the synced delays
+  bool synced_delay_reserved;
+  // the delay in samples
+  int64_t delay;
+
+  ATK::InPointerFilter<DataType> inFilter;
+  FixedDelayLineFilter<DataType> delayFilter;
+  ATK::OutPointerFilter<DataType> outFilter;
+};
+
+#endif
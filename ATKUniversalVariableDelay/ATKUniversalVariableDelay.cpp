@@ -2,20 +2,10 @@
 #include "IPlug_include_in_plug_src.h"
 #include "IControl.h"
 #include "resource.h"
+#include "../common/IPlugParameters.h"
 
 const int kNumPrograms = 1;
 
-enum EParams
-{
-  kDelay = 0,
-  kDepth,
-  kMod,
-  kBlend,
-  kFeedforward,
-  kFeedback,
-  kNumParams
-};
-
 enum ELayout
 {
   kWidth = GUI_WIDTH,
@@ -37,23 +27,11 @@ enum ELayout
 };
 
 ATKUniversalVariableDelay::ATKUniversalVariableDelay(IPlugInstanceInfo instanceInfo)
-: IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), inFilter(nullptr, 1, 0, false), outFilter(nullptr, 1, 0, false), delayFilter(1152)
+: IPLUG_CTOR(kNumParams, kNumPrograms, instanceInfo), tail_length(-1)
 {
   TRACE;
 
-  //arguments are: name, defaultVal, minVal, maxVal, step, label
-  GetParam(kDelay)->InitDouble("Delay", 0.2, 0.2, 3.0, 0.1, "ms");
-  GetParam(kDelay)->SetShape(2.);
-  GetParam(kDepth)->InitDouble("Depth", 0.1, 0.1, 2.9, 0.1, "ms");
-  GetParam(kDepth)->SetShape(2.);
-  GetParam(kMod)->InitDouble("Modulation", 1, 0.1, 5.0, 0.1, "Hz");
-  GetParam(kMod)->SetShape(1.);
-  GetParam(kBlend)->InitDouble("Blend", 100, -100, 100, 0.01, "%");
-  GetParam(kBlend)->SetShape(1.);
-  GetParam(kFeedforward)->InitDouble("Feedforward", 50., -100, 100, 0.01, "%");
-  GetParam(kFeedforward)->SetShape(1.);
-  GetParam(kFeedback)->InitDouble("Feedback", 0., -90., 90., 0.01, "%");
-  GetParam(kFeedback)->SetShape(1.);
+  InitParameters(this, parameters, kNumParams);
 
   IGraphics* pGraphics = MakeGraphics(this, kWidth, kHeight);
   pGraphics->AttachBackground(UNIVERSALDELAY_ID, UNIVERSALDELAY_FN);
@@ -70,13 +48,9 @@ ATKUniversalVariableDelay::ATKUniversalVariableDelay(IPlugInstanceInfo instanceI
 
   AttachGraphics(pGraphics);
 
-  MakePreset("Vibrato", 2, 1, 2, 0, 1, 0);
-  MakePreset("Flanger", 2, 1, 2, 0.7, 0.7, 0.7);
+  MakePreset("Vibrato", 2., 1., 2., 0., 100., 0., 0);
+  MakePreset("Flanger", 2., 1., 2., 70., 70., 70., 0);
 
-  delayFilter.set_input_port(0, &inFilter, 0);
-  delayFilter.set_input_port(1, &sinusGenerator, 0);
-  outFilter.set_input_port(0, &delayFilter, 0);
-  
   Reset();
 }
 
@@ -85,67 +59,43 @@ ATKUniversalVariableDelay::~ATKUniversalVariableDelay() {}
 void ATKUniversalVariableDelay::ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames)
 {
   // Mutex is already locked for us.
-  inFilter.set_pointer(inputs[0], nFrames);
-  outFilter.set_pointer(outputs[0], nFrames);
-  outFilter.process(nFrames);
+
+  dsp.process(inputs, outputs, nFrames);
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKUniversalVariableDelay::Reset()
 {
   TRACE;
   IMutexLock lock(this);
-  
-  int sampling_rate = GetSampleRate();
 
-  if (sampling_rate != outFilter.get_input_sampling_rate())
-  {
-    inFilter.set_input_sampling_rate(sampling_rate);
-    inFilter.set_output_sampling_rate(sampling_rate);
-    sinusGenerator.set_output_sampling_rate(sampling_rate);
-    delayFilter.set_input_sampling_rate(sampling_rate);
-    delayFilter.set_output_sampling_rate(sampling_rate);
-    outFilter.set_input_sampling_rate(sampling_rate);
-    outFilter.set_output_sampling_rate(sampling_rate);
-  }
-  sinusGenerator.full_setup();
-  delayFilter.full_setup();
+  dsp.set_sampling_rate(GetSampleRate());
+  UpdateTailSize(dsp.get_tail_length());
 }
 
 void ATKUniversalVariableDelay::OnParamChange(int paramIdx)
 {
-  IMutexLock lock(this);
-
+  // Keep the delay larger than the depth, the DSP would apply the same correction
   switch (paramIdx)
   {
   case kDelay:
-    if (GetParam(kDepth)->Value() > GetParam(kDelay)->Value() - 0.1)
-    {
-      GetParam(kDelay)->Set(GetParam(kDepth)->Value() + 0.1);
-    }
-    sinusGenerator.set_offset(GetParam(kDelay)->Value() / 1000. * GetSampleRate());
-    delayFilter.set_central_delay(GetParam(kDelay)->Value() / 1000. * GetSampleRate());
-    break;
   case kDepth:
-    if (GetParam(kDepth)->Value() > GetParam(kDelay)->Value() - 0.1)
-    {
-      GetParam(kDepth)->Set(GetParam(kDelay)->Value() - 0.1);
-    }
-    sinusGenerator.set_volume(GetParam(kDepth)->Value() / 1000. * GetSampleRate());
-    break;
-  case kMod:
-    sinusGenerator.set_frequency(GetParam(kMod)->Value());
-    break;
-  case kBlend:
-    delayFilter.set_blend((GetParam(kBlend)->Value()) / 100.);
-    break;
-  case kFeedforward:
-    delayFilter.set_feedforward((GetParam(kFeedforward)->Value()) / 100.);
-    break;
-  case kFeedback:
-    delayFilter.set_feedback((GetParam(kFeedback)->Value()) / 100.);
+    GetParam(paramIdx)->Set(constrained_parameter(paramIdx, GetParam(kDelay)->Value(), GetParam(kDepth)->Value()));
     break;
 
   default:
     break;
   }
+
+  dsp.post_parameter(paramIdx, GetParam(paramIdx)->Value());
+}
+
+void ATKUniversalVariableDelay::UpdateTailSize(int64_t tail_length)
+{
+  // the host is only told when the tail changes, not after every block
+  if (tail_length != this->tail_length)
+  {
+    this->tail_length = tail_length;
+    SetTailSize(static_cast<int>(tail_length));
+  }
 }
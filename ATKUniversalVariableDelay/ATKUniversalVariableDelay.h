@@ -3,12 +3,9 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 
-#include <ATK/Core/InPointerFilter.h>
-#include <ATK/Core/OutPointerFilter.h>
-#include <ATK/Delay/UniversalVariableDelayLineFilter.h>
-#include <ATK/Tools/SinusGeneratorFilter.h>
+#include "ATKUniversalVariableDelayDSP.h"
 
-class ATKUniversalVariableDelay : public IPlug
+class ATKUniversalVariableDelay : public IPlug, public ATKUniversalVariableDelayParameters
 {
 public:
   ATKUniversalVariableDelay(IPlugInstanceInfo instanceInfo);
@@ -19,10 +16,10 @@ public:
   void ProcessDoubleReplacing(double** inputs, double** outputs, int nFrames);
 
 private:
-  ATK::InPointerFilter<double> inFilter;
-  ATK::SinusGeneratorFilter<double> sinusGenerator;
-  ATK::UniversalVariableDelayLineFilter<double> delayFilter;
-  ATK::OutPointerFilter<double> outFilter;
+  void UpdateTailSize(int64_t tail_length);
+
+  ATKUniversalVariableDelayDSP<double> dsp;
+  int64_t tail_length;
 };
 
 #endif
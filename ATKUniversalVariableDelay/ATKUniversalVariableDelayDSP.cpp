@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ATKUniversalVariableDelayDSP.h"
+
+namespace
+{
+  // VariableDelayLineFilter::Interpolation
+  const char* const interpolation_names[] = {"Linear", "Lagrange", "Hermite", "Allpass"};
+}
+
+const ParameterInfo ATKUniversalVariableDelayParameters::parameters[kNumParams] =
+{
+  {"Delay", 0.2, 0.2, 3.0, 0.1, "ms", 2., false, NULL},
+  {"Depth", 0.1, 0.1, 2.9, 0.1, "ms", 2., false, NULL},
+  {"Modulation", 1, 0.1, 5.0, 0.1, "Hz", 1., false, NULL},
+  {"Blend", 100, -100, 100, 0.01, "%", 1., false, NULL},
+  {"Feedforward", 50., -100, 100, 0.01, "%", 1., false, NULL},
+  {"Feedback", 0., -90., 90., 0.01, "%", 1., false, NULL},
+  {"Interpolation", 0, 0, 3, 1, "", 1., false, interpolation_names}
+};
+
+double ATKUniversalVariableDelayParameters::constrained_parameter(int paramIdx, double delay, double depth)
+{
+  if (paramIdx == kDelay && depth > delay - 0.1)
+  {
+    return depth + 0.1;
+  }
+  if (paramIdx == kDepth && depth > delay - 0.1)
+  {
+    return delay - 0.1;
+  }
+  return paramIdx == kDelay ? delay : depth;
+}
+
+template<typename DataType_>
+ATKUniversalVariableDelayDSP<DataType_>::ATKUniversalVariableDelayDSP()
+  :inFilter(nullptr, 1, 0, false), delayFilter(1), outFilter(nullptr, 1, 0, false)
+{
+  delayFilter.set_input_port(0, &inFilter, 0);
+  delayFilter.set_input_port(1, &sinusGenerator, 0);
+  outFilter.set_input_port(0, &delayFilter, 0);
+
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    parameter_values[i] = parameters[i].default_value;
+  }
+  ramps.set_ramped(kDelay);
+  ramps.set_ramped(kDepth);
+  ramps.set_ramped(kBlend);
+  ramps.set_ramped(kFeedforward);
+  ramps.set_ramped(kFeedback);
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    set_parameter(i, parameter_values[i]);
+  }
+  set_sampling_rate(44100);
+}
+
+template<typename DataType_>
+ATKUniversalVariableDelayDSP<DataType_>::~ATKUniversalVariableDelayDSP() {}
+
+template<typename DataType_>
+void ATKUniversalVariableDelayDSP<DataType_>::process(DataType** inputs, DataType** outputs, int nFrames)
+{
+  parameter_queue.drain([this](int paramIdx, double value) { set_parameter(paramIdx, value); });
+
+  // silent inputs, and the tail of the last processed block has decayed
+  if (silence.skip_block(inputs, nb_inputs, nFrames, get_tail_length()))
+  {
+    silence.clear(outputs, nb_outputs, nFrames);
+    return;
+  }
+
+  // the control rate ramps are applied between chunks of ramps.get_period() samples
+  for (int offset = 0, size = 0; offset < nFrames; offset += size)
+  {
+    size = ramps.next_chunk(nFrames - offset);
+    ramps.advance(size, [this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+
+    inFilter.set_pointer(inputs[0] + offset, size);
+    outFilter.set_pointer(outputs[0] + offset, size);
+    outFilter.process(size);
+  }
+  silence.check_outputs(outputs, nb_outputs, nFrames);
+}
+
+template<typename DataType_>
+void ATKUniversalVariableDelayDSP<DataType_>::set_sampling_rate(int sampling_rate)
+{
+  ramps.set_sampling_rate(sampling_rate);
+
+  if (sampling_rate != outFilter.get_input_sampling_rate())
+  {
+    inFilter.set_input_sampling_rate(sampling_rate);
+    inFilter.set_output_sampling_rate(sampling_rate);
+    sinusGenerator.set_output_sampling_rate(sampling_rate);
+    delayFilter.set_input_sampling_rate(sampling_rate);
+    delayFilter.set_output_sampling_rate(sampling_rate);
+    outFilter.set_input_sampling_rate(sampling_rate);
+    outFilter.set_output_sampling_rate(sampling_rate);
+  }
+  // the largest delay, modulated by the largest depth
+  double max_delay = parameters[kDelay].max_value + parameters[kDepth].max_value;
+  delayFilter.set_max_delay(static_cast<int64_t>(std::ceil(max_delay / 1000. * sampling_rate)));
+  sinusGenerator.full_setup();
+  delayFilter.full_setup();
+  ramps.snap([this](int paramIdx, double value) { apply_parameter(paramIdx, value); });
+}
+
+template<typename DataType_>
+double ATKUniversalVariableDelayDSP<DataType_>::get_parameter(int paramIdx) const
+{
+  return parameter_values[paramIdx];
+}
+
+template<typename DataType_>
+void ATKUniversalVariableDelayDSP<DataType_>::post_parameter(int paramIdx, double value)
+{
+  parameter_queue.post(paramIdx, value);
+}
+
+template<typename DataType_>
+void ATKUniversalVariableDelayDSP<DataType_>::set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+{
+  ramps.set_smoothing(mode, time_ms);
+}
+
+template<typename DataType_>
+int64_t ATKUniversalVariableDelayDSP<DataType_>::get_tail_length() const
+{
+  // once for each pass through the feedback
+  double delay = (parameter_values[kDelay] + parameter_values[kDepth]) / 1000. * outFilter.get_output_sampling_rate();
+  return static_cast<int64_t>(delay * (1 + SilenceDetector<DataType>::decay_count(parameter_values[kFeedback] / 100.)));
+}
+
+template<typename DataType_>
+void ATKUniversalVariableDelayDSP<DataType_>::set_parameter(int paramIdx, double value)
+{
+  parameter_values[paramIdx] = value;
+  if (paramIdx == kDelay || paramIdx == kDepth)
+  {
+    parameter_values[paramIdx] = constrained_parameter(paramIdx, parameter_values[kDelay], parameter_values[kDepth]);
+  }
+
+  if (ramps.is_ramped(paramIdx))
+  {
+    ramps.set_target(paramIdx, parameter_values[paramIdx]);
+  }
+  else
+  {
+    apply_parameter(paramIdx, parameter_values[paramIdx]);
+  }
+}
+
+template<typename DataType_>
+void ATKUniversalVariableDelayDSP<DataType_>::apply_parameter(int paramIdx, double value)
+{
+  switch (paramIdx)
+  {
+  case kDelay:
+  case kDepth:
+  {
+    // both ramps move independently, keep the depth below the delay on the way
+    double delay = ramps.get_value(kDelay);
+    double depth = std::min(ramps.get_value(kDepth), delay - 0.1);
+    sinusGenerator.set_offset(delay / 1000. * outFilter.get_output_sampling_rate());
+    delayFilter.set_central_delay(delay / 1000. * outFilter.get_output_sampling_rate());
+    sinusGenerator.set_volume(depth / 1000. * outFilter.get_output_sampling_rate());
+    break;
+  }
+  case kMod:
+    sinusGenerator.set_frequency(value);
+    break;
+  case kBlend:
+    delayFilter.set_blend((value) / 100.);
+    break;
+  case kFeedforward:
+    delayFilter.set_feedforward((value) / 100.);
+    break;
+  case kFeedback:
+    delayFilter.set_feedback((value) / 100.);
+    break;
+  case kInterpolation:
+  {
+    int interpolation = std::min(std::max(static_cast<int>(value + .5), 0), 3);
+    delayFilter.set_interpolation(static_cast<typename VariableDelayLineFilter<DataType>::Interpolation>(interpolation));
+    break;
+  }
+
+  default:
+    break;
+  }
+}
+
+template class ATKUniversalVariableDelayDSP<float>;
+template class ATKUniversalVariableDelayDSP<double>;
@@ -0,0 +1,74 @@
+#ifndef __ATKUniversalVariableDelayDSP__
+#define __ATKUniversalVariableDelayDSP__
+
+#include "../common/ControlRateRamps.h"
+#include "../common/ParameterInfo.h"
+#include "../common/ParameterQueue.h"
+#include "../common/SilenceDetector.h"
+#include "../common/VariableDelayLineFilter.h"
+
+#include <ATK/Core/InPointerFilter.h>
+#include <ATK/Core/OutPointerFilter.h>
+#include <ATK/Tools/SinusGeneratorFilter.h>
+
+struct ATKUniversalVariableDelayParameters
+{
+  enum EParams
+  {
+    kDelay = 0,
+    kDepth,
+    kMod,
+    kBlend,
+    kFeedforward,
+    kFeedback,
+    kInterpolation,
+    kNumParams
+  };
+
+  static const ParameterInfo parameters[kNumParams];
+
+  // The delay must stay larger than the depth: returns the value of paramIdx (kDelay or kDepth)
+  // once corrected so that it does not cross the other one
+  static double constrained_parameter(int paramIdx, double delay, double depth);
+};
+
+// GUI-free processing graph of ATKUniversalVariableDelay, shared by the plugin and the offline tools
+template<typename DataType_>
+class ATKUniversalVariableDelayDSP : public ATKUniversalVariableDelayParameters
+{
+public:
+  typedef DataType_ DataType;
+
+  static const int nb_inputs = 1;
+  static const int nb_sidechain_inputs = 0;
+  static const int nb_outputs = 1;
+
+  ATKUniversalVariableDelayDSP();
+  ~ATKUniversalVariableDelayDSP();
+
+  void set_sampling_rate(int sampling_rate);
+  void set_parameter(int paramIdx, double value);
+  double get_parameter(int paramIdx) const;
+  // Can be called from any thread, the value is applied at the start of the next process call
+  void post_parameter(int paramIdx, double value);
+  // Shape and duration of the ramps following a parameter change
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms);
+  // Samples for the output and the state of the graph to fall below the silence threshold once the input stops
+  int64_t get_tail_length() const;
+  void process(DataType** inputs, DataType** outputs, int nFrames);
+
+private:
+  void apply_parameter(int paramIdx, double value);
+
+  double parameter_values[kNumParams];
+  ParameterQueue<kNumParams> parameter_queue;
+  ControlRateRamps<kNumParams> ramps;
+  SilenceDetector<DataType> silence;
+
+  ATK::InPointerFilter<DataType> inFilter;
+  ATK::SinusGeneratorFilter<DataType> sinusGenerator;
+  VariableDelayLineFilter<DataType> delayFilter;
+  ATK::OutPointerFilter<DataType> outFilter;
+};
+
+#endif
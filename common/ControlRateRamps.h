@@ -0,0 +1,119 @@
+#ifndef __ControlRateRamps__
+#define __ControlRateRamps__
+
+#include <algorithm>
+#include <cstdint>
+
+#include "ParameterSmoother.h"
+
+// Ramps the parameters whose coefficients are too expensive to update for every sample
+// While a ramp is running, the DSP processes its blocks in chunks of get_period() samples and
+// applies the ramped values between the chunks
+template<int NbParameters>
+class ControlRateRamps
+{
+  static_assert(NbParameters <= 64, "One ramp bit per parameter");
+public:
+  ControlRateRamps()
+    :period(32), ramped(0)
+  {
+  }
+
+  void set_ramped(int index)
+  {
+    ramped |= uint64_t(1) << index;
+  }
+
+  bool is_ramped(int index) const
+  {
+    return (ramped >> index) & 1;
+  }
+
+  void set_period(int period)
+  {
+    this->period = period;
+  }
+
+  int get_period() const
+  {
+    return period;
+  }
+
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+  {
+    for (int i = 0; i < NbParameters; ++i)
+    {
+      smoothers[i].set_smoothing(mode, time_ms);
+    }
+  }
+
+  void set_sampling_rate(int sampling_rate)
+  {
+    for (int i = 0; i < NbParameters; ++i)
+    {
+      smoothers[i].set_sampling_rate(sampling_rate);
+    }
+  }
+
+  void set_target(int index, double value)
+  {
+    smoothers[index].set_target(value);
+  }
+
+  double get_value(int index) const
+  {
+    return smoothers[index].get_value();
+  }
+
+  bool is_ramping() const
+  {
+    for (int i = 0; i < NbParameters; ++i)
+    {
+      if (smoothers[i].is_smoothing())
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Size of the next chunk to process out of the remaining samples of the block
+  int next_chunk(int remaining) const
+  {
+    return is_ramping() ? std::min(remaining, period) : remaining;
+  }
+
+  // Moves the running ramps by nb_samples and calls apply(index, value) for each of them
+  template<class Function>
+  void advance(int nb_samples, Function apply)
+  {
+    for (int i = 0; i < NbParameters; ++i)
+    {
+      if (smoothers[i].is_smoothing())
+      {
+        apply(i, smoothers[i].advance(nb_samples));
+      }
+    }
+  }
+
+  // Ends all the ramps and calls apply(index, value) with the target of each ramped parameter
+  template<class Function>
+  void snap(Function apply)
+  {
+    for (int i = 0; i < NbParameters; ++i)
+    {
+      if (is_ramped(i))
+      {
+        smoothers[i].snap();
+        apply(i, smoothers[i].get_value());
+      }
+    }
+  }
+
+private:
+  int period;
+  uint64_t ramped;
+  ParameterSmoother smoothers[NbParameters];
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef __CountedFilter__
+#define __CountedFilter__
+
+#include <cstdint>
+#include <utility>
+
+// Number of blocks a filter has processed
+class RunCounter
+{
+public:
+  RunCounter()
+    :nb_runs(0)
+  {
+  }
+
+  int64_t get_nb_runs() const
+  {
+    return nb_runs;
+  }
+
+  void reset_nb_runs()
+  {
+    nb_runs = 0;
+  }
+
+protected:
+  mutable int64_t nb_runs;
+};
+
+// Filter that counts the blocks it processes. The graphs are pulled from their outputs, so the
+// counts tell which filters the current routing reaches and which ones it leaves out
+template<class Filter>
+class CountedFilter : public Filter, public RunCounter
+{
+public:
+  template<typename... Args>
+  CountedFilter(Args&&... args)
+    :Filter(std::forward<Args>(args)...)
+  {
+  }
+
+protected:
+  void process_impl(int64_t size) const
+  {
+    ++nb_runs;
+    Filter::process_impl(size);
+  }
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef __DelayRingBuffer__
+#define __DelayRingBuffer__
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Circular buffer of a delay line, its size a power of two so that the positions wrap with a mask
+// The capacity is set from the longest delay and the sampling rate by the DSP classes, outside of
+// the audio thread: set_max_delay() allocates when the size changes
+template<typename DataType_>
+class DelayRingBuffer
+{
+public:
+  typedef DataType_ DataType;
+
+  DelayRingBuffer()
+    :buffer(1, 0), mask(0), max_delay(0), index(0)
+  {
+  }
+
+  // Keeps room for reading delay_extra samples beyond max_delay (interpolation taps), clears
+  void set_max_delay(int64_t max_delay, int64_t delay_extra = 1)
+  {
+    int64_t size = 1;
+    while (size < max_delay + delay_extra + 1)
+    {
+      size *= 2;
+    }
+    if (size != static_cast<int64_t>(buffer.size()))
+    {
+      std::vector<DataType>(size, 0).swap(buffer);
+      mask = size - 1;
+    }
+    this->max_delay = max_delay;
+    clear();
+  }
+
+  int64_t get_max_delay() const
+  {
+    return max_delay;
+  }
+
+  int64_t get_size() const
+  {
+    return static_cast<int64_t>(buffer.size());
+  }
+
+  void clear()
+  {
+    std::fill(buffer.begin(), buffer.end(), 0);
+    index = 0;
+  }
+
+  // The sample written delay samples before the next one
+  DataType read(int64_t delay) const
+  {
+    return buffer[(index - delay) & mask];
+  }
+
+  void write(DataType value)
+  {
+    buffer[index & mask] = value;
+    ++index;
+  }
+
+  // Copies the size samples starting delay samples back, delay >= size so that they are all written
+  void read_block(int64_t delay, int64_t size, DataType* output) const
+  {
+    int64_t start = (index - delay) & mask;
+    int64_t first = std::min<int64_t>(size, get_size() - start);
+    std::copy(buffer.begin() + start, buffer.begin() + start + first, output);
+    std::copy(buffer.begin(), buffer.begin() + (size - first), output + first);
+  }
+
+  void write_block(const DataType* input, int64_t size)
+  {
+    int64_t start = index & mask;
+    int64_t first = std::min<int64_t>(size, get_size() - start);
+    std::copy(input, input + first, buffer.begin() + start);
+    std::copy(input + first, input + size, buffer.begin());
+    index += size;
+  }
+
+  // Read-only copy of the current position, for loops that only read: its members stay in
+  // registers where stores to other buffers could alias the members of the ring buffer
+  class Reader
+  {
+  public:
+    Reader(const DataType* data, int64_t mask, int64_t index)
+      :data(data), mask(mask), index(index)
+    {
+    }
+
+    DataType read(int64_t delay) const
+    {
+      return data[(index - delay) & mask];
+    }
+
+  private:
+    const DataType* data;
+    int64_t mask;
+    int64_t index;
+  };
+
+  Reader get_reader() const
+  {
+    return Reader(buffer.data(), mask, index);
+  }
+
+private:
+  std::vector<DataType> buffer;
+  int64_t mask;
+  int64_t max_delay;
+  int64_t index;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef __FixedDelayLineFilter__
+#define __FixedDelayLineFilter__
+
+#include <algorithm>
+#include <cstdint>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+#include "DelayRingBuffer.h"
+
+// Drop-in replacement of ATK::UniversalFixedDelayLineFilter on a DelayRingBuffer
+// x_h[n] = x[n] + feedback * x_h[n - delay], y[n] = blend * x_h[n] + feedforward * x_h[n - delay]
+// The samples of a chunk no longer than the delay only depend on samples before the chunk, so the
+// chunk is computed from contiguous copies of the delay line with loops that vectorize. Delays
+// shorter than min_block_delay (comb filters) run sample by sample
+template<typename DataType_>
+class FixedDelayLineFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+
+public:
+  FixedDelayLineFilter(int64_t max_delay)
+    :Parent(1, 1), delay(1), blend(0), feedback(0), feedforward(1), block_processing(true)
+  {
+    set_max_delay(max_delay);
+  }
+
+  // Allocates, not while processing
+  void set_max_delay(int64_t max_delay)
+  {
+    buffer.set_max_delay(std::max<int64_t>(max_delay, 1));
+    delay = std::min(delay, buffer.get_max_delay());
+  }
+
+  int64_t get_max_delay() const
+  {
+    return buffer.get_max_delay();
+  }
+
+  // Clamped to [1, max_delay]
+  void set_delay(int64_t delay)
+  {
+    this->delay = std::max<int64_t>(1, std::min(delay, buffer.get_max_delay()));
+  }
+
+  int64_t get_delay() const
+  {
+    return delay;
+  }
+
+  void set_blend(DataType blend)
+  {
+    this->blend = blend;
+  }
+
+  void set_feedback(DataType feedback)
+  {
+    this->feedback = feedback;
+  }
+
+  void set_feedforward(DataType feedforward)
+  {
+    this->feedforward = feedforward;
+  }
+
+  // Sample by sample processing whatever the delay when false, the reference of the block path
+  void set_block_processing(bool block_processing)
+  {
+    this->block_processing = block_processing;
+  }
+
+  bool is_block_processing() const
+  {
+    return block_processing;
+  }
+
+  void full_setup()
+  {
+    Parent::full_setup();
+    buffer.clear();
+  }
+
+protected:
+  void process_impl(int64_t size) const
+  {
+    if (block_processing && delay >= min_block_delay)
+    {
+      process_blocks(size);
+      return;
+    }
+
+    const DataType* input = converted_inputs[0];
+    DataType* output = outputs[0];
+    for (int64_t i = 0; i < size; ++i)
+    {
+      DataType delayed = buffer.read(delay);
+      DataType processed = input[i] + feedback * delayed;
+      output[i] = blend * processed + feedforward * delayed;
+      buffer.write(processed);
+    }
+  }
+
+private:
+  static const int min_block_delay = 16;
+  static const int chunk_size = 256;
+
+  void process_blocks(int64_t size) const
+  {
+    const DataType feedback = this->feedback;
+    const DataType blend = this->blend;
+    const DataType feedforward = this->feedforward;
+    int64_t max_chunk = std::min<int64_t>(delay, chunk_size);
+    for (int64_t offset = 0; offset < size; offset += max_chunk)
+    {
+      int64_t chunk = std::min(max_chunk, size - offset);
+      const DataType* input = converted_inputs[0] + offset;
+      DataType* output = outputs[0] + offset;
+
+      buffer.read_block(delay, chunk, delayed);
+      for (int64_t i = 0; i < chunk; ++i)
+      {
+        processed[i] = input[i] + feedback * delayed[i];
+        output[i] = blend * processed[i] + feedforward * delayed[i];
+      }
+      buffer.write_block(processed, chunk);
+    }
+  }
+
+  mutable DelayRingBuffer<DataType> buffer;
+  int64_t delay;
+  DataType blend;
+  DataType feedback;
+  DataType feedforward;
+  bool block_processing;
+
+  mutable DataType delayed[chunk_size];
+  mutable DataType processed[chunk_size];
+};
+
+#endif
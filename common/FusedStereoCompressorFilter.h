@@ -0,0 +1,493 @@
+#ifndef __FusedStereoCompressorFilter__
+#define __FusedStereoCompressorFilter__
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+#include "GainCurveTable.h"
+#include "ParameterSmoother.h"
+
+// The whole graph of the stereo compressors in a single loop: middle/side split, power, gain
+// curve, attack/release, gain, makeup, middle/side merge and dry/wet
+// The two channels (left and right, or middle and side) are two lanes whose values and states
+// are stored side by side and computed by the same statements. When linked, the first lane
+// detects the sum of both powers and its gain is applied to both channels. A disabled channel
+// goes through unprocessed. With a side chain, the powers are detected on the inputs 2 and 3
+// (split in middle/side like the processed ones) instead of the inputs 0 and 1, unless
+// set_sidechain turns it off
+// Each combination of middle/side, link and enabled channels is a loop of its own, compiled
+// ahead. The setters of the routing only update an atomic word that the next process call reads
+// once, switching to the new loop for the whole call, so they can be called from any thread.
+// During the optional crossfade, the previous loop keeps running on a copy of the state and its
+// output is faded out
+// Same conventions as FusedCompressorFilter, with the parameters given for each lane
+template<typename DataType_>
+class FusedStereoCompressorFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+
+public:
+  static const int nb_lanes = 2;
+
+  // Bits of the routing word
+  enum RoutingFlags
+  {
+    kMiddleSideRouting = 1,
+    kLinkedRouting = 2,
+    kEnabled1Routing = 4,
+    kEnabled2Routing = 8,
+    nb_routings = 16
+  };
+
+  FusedStereoCompressorFilter(bool sidechain = false)
+    :Parent(sidechain ? 2 * nb_lanes : nb_lanes, nb_lanes), sidechain(sidechain), tabulated(false), memory(0),
+    routing(kEnabled1Routing | kEnabled2Routing), active_routing(kEnabled1Routing | kEnabled2Routing), fading_routing(0),
+    crossfade_ms(0), crossfade_length(0), fade_remaining(0)
+  {
+    for (int lane = 0; lane < nb_lanes; ++lane)
+    {
+      threshold[lane] = 1;
+      ratio[lane] = 1;
+      softness[lane] = static_cast<DataType>(.0001);
+      attack[lane] = 1;
+      release[lane] = 1;
+      state.power[lane] = 0;
+      state.gain[lane] = 0;
+      state.makeup[lane].set_target(1);
+      state.makeup[lane].snap();
+    }
+    state.dry.set_target(1);
+    state.dry.snap();
+    fading_state = state;
+    select_loops();
+  }
+
+  void set_middleside(bool middleside)
+  {
+    set_routing_bit(kMiddleSideRouting, middleside);
+  }
+
+  void set_linked(bool linked)
+  {
+    set_routing_bit(kLinkedRouting, linked);
+  }
+
+  void set_enabled(int lane, bool enabled)
+  {
+    set_routing_bit(lane == 0 ? kEnabled1Routing : kEnabled2Routing, enabled);
+  }
+
+  // For a filter built with a side chain, detects the powers on the inputs 2 and 3 or, when the
+  // side chain is not connected, on the inputs 0 and 1 without reading the other ones. Not while
+  // processing
+  void set_sidechain(bool sidechain)
+  {
+    this->sidechain = sidechain;
+    select_loops();
+  }
+
+  // Duration of the crossfade between two routings, 0 to switch at once
+  void set_routing_crossfade(double time_ms)
+  {
+    crossfade_ms = time_ms;
+    update_crossfade_length();
+  }
+
+  void set_memory(DataType memory)
+  {
+    this->memory = memory;
+  }
+
+  void set_threshold(int lane, DataType threshold)
+  {
+    this->threshold[lane] = threshold;
+  }
+
+  void set_ratio(int lane, DataType ratio)
+  {
+    this->ratio[lane] = ratio;
+    request_curve(lane);
+  }
+
+  void set_softness(int lane, DataType softness)
+  {
+    this->softness[lane] = softness;
+    request_curve(lane);
+  }
+
+  void set_attack(int lane, DataType attack)
+  {
+    this->attack[lane] = attack;
+  }
+
+  void set_release(int lane, DataType release)
+  {
+    this->release[lane] = release;
+  }
+
+  void set_volume_db(int lane, double volume_db)
+  {
+    state.makeup[lane].set_target(std::pow(10., volume_db / 20));
+  }
+
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+  {
+    for (int lane = 0; lane < nb_lanes; ++lane)
+    {
+      state.makeup[lane].set_smoothing(mode, time_ms);
+    }
+    state.dry.set_smoothing(mode, time_ms);
+  }
+
+  void set_dry(double dry)
+  {
+    state.dry.set_target(dry);
+  }
+
+  // Gain curves read from GainCurveTables, not to be changed while processing
+  void set_tabulated(bool tabulated, bool background_build)
+  {
+    this->tabulated = tabulated;
+    for (int lane = 0; lane < nb_lanes; ++lane)
+    {
+      // the first curves are built right away
+      tables[lane].set_background_build(false);
+      request_curve(lane);
+      tables[lane].set_background_build(tabulated && background_build);
+    }
+    select_loops();
+  }
+
+  void full_setup()
+  {
+    Parent::full_setup();
+    for (int lane = 0; lane < nb_lanes; ++lane)
+    {
+      state.power[lane] = 0;
+      state.gain[lane] = 0;
+      state.makeup[lane].snap();
+    }
+    state.dry.snap();
+    fade_remaining = 0;
+  }
+
+protected:
+  // State of the loops, copied for the routing that fades out
+  struct State
+  {
+    DataType power[nb_lanes];
+    DataType gain[nb_lanes];
+    ParameterSmoother makeup[nb_lanes];
+    ParameterSmoother dry;
+  };
+
+  typedef void (FusedStereoCompressorFilter::*Loop)(State& state, int64_t offset, int64_t size, DataType* output_left, DataType* output_right) const;
+
+  // Largest number of samples of the previous routing rendered at once during a crossfade
+  static const int fade_chunk = 64;
+
+  void setup()
+  {
+    Parent::setup();
+    for (int lane = 0; lane < nb_lanes; ++lane)
+    {
+      state.makeup[lane].set_sampling_rate(this->get_output_sampling_rate());
+      state.makeup[lane].snap();
+    }
+    state.dry.set_sampling_rate(this->get_output_sampling_rate());
+    state.dry.snap();
+    update_crossfade_length();
+  }
+
+  void process_impl(int64_t size) const
+  {
+    if (tabulated)
+    {
+      for (int lane = 0; lane < nb_lanes; ++lane)
+      {
+        tables[lane].acquire();
+      }
+    }
+
+    int requested = routing.load(std::memory_order_acquire);
+    if (requested != active_routing)
+    {
+      // a routing that changes again during a crossfade keeps fading out the first one
+      if (crossfade_length > 0 && fade_remaining == 0)
+      {
+        fading_routing = active_routing;
+        fading_loop = active_loop;
+        fading_state = state;
+        fade_remaining = crossfade_length;
+      }
+      active_routing = requested;
+      active_loop = select_loop(active_routing);
+    }
+
+    DataType* output_left = outputs[0];
+    DataType* output_right = outputs[1];
+    int64_t offset = 0;
+    while (fade_remaining > 0 && offset < size)
+    {
+      int64_t chunk = std::min<int64_t>(std::min<int64_t>(size - offset, fade_remaining), static_cast<int64_t>(fade_chunk));
+      DataType faded_left[fade_chunk];
+      DataType faded_right[fade_chunk];
+      (this->*fading_loop)(fading_state, offset, chunk, faded_left, faded_right);
+      (this->*active_loop)(state, offset, chunk, output_left + offset, output_right + offset);
+
+      DataType step = static_cast<DataType>(1. / crossfade_length);
+      DataType fade_in = (crossfade_length - fade_remaining) * step;
+      for (int64_t i = 0; i < chunk; ++i)
+      {
+        fade_in += step;
+        output_left[offset + i] = faded_left[i] + fade_in * (output_left[offset + i] - faded_left[i]);
+        output_right[offset + i] = faded_right[i] + fade_in * (output_right[offset + i] - faded_right[i]);
+      }
+      fade_remaining -= chunk;
+      offset += chunk;
+    }
+    if (offset < size)
+    {
+      (this->*active_loop)(state, offset, size - offset, output_left + offset, output_right + offset);
+    }
+  }
+
+private:
+  void set_routing_bit(int bit, bool set)
+  {
+    if (set)
+    {
+      routing.fetch_or(bit, std::memory_order_release);
+    }
+    else
+    {
+      routing.fetch_and(~bit, std::memory_order_release);
+    }
+  }
+
+  void update_crossfade_length()
+  {
+    crossfade_length = static_cast<int64_t>(crossfade_ms * 1e-3 * this->get_output_sampling_rate());
+    fade_remaining = std::min(fade_remaining, crossfade_length);
+  }
+
+  void request_curve(int lane)
+  {
+    if (tabulated)
+    {
+      tables[lane].request(ratio[lane], softness[lane]);
+    }
+  }
+
+  void select_loops()
+  {
+    active_loop = select_loop(active_routing);
+    fading_loop = select_loop(fading_routing);
+  }
+
+  Loop select_loop(int routing) const
+  {
+    if (sidechain)
+    {
+      return tabulated ? routing_loops<true, true>(routing) : routing_loops<true, false>(routing);
+    }
+    return tabulated ? routing_loops<false, true>(routing) : routing_loops<false, false>(routing);
+  }
+
+  template<bool SideChain, bool Tabulated>
+  static Loop routing_loops(int routing)
+  {
+    static const Loop loops[nb_routings] =
+    {
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 0>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 1>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 2>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 3>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 4>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 5>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 6>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 7>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 8>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 9>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 10>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 11>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 12>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 13>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 14>,
+      &FusedStereoCompressorFilter::process_loop<SideChain, Tabulated, 15>
+    };
+    return loops[routing];
+  }
+
+  template<bool SideChain, bool Tabulated, int Routing>
+  void process_loop(State& state, int64_t offset, int64_t size, DataType* output_left, DataType* output_right) const
+  {
+    const bool MiddleSide = (Routing & kMiddleSideRouting) != 0;
+    const bool Linked = (Routing & kLinkedRouting) != 0;
+    const bool enabled[nb_lanes] = {(Routing & kEnabled1Routing) != 0, (Routing & kEnabled2Routing) != 0};
+
+    const DataType* left = converted_inputs[0] + offset;
+    const DataType* right = converted_inputs[1] + offset;
+    const DataType* detected_left = SideChain ? converted_inputs[2] + offset : left;
+    const DataType* detected_right = SideChain ? converted_inputs[3] + offset : right;
+
+    // scaled in double precision, like ATK::VolumeFilter does in the graph
+    const double split = std::sqrt(.5);
+
+    DataType current_power[nb_lanes];
+    DataType current_gain[nb_lanes];
+    DataType current_makeup[nb_lanes];
+    DataType inv_threshold[nb_lanes];
+    DataType lane_threshold[nb_lanes];
+    DataType lane_attack[nb_lanes];
+    DataType lane_release[nb_lanes];
+    // like in the graph, a detector only runs when its gain is applied: the first one for both
+    // lanes when linked, and its state is kept while it does not run
+    const bool detecting[nb_lanes] = {enabled[0] || (Linked && enabled[1]), !Linked && enabled[1]};
+    bool ramping = state.dry.is_smoothing();
+    for (int lane = 0; lane < nb_lanes; ++lane)
+    {
+      current_power[lane] = state.power[lane];
+      current_gain[lane] = state.gain[lane];
+      current_makeup[lane] = static_cast<DataType>(state.makeup[lane].get_value());
+      inv_threshold[lane] = 1 / threshold[lane];
+      lane_threshold[lane] = threshold[lane];
+      lane_attack[lane] = attack[lane];
+      lane_release[lane] = release[lane];
+      ramping = ramping || state.makeup[lane].is_smoothing();
+    }
+    DataType current_dry = static_cast<DataType>(state.dry.get_value());
+
+    for (int64_t i = 0; i < size; ++i)
+    {
+      DataType x[nb_lanes];
+      DataType detected_x[nb_lanes];
+      if (MiddleSide)
+      {
+        x[0] = static_cast<DataType>(split * static_cast<DataType>(left[i] + right[i]));
+        x[1] = static_cast<DataType>(split * static_cast<DataType>(left[i] - right[i]));
+        if (SideChain)
+        {
+          detected_x[0] = static_cast<DataType>(split * static_cast<DataType>(detected_left[i] + detected_right[i]));
+          detected_x[1] = static_cast<DataType>(split * static_cast<DataType>(detected_left[i] - detected_right[i]));
+        }
+        else
+        {
+          detected_x[0] = x[0];
+          detected_x[1] = x[1];
+        }
+      }
+      else
+      {
+        x[0] = left[i];
+        x[1] = right[i];
+        detected_x[0] = detected_left[i];
+        detected_x[1] = detected_right[i];
+      }
+
+      for (int lane = 0; lane < nb_lanes; ++lane)
+      {
+        current_power[lane] = (1 - memory) * detected_x[lane] * detected_x[lane] + memory * current_power[lane];
+      }
+
+      DataType detected[nb_lanes] = {current_power[0], current_power[1]};
+      if (Linked)
+      {
+        detected[0] = current_power[0] + current_power[1];
+      }
+
+      for (int lane = 0; lane < nb_lanes; ++lane)
+      {
+        if (!detecting[lane])
+        {
+          continue;
+        }
+        DataType static_gain;
+        if (Tabulated)
+        {
+          static_gain = tables[lane].get_gain(detected[lane] * inv_threshold[lane]);
+        }
+        else
+        {
+          static_gain = static_cast<DataType>(GainCurveTable<DataType>::gain(detected[lane] / lane_threshold[lane], ratio[lane], softness[lane]));
+        }
+
+        if (static_gain > current_gain[lane])
+          current_gain[lane] = (1 - lane_attack[lane]) * static_gain + lane_attack[lane] * current_gain[lane];
+        else
+          current_gain[lane] = (1 - lane_release[lane]) * static_gain + lane_release[lane] * current_gain[lane];
+      }
+
+      if (ramping)
+      {
+        // the makeup of a disabled lane is not applied, its ramp waits for the lane to be enabled
+        for (int lane = 0; lane < nb_lanes; ++lane)
+        {
+          if (enabled[lane])
+          {
+            current_makeup[lane] = static_cast<DataType>(state.makeup[lane].next());
+          }
+        }
+        current_dry = static_cast<DataType>(state.dry.next());
+      }
+
+      DataType processed[nb_lanes];
+      for (int lane = 0; lane < nb_lanes; ++lane)
+      {
+        DataType applied_gain = Linked ? current_gain[0] : current_gain[lane];
+        processed[lane] = enabled[lane] ? current_makeup[lane] * (applied_gain * x[lane]) : x[lane];
+      }
+
+      if (MiddleSide)
+      {
+        DataType merged_left = static_cast<DataType>(split * static_cast<DataType>(processed[0] + processed[1]));
+        DataType merged_right = static_cast<DataType>(split * static_cast<DataType>(processed[0] - processed[1]));
+        output_left[i] = current_dry * merged_left + (1 - current_dry) * left[i];
+        output_right[i] = current_dry * merged_right + (1 - current_dry) * right[i];
+      }
+      else
+      {
+        output_left[i] = current_dry * processed[0] + (1 - current_dry) * left[i];
+        output_right[i] = current_dry * processed[1] + (1 - current_dry) * right[i];
+      }
+    }
+
+    for (int lane = 0; lane < nb_lanes; ++lane)
+    {
+      state.power[lane] = current_power[lane];
+      state.gain[lane] = current_gain[lane];
+    }
+  }
+
+  bool sidechain;
+  bool tabulated;
+  DataType memory;
+  DataType threshold[nb_lanes];
+  DataType ratio[nb_lanes];
+  DataType softness[nb_lanes];
+  DataType attack[nb_lanes];
+  DataType release[nb_lanes];
+
+  // routing requested by the setters, and the ones the loops use
+  std::atomic<int> routing;
+  mutable int active_routing;
+  mutable int fading_routing;
+  mutable Loop active_loop;
+  mutable Loop fading_loop;
+  double crossfade_ms;
+  int64_t crossfade_length;
+  mutable int64_t fade_remaining;
+
+  mutable State state;
+  mutable State fading_state;
+  mutable GainCurveTable<DataType> tables[nb_lanes];
+};
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef __GainCurveTable__
+#define __GainCurveTable__
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread building the curves of all the GainCurveTables set to background build, started with
+// the first one and stopped with the last one
+class GainCurveBuilder
+{
+public:
+  class Client
+  {
+  public:
+    virtual ~Client() {}
+    // Builder thread, builds the last requested curve if it is not the published one
+    virtual void update() = 0;
+  };
+
+  static GainCurveBuilder& get()
+  {
+    static GainCurveBuilder builder;
+    return builder;
+  }
+
+  void add(Client* client)
+  {
+    std::lock_guard<std::mutex> lifetime(lifetime_mutex);
+    {
+      std::lock_guard<std::mutex> lock(clients_mutex);
+      clients.push_back(client);
+    }
+    if (!thread.joinable())
+    {
+      running = true;
+      thread = std::thread([this]() { run(); });
+    }
+  }
+
+  // Once it returns, the builder thread does not use the client anymore
+  void remove(Client* client)
+  {
+    std::lock_guard<std::mutex> lifetime(lifetime_mutex);
+    bool last;
+    {
+      std::lock_guard<std::mutex> lock(clients_mutex);
+      clients.erase(std::find(clients.begin(), clients.end(), client));
+      last = clients.empty();
+    }
+    if (last)
+    {
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        running = false;
+      }
+      wake.notify_one();
+      thread.join();
+    }
+  }
+
+  // Audio thread, never waits for the builder: returns false if the builder holds the wake
+  // mutex (only while it goes to sleep), in which case the caller tries again later
+  bool request_update()
+  {
+    if (!wake_mutex.try_lock())
+    {
+      return false;
+    }
+    pending = true;
+    wake_mutex.unlock();
+    wake.notify_one();
+    return true;
+  }
+
+private:
+  GainCurveBuilder()
+    :pending(false), running(false)
+  {
+  }
+
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    while (true)
+    {
+      wake.wait(lock, [this]() { return pending || !running; });
+      if (!running)
+      {
+        return;
+      }
+      pending = false;
+      lock.unlock();
+      {
+        std::lock_guard<std::mutex> clients_lock(clients_mutex);
+        for (Client* client : clients)
+        {
+          client->update();
+        }
+      }
+      lock.lock();
+    }
+  }
+
+  std::mutex lifetime_mutex;
+  std::mutex clients_mutex;
+  std::vector<Client*> clients;
+
+  std::thread thread;
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+  bool pending;
+  bool running;
+};
+
+// Static gain curve of ATK::GainCompressorFilter for one ratio and softness, tabulated against
+// power / threshold so that the threshold can change without a rebuild
+// The table is indexed by the bits of the value as a float, that is a piecewise linear log2 with
+// 32 segments per octave, from -96 dB to +96 dB relative to the threshold (values outside are
+// clamped). The gain is interpolated linearly inside each segment, the error is at most 0.0062 dB
+// for ratios from 1 to 100 and softness from 1e-4 to 1 (measured by `benchmark --gain-curve`)
+//
+// The curves are triple buffered: a builder (the audio thread itself, or the GainCurveBuilder
+// thread) fills a spare curve and publishes it, the audio thread picks the last published one up
+// in acquire()
+template<typename DataType_>
+class GainCurveTable : public GainCurveBuilder::Client
+{
+public:
+  typedef DataType_ DataType;
+
+  // Reference evaluation, same formula as ATK::GainCompressorFilter
+  static double gain(double value, double ratio, double softness)
+  {
+    if (value == 0)
+    {
+      return 1;
+    }
+    double diff = 10 * std::log10(value);
+    return std::pow(10, -(std::sqrt(diff * diff + softness) + diff) / 40 * (ratio - 1) / ratio);
+  }
+
+  GainCurveTable()
+    :requested_ratio(1), requested_softness(.0001), requested(1), built(0), middle(1), front(0), back(2),
+    background(false), wake_pending(false), requested_in_block(false), ramping(false)
+  {
+    update();
+    take_published();
+  }
+
+  ~GainCurveTable()
+  {
+    set_background_build(false);
+  }
+
+  // With a background build, request() only wakes the GainCurveBuilder thread up and the audio
+  // thread keeps the previous curve for the time of the rebuild. Not to be changed while processing
+  // The next request() without a background build is built right away
+  void set_background_build(bool background)
+  {
+    requested_in_block = false;
+    ramping = false;
+    if (background == this->background)
+    {
+      return;
+    }
+    this->background = background;
+    wake_pending = false;
+    if (background)
+    {
+      GainCurveBuilder::get().add(this);
+      wake_pending = !GainCurveBuilder::get().request_update();
+    }
+    else
+    {
+      GainCurveBuilder::get().remove(this);
+    }
+  }
+
+  // Audio thread, when the parameters change. Never waits for the builder thread
+  // Without a background build, a single change is built right away, but a ramp (changes in
+  // consecutive blocks) only at its first step, then in acquire() once it has settled
+  void request(double ratio, double softness)
+  {
+    requested_ratio.store(ratio, std::memory_order_relaxed);
+    requested_softness.store(softness, std::memory_order_relaxed);
+    requested.fetch_add(1, std::memory_order_release);
+    if (background)
+    {
+      wake_pending = !GainCurveBuilder::get().request_update();
+    }
+    else
+    {
+      if (!ramping)
+      {
+        update();
+        take_published();
+      }
+      requested_in_block = true;
+    }
+  }
+
+  // Builds the last requested curve if it is not the published one, on the builder thread with
+  // a background build, on the audio thread otherwise
+  void update()
+  {
+    uint32_t generation = requested.load(std::memory_order_acquire);
+    if (generation == built)
+    {
+      return;
+    }
+    built = generation;
+    build(curves[back], requested_ratio.load(std::memory_order_relaxed), requested_softness.load(std::memory_order_relaxed));
+    back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index_mask;
+  }
+
+  // Audio thread, at the start of a block: switches to the last published curve
+  void acquire()
+  {
+    if (background)
+    {
+      if (wake_pending)
+      {
+        wake_pending = !GainCurveBuilder::get().request_update();
+      }
+    }
+    else
+    {
+      if (ramping && !requested_in_block)
+      {
+        update();
+      }
+      ramping = requested_in_block;
+      requested_in_block = false;
+    }
+    take_published();
+  }
+
+  // Audio thread, gain for value = power / threshold
+  DataType get_gain(DataType value) const
+  {
+    const DataType* gains = curves[front];
+    // the comparisons also send NaN to the first entry
+    value = value > static_cast<DataType>(min_value) ? value : static_cast<DataType>(min_value);
+    value = value < static_cast<DataType>(max_value) ? value : static_cast<DataType>(max_value);
+    float single = static_cast<float>(value);
+    uint32_t bits;
+    std::memcpy(&bits, &single, sizeof(bits));
+
+    uint32_t position = bits - min_bits;
+    uint32_t index = position >> fraction_bits;
+    DataType fraction = static_cast<DataType>(position & fraction_mask) * static_cast<DataType>(1. / (1 << fraction_bits));
+    return gains[index] + fraction * (gains[index + 1] - gains[index]);
+  }
+
+private:
+  static const int segments_bits = 5;
+  static const int fraction_bits = 23 - segments_bits;
+  static const uint32_t fraction_mask = (uint32_t(1) << fraction_bits) - 1;
+  static const int min_exponent = -32;
+  static const int max_exponent = 32;
+  static const int nb_nodes = ((max_exponent - min_exponent) << segments_bits) + 1;
+  static const uint32_t min_bits = uint32_t(127 + min_exponent) << 23;
+  static const int fresh = 4;
+  static const int index_mask = 3;
+
+  static constexpr double min_value = 1. / (uint64_t(1) << -min_exponent);
+  static constexpr double max_value = double(uint64_t(1) << max_exponent);
+
+  static void build(DataType* gains, double ratio, double softness)
+  {
+    for (int i = 0; i < nb_nodes; ++i)
+    {
+      double mantissa = 1 + static_cast<double>(i & ((1 << segments_bits) - 1)) / (1 << segments_bits);
+      double value = std::ldexp(mantissa, min_exponent + (i >> segments_bits));
+      gains[i] = static_cast<DataType>(gain(value, ratio, softness));
+    }
+    // the last node is read as the upper end of the clamped values
+    gains[nb_nodes] = gains[nb_nodes - 1];
+  }
+
+  void take_published()
+  {
+    if (middle.load(std::memory_order_relaxed) & fresh)
+    {
+      front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+    }
+  }
+
+  DataType curves[3][nb_nodes + 1];
+
+  std::atomic<double> requested_ratio;
+  std::atomic<double> requested_softness;
+  std::atomic<uint32_t> requested;
+  uint32_t built;
+
+  // index of the published curve, with the fresh bit until the audio thread takes it
+  std::atomic<int> middle;
+  int front;
+  int back;
+
+  bool background;
+  // the builder thread could not be woken up, acquire() tries again
+  bool wake_pending;
+  // synchronous build only: a request came since the last acquire(), and one came in the block before
+  bool requested_in_block;
+  bool ramping;
+};
+
+#endif
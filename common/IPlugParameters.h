@@ -0,0 +1,36 @@
+#ifndef __IPlugParameters__
+#define __IPlugParameters__
+
+#include "IPlug_include_in_plug_hdr.h"
+
+#include "ParameterInfo.h"
+
+// Declares the plugin parameters to IPlug from the table exposed by the DSP class
+inline void InitParameters(IPlugBase* plug, const ParameterInfo* parameters, int nb_parameters)
+{
+  for (int i = 0; i < nb_parameters; ++i)
+  {
+    const ParameterInfo& info = parameters[i];
+    if (info.boolean)
+    {
+      plug->GetParam(i)->InitBool(info.name, info.default_value != 0, info.label);
+    }
+    else if (info.value_names)
+    {
+      int nb_values = static_cast<int>(info.max_value) + 1;
+      plug->GetParam(i)->InitEnum(info.name, static_cast<int>(info.default_value), nb_values, info.label);
+      for (int value = 0; value < nb_values; ++value)
+      {
+        plug->GetParam(i)->SetDisplayText(value, info.value_names[value]);
+      }
+    }
+    else
+    {
+      //arguments are: name, defaultVal, minVal, maxVal, step, label
+      plug->GetParam(i)->InitDouble(info.name, info.default_value, info.min_value, info.max_value, info.step, info.label);
+      plug->GetParam(i)->SetShape(info.shape);
+    }
+  }
+}
+
+#endif
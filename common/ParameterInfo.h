@@ -0,0 +1,20 @@
+#ifndef __ParameterInfo__
+#define __ParameterInfo__
+
+// Description of a plugin parameter, independent of the plugin framework so that the
+// DSP classes can be used both by the IPlug front ends and by the offline tools
+struct ParameterInfo
+{
+  const char* name;
+  double default_value;
+  double min_value;
+  double max_value;
+  double step;
+  const char* label;
+  double shape;
+  bool boolean;
+  // Names of the values of an enumerated parameter, from 0 to max_value, NULL otherwise
+  const char* const* value_names;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef __ParameterQueue__
+#define __ParameterQueue__
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free delivery of parameter changes from the host or GUI threads to the audio thread
+// Changes to the same parameter are coalesced: the audio thread only sees the last value posted
+// before it drains the queue, so the queue can never overflow, whatever the automation rate
+template<int NbParameters>
+class ParameterQueue
+{
+  static_assert(NbParameters <= 64, "One pending bit per parameter");
+public:
+  ParameterQueue()
+    :pending(0)
+  {
+    for (int i = 0; i < NbParameters; ++i)
+    {
+      values[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Producer side, wait-free, can be called from several threads
+  void post(int index, double value)
+  {
+    values[index].store(value, std::memory_order_relaxed);
+    pending.fetch_or(uint64_t(1) << index, std::memory_order_release);
+  }
+
+  // Consumer side, calls apply(index, value) for each parameter posted since the last drain
+  template<class Function>
+  void drain(Function apply)
+  {
+    uint64_t changed = pending.exchange(0, std::memory_order_acquire);
+    for (int index = 0; changed != 0; ++index, changed >>= 1)
+    {
+      if (changed & 1)
+      {
+        apply(index, values[index].load(std::memory_order_relaxed));
+      }
+    }
+  }
+
+private:
+  std::atomic<double> values[NbParameters];
+  std::atomic<uint64_t> pending;
+};
+
+#endif
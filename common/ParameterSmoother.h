@@ -0,0 +1,127 @@
+#ifndef __ParameterSmoother__
+#define __ParameterSmoother__
+
+#include <cmath>
+#include <cstdint>
+
+// Moves a value towards its target over a fixed time, either linearly or with a one pole filter
+// Both modes reach the target exactly at the end of the smoothing time, the one pole is then
+// within 0.1% of the step and snaps to the target
+class ParameterSmoother
+{
+public:
+  enum Mode
+  {
+    kLinear = 0,
+    kOnePole
+  };
+
+  ParameterSmoother()
+    :mode(kLinear), time_ms(20), sampling_rate(44100), length(0), remaining(0), value(0), target(0), step(0), coefficient(0)
+  {
+    update_length();
+  }
+
+  void set_smoothing(Mode mode, double time_ms)
+  {
+    this->mode = mode;
+    this->time_ms = time_ms;
+    update_length();
+  }
+
+  void set_sampling_rate(int sampling_rate)
+  {
+    this->sampling_rate = sampling_rate;
+    update_length();
+  }
+
+  void set_target(double target)
+  {
+    this->target = target;
+    remaining = length;
+    if (remaining == 0)
+    {
+      value = target;
+    }
+    step = remaining > 0 ? (target - value) / remaining : 0;
+  }
+
+  // Jumps to the target
+  void snap()
+  {
+    value = target;
+    remaining = 0;
+  }
+
+  double get_value() const
+  {
+    return value;
+  }
+
+  double get_target() const
+  {
+    return target;
+  }
+
+  bool is_smoothing() const
+  {
+    return remaining > 0;
+  }
+
+  // Value for the next sample
+  double next()
+  {
+    if (remaining > 0)
+    {
+      if (--remaining == 0)
+        value = target;
+      else if (mode == kLinear)
+        value += step;
+      else
+        value = target + coefficient * (value - target);
+    }
+    return value;
+  }
+
+  // Skips nb_samples at once, for the parameters updated at control rate
+  double advance(int64_t nb_samples)
+  {
+    if (nb_samples >= remaining)
+    {
+      snap();
+    }
+    else if (nb_samples > 0)
+    {
+      remaining -= nb_samples;
+      if (mode == kLinear)
+        value += step * nb_samples;
+      else
+        value = target + std::pow(coefficient, static_cast<double>(nb_samples)) * (value - target);
+    }
+    return value;
+  }
+
+private:
+  void update_length()
+  {
+    length = static_cast<int64_t>(time_ms * 1e-3 * sampling_rate);
+    // the one pole has decayed by 60 dB at the end of the smoothing time
+    coefficient = length > 0 ? std::exp(std::log(1e-3) / length) : 0;
+    if (remaining > length)
+    {
+      set_target(target);
+    }
+  }
+
+  Mode mode;
+  double time_ms;
+  int sampling_rate;
+  int64_t length;
+  int64_t remaining;
+  double value;
+  double target;
+  double step;
+  double coefficient;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef __SilenceDetector__
+#define __SilenceDetector__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Tells the DSP classes when they can skip their graph for a block: all the inputs have been
+// below the threshold for longer than the tail of the plugin (the time its state, delay lines,
+// filters, envelopes, takes to decay below the threshold), and the outputs of the last processed
+// block were below the threshold too. A skipped block outputs zeros, the state of the graph is
+// left as it was and the processing resumes from it with the first block that is not silent
+template<typename DataType_>
+class SilenceDetector
+{
+public:
+  typedef DataType_ DataType;
+
+  // -120 dB
+  static DataType threshold()
+  {
+    return static_cast<DataType>(1e-6);
+  }
+
+  // Time an exponential decay of that time constant takes from full scale to the threshold
+  static double decay_time(double time_constant)
+  {
+    return time_constant * std::log(1e6);
+  }
+
+  // Number of times a recirculating signal goes through a feedback gain before it is below the threshold
+  static double decay_count(double feedback)
+  {
+    feedback = std::abs(feedback);
+    return feedback < threshold() ? 0 : std::ceil(std::log(1e-6) / std::log(feedback));
+  }
+
+  SilenceDetector()
+    :silent_samples(0), silent_outputs(false)
+  {
+  }
+
+  void reset()
+  {
+    silent_samples = 0;
+    silent_outputs = false;
+  }
+
+  // Before processing the block, true if it can be skipped. gain is the largest amplification from
+  // the inputs to the outputs (makeup), the inputs must be below the threshold once amplified
+  bool skip_block(DataType** inputs, int nb_inputs, int size, int64_t tail_length, double gain = 1)
+  {
+    const DataType limit = static_cast<DataType>(threshold() / std::max(gain, 1.));
+    for (int channel = 0; channel < nb_inputs; ++channel)
+    {
+      const DataType* input = inputs[channel];
+      for (int i = 0; i < size; ++i)
+      {
+        if (std::abs(input[i]) > limit)
+        {
+          silent_samples = 0;
+          silent_outputs = false;
+          return false;
+        }
+      }
+    }
+    if (silent_outputs && silent_samples >= tail_length)
+    {
+      return true;
+    }
+    silent_samples += size;
+    return false;
+  }
+
+  // After processing a block that was not skipped
+  void check_outputs(DataType** outputs, int nb_outputs, int size)
+  {
+    const DataType limit = threshold();
+    silent_outputs = true;
+    for (int channel = 0; channel < nb_outputs && silent_outputs; ++channel)
+    {
+      const DataType* output = outputs[channel];
+      for (int i = 0; i < size; ++i)
+      {
+        if (std::abs(output[i]) > limit)
+        {
+          silent_outputs = false;
+          break;
+        }
+      }
+    }
+  }
+
+  static void clear(DataType** outputs, int nb_outputs, int size)
+  {
+    for (int channel = 0; channel < nb_outputs; ++channel)
+    {
+      std::memset(outputs[channel], 0, size * sizeof(DataType));
+    }
+  }
+
+private:
+  int64_t silent_samples;
+  bool silent_outputs;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef __SmoothedDryWetFilter__
+#define __SmoothedDryWetFilter__
+
+#include <algorithm>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+#include "ParameterSmoother.h"
+
+// Drop-in replacement of ATK::DryWetFilter that ramps the mix sample by sample instead of jumping
+// Output channel i is dry * input 2i + (1 - dry) * input 2i+1, as in ATK
+template<typename DataType_>
+class SmoothedDryWetFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+  using Parent::nb_output_ports;
+
+public:
+  SmoothedDryWetFilter(int nb_channels = 1)
+    :Parent(2 * nb_channels, nb_channels)
+  {
+    smoother.set_target(1);
+    smoother.snap();
+  }
+
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+  {
+    smoother.set_smoothing(mode, time_ms);
+  }
+
+  void set_dry(double dry)
+  {
+    smoother.set_target(dry);
+  }
+
+  double get_dry() const
+  {
+    return smoother.get_target();
+  }
+
+  void full_setup()
+  {
+    Parent::full_setup();
+    smoother.snap();
+  }
+
+protected:
+  void setup()
+  {
+    Parent::setup();
+    smoother.set_sampling_rate(this->get_output_sampling_rate());
+    smoother.snap();
+  }
+
+  void process_impl(int64_t size) const
+  {
+    int64_t i = 0;
+    // the ramp is computed once per chunk and shared by the channels
+    while (i < size && smoother.is_smoothing())
+    {
+      int64_t chunk = std::min<int64_t>(size - i, ramp_size);
+      for (int64_t j = 0; j < chunk; ++j)
+      {
+        ramp[j] = static_cast<DataType>(smoother.next());
+      }
+      for (int channel = 0; channel < nb_output_ports; ++channel)
+      {
+        const DataType* input0 = converted_inputs[2 * channel] + i;
+        const DataType* input1 = converted_inputs[2 * channel + 1] + i;
+        DataType* output = outputs[channel] + i;
+        for (int64_t j = 0; j < chunk; ++j)
+        {
+          output[j] = ramp[j] * input0[j] + (1 - ramp[j]) * input1[j];
+        }
+      }
+      i += chunk;
+    }
+
+    DataType dry = static_cast<DataType>(smoother.get_value());
+    for (int channel = 0; channel < nb_output_ports; ++channel)
+    {
+      const DataType* input0 = converted_inputs[2 * channel];
+      const DataType* input1 = converted_inputs[2 * channel + 1];
+      DataType* output = outputs[channel];
+      for (int64_t j = i; j < size; ++j)
+      {
+        output[j] = dry * input0[j] + (1 - dry) * input1[j];
+      }
+    }
+  }
+
+private:
+  static const int ramp_size = 64;
+  mutable ParameterSmoother smoother;
+  mutable DataType ramp[ramp_size];
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef __SmoothedVolumeFilter__
+#define __SmoothedVolumeFilter__
+
+#include <algorithm>
+#include <cmath>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+#include "ParameterSmoother.h"
+
+// Drop-in replacement of ATK::VolumeFilter that ramps the gain sample by sample instead of jumping
+// full_setup() and sampling rate changes jump to the last requested volume
+template<typename DataType_>
+class SmoothedVolumeFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+  using Parent::nb_output_ports;
+
+public:
+  SmoothedVolumeFilter(int nb_channels = 1)
+    :Parent(nb_channels, nb_channels)
+  {
+    smoother.set_target(1);
+    smoother.snap();
+  }
+
+  void set_smoothing(ParameterSmoother::Mode mode, double time_ms)
+  {
+    smoother.set_smoothing(mode, time_ms);
+  }
+
+  void set_volume(double volume)
+  {
+    smoother.set_target(volume);
+  }
+
+  void set_volume_db(double volume_db)
+  {
+    set_volume(std::pow(10., volume_db / 20));
+  }
+
+  double get_volume() const
+  {
+    return smoother.get_target();
+  }
+
+  void full_setup()
+  {
+    Parent::full_setup();
+    smoother.snap();
+  }
+
+protected:
+  void setup()
+  {
+    Parent::setup();
+    smoother.set_sampling_rate(this->get_output_sampling_rate());
+    smoother.snap();
+  }
+
+  void process_impl(int64_t size) const
+  {
+    int64_t i = 0;
+    // the ramp is computed once per chunk and shared by the channels
+    while (i < size && smoother.is_smoothing())
+    {
+      int64_t chunk = std::min<int64_t>(size - i, ramp_size);
+      for (int64_t j = 0; j < chunk; ++j)
+      {
+        ramp[j] = static_cast<DataType>(smoother.next());
+      }
+      for (int channel = 0; channel < nb_output_ports; ++channel)
+      {
+        const DataType* input = converted_inputs[channel] + i;
+        DataType* output = outputs[channel] + i;
+        for (int64_t j = 0; j < chunk; ++j)
+        {
+          output[j] = ramp[j] * input[j];
+        }
+      }
+      i += chunk;
+    }
+
+    DataType volume = static_cast<DataType>(smoother.get_value());
+    for (int channel = 0; channel < nb_output_ports; ++channel)
+    {
+      const DataType* input = converted_inputs[channel];
+      DataType* output = outputs[channel];
+      for (int64_t j = i; j < size; ++j)
+      {
+        output[j] = volume * input[j];
+      }
+    }
+  }
+
+private:
+  static const int ramp_size = 64;
+  mutable ParameterSmoother smoother;
+  mutable DataType ramp[ramp_size];
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef __TabulatedGainCompressorFilter__
+#define __TabulatedGainCompressorFilter__
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+#include "GainCurveTable.h"
+
+// Drop-in replacement of ATK::GainCompressorFilter that can read its gain curve from a
+// GainCurveTable instead of evaluating it for every sample
+template<typename DataType_>
+class TabulatedGainCompressorFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+  using Parent::nb_output_ports;
+
+public:
+  TabulatedGainCompressorFilter(int nb_channels = 1)
+    :Parent(nb_channels, nb_channels), threshold(1), ratio(1), softness(.0001), tabulated(false)
+  {
+  }
+
+  void set_threshold(DataType threshold)
+  {
+    this->threshold = threshold;
+  }
+
+  void set_ratio(DataType ratio)
+  {
+    this->ratio = ratio;
+    request_curve();
+  }
+
+  void set_softness(DataType softness)
+  {
+    this->softness = softness;
+    request_curve();
+  }
+
+  // Not to be changed while processing, see GainCurveTable::set_background_build
+  void set_tabulated(bool tabulated, bool background_build)
+  {
+    this->tabulated = tabulated;
+    // the first curve is built right away
+    table.set_background_build(false);
+    request_curve();
+    table.set_background_build(tabulated && background_build);
+  }
+
+  bool is_tabulated() const
+  {
+    return tabulated;
+  }
+
+protected:
+  void process_impl(int64_t size) const
+  {
+    DataType inv_threshold = 1 / threshold;
+    if (tabulated)
+    {
+      table.acquire();
+      for (int channel = 0; channel < nb_output_ports; ++channel)
+      {
+        const DataType* input = converted_inputs[channel];
+        DataType* output = outputs[channel];
+        for (int64_t i = 0; i < size; ++i)
+        {
+          output[i] = table.get_gain(input[i] * inv_threshold);
+        }
+      }
+    }
+    else
+    {
+      for (int channel = 0; channel < nb_output_ports; ++channel)
+      {
+        const DataType* input = converted_inputs[channel];
+        DataType* output = outputs[channel];
+        for (int64_t i = 0; i < size; ++i)
+        {
+          output[i] = static_cast<DataType>(GainCurveTable<DataType>::gain(input[i] / threshold, ratio, softness));
+        }
+      }
+    }
+  }
+
+private:
+  void request_curve()
+  {
+    if (tabulated)
+    {
+      table.request(ratio, softness);
+    }
+  }
+
+  DataType threshold;
+  DataType ratio;
+  DataType softness;
+  bool tabulated;
+  mutable GainCurveTable<DataType> table;
+};
+
+#endif
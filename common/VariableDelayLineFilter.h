@@ -0,0 +1,269 @@
+#ifndef __VariableDelayLineFilter__
+#define __VariableDelayLineFilter__
+
+#include <algorithm>
+#include <cstdint>
+
+#include <ATK/Core/TypedBaseFilter.h>
+
+#include "DelayRingBuffer.h"
+
+// Drop-in replacement of ATK::UniversalVariableDelayLineFilter on a DelayRingBuffer
+// The second input is the delay in samples, clamped to [1, max_delay] and interpolated
+// x_h[n] = x[n] + feedback * x_h[n - central_delay], y[n] = blend * x_h[n] + feedforward * x_h[n - delay[n]]
+// The higher order interpolations process the blocks in chunks: the delay line is written for the
+// whole chunk first, then the interpolation weights are computed for all its samples, and only
+// then are the taps gathered, so that each pass is a loop without dependencies between samples
+template<typename DataType_>
+class VariableDelayLineFilter : public ATK::TypedBaseFilter<DataType_>
+{
+protected:
+  typedef ATK::TypedBaseFilter<DataType_> Parent;
+  using typename Parent::DataType;
+  using Parent::converted_inputs;
+  using Parent::outputs;
+
+public:
+  enum Interpolation
+  {
+    // 2 taps, the interpolation of ATK
+    kLinear = 0,
+    // 4 taps, third order polynomial through the taps
+    kLagrange,
+    // 4 taps, Catmull-Rom spline, continuous slope between the segments
+    kHermite,
+    // first order Thiran allpass, flat magnitude but recursive, for slow modulations
+    kAllpass
+  };
+
+  VariableDelayLineFilter(int64_t max_delay)
+    :Parent(2, 1), max_delay(1), central_delay(1), blend(0), feedback(0), feedforward(1), interpolation(kLinear), last_output(0)
+  {
+    set_max_delay(max_delay);
+  }
+
+  // Allocates, not while processing
+  void set_max_delay(int64_t max_delay)
+  {
+    this->max_delay = std::max<int64_t>(max_delay, 1);
+    // a chunk is written before it is read, the 4 taps interpolations read one sample further
+    buffer.set_max_delay(this->max_delay + chunk_size, 2);
+    central_delay = std::min(central_delay, this->max_delay);
+  }
+
+  int64_t get_max_delay() const
+  {
+    return max_delay;
+  }
+
+  // Delay of the feedback, clamped to [1, max_delay]
+  void set_central_delay(int64_t central_delay)
+  {
+    this->central_delay = std::max<int64_t>(1, std::min(central_delay, max_delay));
+  }
+
+  void set_blend(DataType blend)
+  {
+    this->blend = blend;
+  }
+
+  void set_feedback(DataType feedback)
+  {
+    this->feedback = feedback;
+  }
+
+  void set_feedforward(DataType feedforward)
+  {
+    this->feedforward = feedforward;
+  }
+
+  void set_interpolation(Interpolation interpolation)
+  {
+    this->interpolation = interpolation;
+    last_output = 0;
+  }
+
+  Interpolation get_interpolation() const
+  {
+    return interpolation;
+  }
+
+  void full_setup()
+  {
+    Parent::full_setup();
+    buffer.clear();
+    last_output = 0;
+  }
+
+protected:
+  void process_impl(int64_t size) const
+  {
+    if (interpolation == kLinear)
+    {
+      process_linear(size);
+      return;
+    }
+
+    const DataType feedback = this->feedback;
+    const DataType blend = this->blend;
+    const DataType feedforward = this->feedforward;
+    for (int64_t offset = 0; offset < size; offset += chunk_size)
+    {
+      int64_t chunk = std::min<int64_t>(chunk_size, size - offset);
+      const DataType* input = converted_inputs[0] + offset;
+      const DataType* delays = converted_inputs[1] + offset;
+      DataType* output = outputs[0] + offset;
+
+      // the recursive part, x_h of the whole chunk
+      for (int64_t i = 0; i < chunk; ++i)
+      {
+        DataType value = input[i] + feedback * buffer.read(central_delay);
+        processed[i] = value;
+        buffer.write(value);
+      }
+
+      switch (interpolation)
+      {
+      case kLagrange:
+        compute_lagrange_weights(delays, chunk);
+        interpolate_four_taps(chunk);
+        break;
+      case kHermite:
+        compute_hermite_weights(delays, chunk);
+        interpolate_four_taps(chunk);
+        break;
+      default:
+        compute_allpass_weights(delays, chunk);
+        interpolate_allpass(chunk);
+        break;
+      }
+
+      for (int64_t i = 0; i < chunk; ++i)
+      {
+        output[i] = blend * processed[i] + feedforward * taps[i];
+      }
+    }
+  }
+
+private:
+  static const int chunk_size = 64;
+
+  // Integer part and fraction of the clamped delays. The delays of the chunk are relative to the
+  // position of the delay line after the chunk was written
+  void split_delays(const DataType* delays, int64_t size, DataType offset) const
+  {
+    const DataType min_delay = static_cast<DataType>(1);
+    const DataType max = static_cast<DataType>(max_delay);
+    for (int64_t i = 0; i < size; ++i)
+    {
+      DataType delay = std::min(std::max(delays[i], min_delay), max) - offset;
+      integer_delays[i] = static_cast<int64_t>(delay);
+      fractions[i] = delay - integer_delays[i];
+      integer_delays[i] += size - i;
+    }
+  }
+
+  // The 4 taps start one sample before the linear ones, x_h[n - delay + 1] is always written
+  void compute_lagrange_weights(const DataType* delays, int64_t size) const
+  {
+    split_delays(delays, size, 0);
+    for (int64_t i = 0; i < size; ++i)
+    {
+      DataType f = fractions[i];
+      DataType fm1 = f - 1;
+      DataType fm2 = f - 2;
+      DataType fp1 = f + 1;
+      weights[0][i] = -f * fm1 * fm2 / 6;
+      weights[1][i] = fp1 * fm1 * fm2 / 2;
+      weights[2][i] = -fp1 * f * fm2 / 2;
+      weights[3][i] = fp1 * f * fm1 / 6;
+    }
+  }
+
+  void compute_hermite_weights(const DataType* delays, int64_t size) const
+  {
+    split_delays(delays, size, 0);
+    for (int64_t i = 0; i < size; ++i)
+    {
+      DataType f = fractions[i];
+      DataType f2 = f * f;
+      DataType f3 = f2 * f;
+      weights[0][i] = static_cast<DataType>(-.5) * f3 + f2 - static_cast<DataType>(.5) * f;
+      weights[1][i] = static_cast<DataType>(1.5) * f3 - static_cast<DataType>(2.5) * f2 + 1;
+      weights[2][i] = static_cast<DataType>(-1.5) * f3 + 2 * f2 + static_cast<DataType>(.5) * f;
+      weights[3][i] = static_cast<DataType>(.5) * f3 - static_cast<DataType>(.5) * f2;
+    }
+  }
+
+  // The fraction is kept in [0.5, 1.5[ so that the pole stays away from -1
+  void compute_allpass_weights(const DataType* delays, int64_t size) const
+  {
+    split_delays(delays, size, static_cast<DataType>(.5));
+    for (int64_t i = 0; i < size; ++i)
+    {
+      DataType f = fractions[i] + static_cast<DataType>(.5);
+      weights[0][i] = (1 - f) / (1 + f);
+    }
+  }
+
+  // One weight only, the samples are computed in one pass like ATK does
+  void process_linear(int64_t size) const
+  {
+    const DataType* input = converted_inputs[0];
+    const DataType* delays = converted_inputs[1];
+    DataType* output = outputs[0];
+    const DataType max = static_cast<DataType>(max_delay);
+    for (int64_t i = 0; i < size; ++i)
+    {
+      DataType processed = input[i] + feedback * buffer.read(central_delay);
+      DataType delay = std::min(std::max(delays[i], static_cast<DataType>(1)), max);
+      int64_t integer_delay = static_cast<int64_t>(delay);
+      DataType fraction = delay - integer_delay;
+      DataType first = buffer.read(integer_delay);
+      DataType second = buffer.read(integer_delay + 1);
+      output[i] = blend * processed + feedforward * (first + fraction * (second - first));
+      buffer.write(processed);
+    }
+  }
+
+  void interpolate_four_taps(int64_t size) const
+  {
+    const typename DelayRingBuffer<DataType>::Reader reader = buffer.get_reader();
+    for (int64_t i = 0; i < size; ++i)
+    {
+      int64_t delay = integer_delays[i];
+      taps[i] = weights[0][i] * reader.read(delay - 1) + weights[1][i] * reader.read(delay)
+        + weights[2][i] * reader.read(delay + 1) + weights[3][i] * reader.read(delay + 2);
+    }
+  }
+
+  // y[n] = eta * u[n] + u[n - 1] - eta * y[n - 1], u being the line at the integer delay
+  void interpolate_allpass(int64_t size) const
+  {
+    const typename DelayRingBuffer<DataType>::Reader reader = buffer.get_reader();
+    DataType output = last_output;
+    for (int64_t i = 0; i < size; ++i)
+    {
+      output = weights[0][i] * (reader.read(integer_delays[i]) - output) + reader.read(integer_delays[i] + 1);
+      taps[i] = output;
+    }
+    last_output = output;
+  }
+
+  mutable DelayRingBuffer<DataType> buffer;
+  int64_t max_delay;
+  int64_t central_delay;
+  DataType blend;
+  DataType feedback;
+  DataType feedforward;
+  Interpolation interpolation;
+  mutable DataType last_output;
+
+  mutable DataType processed[chunk_size];
+  mutable int64_t integer_delays[chunk_size];
+  mutable DataType fractions[chunk_size];
+  mutable DataType weights[4][chunk_size];
+  mutable DataType taps[chunk_size];
+};
+
+#endif
@@ -0,0 +1,296 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "AudioFile.h"
+
+namespace
+{
+  const int WAVE_FORMAT_PCM = 1;
+  const int WAVE_FORMAT_IEEE_FLOAT = 3;
+  const int WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+  int bytes_per_sample(AudioFile::Format format)
+  {
+    switch (format)
+    {
+    case AudioFile::kPCM16:
+      return 2;
+    case AudioFile::kPCM24:
+      return 3;
+    case AudioFile::kPCM32:
+    case AudioFile::kFloat32:
+      return 4;
+    case AudioFile::kFloat64:
+      return 8;
+    }
+    return 0;
+  }
+
+  uint32_t read_le(const unsigned char* data, int size)
+  {
+    uint32_t value = 0;
+    for (int i = size - 1; i >= 0; --i)
+    {
+      value = (value << 8) | data[i];
+    }
+    return value;
+  }
+
+  void write_le(std::ostream& stream, uint32_t value, int size)
+  {
+    for (int i = 0; i < size; ++i)
+    {
+      stream.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+  }
+
+  double decode(const unsigned char* data, AudioFile::Format format)
+  {
+    switch (format)
+    {
+    case AudioFile::kPCM16:
+      return static_cast<int16_t>(read_le(data, 2)) / 32768.;
+    case AudioFile::kPCM24:
+      return (static_cast<int32_t>(read_le(data, 3) << 8) >> 8) / 8388608.;
+    case AudioFile::kPCM32:
+      return static_cast<int32_t>(read_le(data, 4)) / 2147483648.;
+    case AudioFile::kFloat32:
+    {
+      uint32_t bits = read_le(data, 4);
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+    case AudioFile::kFloat64:
+    {
+      uint64_t bits = static_cast<uint64_t>(read_le(data + 4, 4)) << 32 | read_le(data, 4);
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+    }
+    return 0;
+  }
+
+  int64_t clip(double value, double scale)
+  {
+    double scaled = value * scale;
+    if (scaled > scale - 1)
+    {
+      return static_cast<int64_t>(scale - 1);
+    }
+    if (scaled < -scale)
+    {
+      return static_cast<int64_t>(-scale);
+    }
+    return static_cast<int64_t>(scaled < 0 ? scaled - .5 : scaled + .5);
+  }
+
+  void encode(std::ostream& stream, double value, AudioFile::Format format)
+  {
+    switch (format)
+    {
+    case AudioFile::kPCM16:
+      write_le(stream, static_cast<uint32_t>(clip(value, 32768.)), 2);
+      break;
+    case AudioFile::kPCM24:
+      write_le(stream, static_cast<uint32_t>(clip(value, 8388608.)), 3);
+      break;
+    case AudioFile::kPCM32:
+      write_le(stream, static_cast<uint32_t>(clip(value, 2147483648.)), 4);
+      break;
+    case AudioFile::kFloat32:
+    {
+      float sample = static_cast<float>(value);
+      uint32_t bits;
+      std::memcpy(&bits, &sample, sizeof(bits));
+      write_le(stream, bits, 4);
+      break;
+    }
+    case AudioFile::kFloat64:
+    {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      write_le(stream, static_cast<uint32_t>(bits), 4);
+      write_le(stream, static_cast<uint32_t>(bits >> 32), 4);
+      break;
+    }
+    }
+  }
+
+  void read_samples(std::istream& stream, int64_t size, int nb_channels, AudioFile& file)
+  {
+    int sample_size = bytes_per_sample(file.format);
+    int64_t nb_frames = size / (sample_size * nb_channels);
+    std::vector<unsigned char> data(nb_frames * sample_size * nb_channels);
+    stream.read(reinterpret_cast<char*>(data.data()), data.size());
+    nb_frames = stream.gcount() / (sample_size * nb_channels);
+
+    file.channels.assign(nb_channels, std::vector<double>(nb_frames));
+    const unsigned char* current = data.data();
+    for (int64_t i = 0; i < nb_frames; ++i)
+    {
+      for (int channel = 0; channel < nb_channels; ++channel)
+      {
+        file.channels[channel][i] = decode(current, file.format);
+        current += sample_size;
+      }
+    }
+  }
+
+  void write_samples(std::ostream& stream, const AudioFile& file)
+  {
+    for (int64_t i = 0; i < file.nb_frames(); ++i)
+    {
+      for (int channel = 0; channel < file.nb_channels(); ++channel)
+      {
+        encode(stream, file.channels[channel][i], file.format);
+      }
+    }
+  }
+
+  void read_wav(std::istream& stream, AudioFile& file)
+  {
+    unsigned char header[12];
+    stream.read(reinterpret_cast<char*>(header), 12);
+    if (std::memcmp(header + 8, "WAVE", 4) != 0)
+    {
+      throw std::runtime_error("Not a WAVE file");
+    }
+
+    int nb_channels = 0;
+    bool found_format = false;
+    unsigned char chunk[8];
+    while (stream.read(reinterpret_cast<char*>(chunk), 8))
+    {
+      uint32_t size = read_le(chunk + 4, 4);
+      if (std::memcmp(chunk, "fmt ", 4) == 0)
+      {
+        std::vector<unsigned char> format(size);
+        stream.read(reinterpret_cast<char*>(format.data()), size);
+        if (size < 16)
+        {
+          throw std::runtime_error("Invalid fmt chunk");
+        }
+        int tag = read_le(format.data(), 2);
+        if (tag == WAVE_FORMAT_EXTENSIBLE && size >= 26)
+        {
+          tag = read_le(format.data() + 24, 2);
+        }
+        nb_channels = read_le(format.data() + 2, 2);
+        file.sampling_rate = read_le(format.data() + 4, 4);
+        int bits = read_le(format.data() + 14, 2);
+
+        if (tag == WAVE_FORMAT_PCM && bits == 16)
+          file.format = AudioFile::kPCM16;
+        else if (tag == WAVE_FORMAT_PCM && bits == 24)
+          file.format = AudioFile::kPCM24;
+        else if (tag == WAVE_FORMAT_PCM && bits == 32)
+          file.format = AudioFile::kPCM32;
+        else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 32)
+          file.format = AudioFile::kFloat32;
+        else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 64)
+          file.format = AudioFile::kFloat64;
+        else
+          throw std::runtime_error("Unsupported WAVE sample format");
+        found_format = true;
+      }
+      else if (std::memcmp(chunk, "data", 4) == 0)
+      {
+        if (!found_format || nb_channels == 0)
+        {
+          throw std::runtime_error("data chunk before fmt chunk");
+        }
+        read_samples(stream, size, nb_channels, file);
+        return;
+      }
+      else
+      {
+        stream.seekg(size + (size & 1), std::ios::cur);
+      }
+    }
+    throw std::runtime_error("No data chunk in WAVE file");
+  }
+
+  void write_wav(std::ostream& stream, const AudioFile& file)
+  {
+    int sample_size = bytes_per_sample(file.format);
+    bool is_float = file.format == AudioFile::kFloat32 || file.format == AudioFile::kFloat64;
+    uint32_t data_size = static_cast<uint32_t>(file.nb_frames() * file.nb_channels() * sample_size);
+
+    stream.write("RIFF", 4);
+    write_le(stream, 36 + data_size, 4);
+    stream.write("WAVE", 4);
+    stream.write("fmt ", 4);
+    write_le(stream, 16, 4);
+    write_le(stream, is_float ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM, 2);
+    write_le(stream, file.nb_channels(), 2);
+    write_le(stream, file.sampling_rate, 4);
+    write_le(stream, file.sampling_rate * file.nb_channels() * sample_size, 4);
+    write_le(stream, file.nb_channels() * sample_size, 2);
+    write_le(stream, 8 * sample_size, 2);
+    stream.write("data", 4);
+    write_le(stream, data_size, 4);
+    write_samples(stream, file);
+  }
+}
+
+AudioFile::AudioFile()
+  :sampling_rate(44100), format(kFloat32)
+{
+}
+
+int AudioFile::nb_channels() const
+{
+  return static_cast<int>(channels.size());
+}
+
+int64_t AudioFile::nb_frames() const
+{
+  return channels.empty() ? 0 : static_cast<int64_t>(channels[0].size());
+}
+
+void read_audio(const std::string& filename, AudioFile& file)
+{
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  if (!stream)
+  {
+    throw std::runtime_error("Cannot open " + filename);
+  }
+
+  char magic[4] = {0};
+  stream.read(magic, 4);
+  stream.seekg(0);
+  if (std::memcmp(magic, "RIFF", 4) == 0)
+  {
+    read_wav(stream, file);
+  }
+  else
+  {
+    // raw files keep the channel count already stored in file
+    int nb_channels = file.nb_channels() > 0 ? file.nb_channels() : 1;
+    stream.seekg(0, std::ios::end);
+    int64_t size = stream.tellg();
+    stream.seekg(0);
+    read_samples(stream, size, nb_channels, file);
+  }
+}
+
+void write_audio(const std::string& filename, const AudioFile& file)
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream)
+  {
+    throw std::runtime_error("Cannot open " + filename);
+  }
+
+  if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".raw") == 0)
+  {
+    write_samples(stream, file);
+  }
+  else
+  {
+    write_wav(stream, file);
+  }
+}
@@ -0,0 +1,36 @@
+#ifndef __AudioFile__
+#define __AudioFile__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Deinterleaved audio buffer, as read from or written to a WAV or raw file
+struct AudioFile
+{
+  enum Format
+  {
+    kPCM16 = 0,
+    kPCM24,
+    kPCM32,
+    kFloat32,
+    kFloat64
+  };
+
+  int sampling_rate;
+  Format format;
+  std::vector<std::vector<double> > channels;
+
+  AudioFile();
+
+  int nb_channels() const;
+  int64_t nb_frames() const;
+};
+
+// WAV files are detected by their RIFF header, everything else is read as interleaved raw
+// samples using the format, sampling rate and channel count already set in file
+// Both functions throw std::runtime_error on failure
+void read_audio(const std::string& filename, AudioFile& file);
+void write_audio(const std::string& filename, const AudioFile& file);
+
+#endif
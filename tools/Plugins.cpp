@@ -0,0 +1,292 @@
+#include "Plugins.h"
+
+#include "../ATKAutoSwell/ATKAutoSwellDSP.h"
+#include "../ATKChorus/ATKChorusDSP.h"
+#include "../ATKColoredCompressor/ATKColoredCompressorDSP.h"
+#include "../ATKColoredExpander/ATKColoredExpanderDSP.h"
+#include "../ATKCompressor/ATKCompressorDSP.h"
+#include "../ATKExpander/ATKExpanderDSP.h"
+#include "../ATKLimiter/ATKLimiterDSP.h"
+#include "../ATKSD1/ATKSD1DSP.h"
+#include "../ATKSideChainCompressor/ATKSideChainCompressorDSP.h"
+#include "../ATKSideChainExpander/ATKSideChainExpanderDSP.h"
+#include "../ATKStereoCompressor/ATKStereoCompressorDSP.h"
+#include "../ATKStereoPhaser/ATKStereoPhaserDSP.h"
+#include "../ATKUniversalDelay/ATKUniversalDelayDSP.h"
+#include "../ATKUniversalVariableDelay/ATKUniversalVariableDelayDSP.h"
+
+namespace
+{
+  template<class DSP>
+  std::unique_ptr<PluginDSP<typename DSP::DataType> > create()
+  {
+    return std::unique_ptr<PluginDSP<typename DSP::DataType> >(new PluginDSPImpl<DSP>);
+  }
+
+  // ATKCompressor through its fused kernel, compared with the original filter graph
+  template<typename DataType>
+  class ATKCompressorFusedDSP : public ATKCompressorDSP<DataType>
+  {
+  public:
+    ATKCompressorFusedDSP()
+    {
+      this->set_fused_kernel(true);
+    }
+  };
+
+  // ATKSideChainCompressor through its original filter graph, the reference of the two lanes kernel
+  template<typename DataType>
+  class ATKSideChainCompressorGraphDSP : public ATKSideChainCompressorDSP<DataType>
+  {
+  public:
+    ATKSideChainCompressorGraphDSP()
+    {
+      this->set_fused_kernel(false);
+    }
+  };
+
+  // ATKStereoCompressor through its original filter graph, the reference of the two lanes kernel
+  template<typename DataType>
+  class ATKStereoCompressorGraphDSP : public ATKStereoCompressorDSP<DataType>
+  {
+  public:
+    ATKStereoCompressorGraphDSP()
+    {
+      this->set_fused_kernel(false);
+    }
+  };
+
+  // the channel count of ATKChorusDSP keeps it from being a template of the sample type only
+  template<typename DataType>
+  using ATKChorusMonoDSP = ATKChorusDSP<DataType>;
+
+  // ATKChorus with its modulation computed at the audio rate, the reference of the random LFO
+  template<typename DataType>
+  class ATKChorusNoiseDSP : public ATKChorusDSP<DataType>
+  {
+  public:
+    ATKChorusNoiseDSP()
+    {
+      this->set_audio_rate_modulation(true);
+    }
+  };
+
+  // all the voices of the stereo chorus, to compare its cost with a single one
+  template<typename DataType>
+  class ATKChorusStereo8DSP : public ATKChorusStereoDSP<DataType>
+  {
+  public:
+    ATKChorusStereo8DSP()
+    {
+      this->set_parameter(ATKChorusParameters::kVoices, 8);
+    }
+  };
+
+  // ATKUniversalVariableDelay with the 4 taps Lagrange interpolation, to compare with the linear one
+  template<typename DataType>
+  class ATKUniversalVariableDelayLagrangeDSP : public ATKUniversalVariableDelayDSP<DataType>
+  {
+  public:
+    ATKUniversalVariableDelayLagrangeDSP()
+    {
+      this->set_parameter(ATKUniversalVariableDelayParameters::kInterpolation, VariableDelayLineFilter<DataType>::kLagrange);
+    }
+  };
+
+  // ATKStereoPhaser with a chain of stages, to compare the cost of the short and the deep phasers
+  template<int nb_stages>
+  struct WithStages
+  {
+    template<typename DataType>
+    class Staged : public ATKStereoPhaserDSP<DataType>
+    {
+    public:
+      Staged()
+      {
+        this->set_parameter(ATKStereoPhaserParameters::kMode, ATKStereoPhaserParameters::kStagesMode);
+        this->set_parameter(ATKStereoPhaserParameters::kStages, nb_stages);
+        this->set_parameter(ATKStereoPhaserParameters::kFeedback, 50);
+      }
+    };
+  };
+
+  // ATKUniversalDelay with feedback at a given delay, in blocks or sample by sample. At 1 ms it is a
+  // comb filter that stays on the scalar path
+  template<bool block_processing, int delay_ms>
+  struct WithDelay
+  {
+    template<typename DataType>
+    class Delayed : public ATKUniversalDelayDSP<DataType>
+    {
+    public:
+      Delayed()
+      {
+        this->set_block_processing(block_processing);
+        this->set_parameter(ATKUniversalDelayParameters::kDelay, delay_ms);
+        this->set_parameter(ATKUniversalDelayParameters::kFeedback, 50);
+      }
+    };
+  };
+
+  // ATKUniversalDelay synced on 4 bars, 8 s at the default tempo of 120 bpm
+  template<typename DataType>
+  class ATKUniversalDelaySyncDSP : public ATKUniversalDelayDSP<DataType>
+  {
+  public:
+    ATKUniversalDelaySyncDSP()
+    {
+      this->set_parameter(ATKUniversalDelayParameters::kSync, 1);
+      this->set_parameter(ATKUniversalDelayParameters::kDivision, 16);
+      this->set_parameter(ATKUniversalDelayParameters::kFeedback, 50);
+    }
+  };
+
+  // the channel count of ATKSD1DSP keeps it from being a template of the sample type only
+  template<typename DataType>
+  using ATKSD1MonoDSP = ATKSD1DSP<DataType>;
+
+  // ATKSD1 with the clipper equation solved by Newton iterations, the reference of the table
+  template<typename DataType>
+  class ATKSD1NewtonDSP : public ATKSD1DSP<DataType>
+  {
+  public:
+    ATKSD1NewtonDSP()
+    {
+      this->set_overdrive_solver(ATKSD1DSP<DataType>::kNewtonSolver);
+    }
+  };
+
+  // ATKSD1 with the clipper equation read from the precomputed table
+  template<typename DataType>
+  class ATKSD1TableDSP : public ATKSD1DSP<DataType>
+  {
+  public:
+    ATKSD1TableDSP()
+    {
+      this->set_overdrive_solver(ATKSD1DSP<DataType>::kTableSolver);
+    }
+  };
+
+  template<typename DataType>
+  class ATKSD1StereoTableDSP : public ATKSD1StereoDSP<DataType>
+  {
+  public:
+    ATKSD1StereoTableDSP()
+    {
+      this->set_overdrive_solver(ATKSD1StereoDSP<DataType>::kTableSolver);
+    }
+  };
+
+  // The compressors with their gain curve tables, built synchronously to get reproducible runs
+  // ATKStereoCompressor and ATKSideChainCompressor use them by default, like their plugins
+  template<template<typename> class DSP>
+  struct WithGainCurveTable
+  {
+    template<typename DataType>
+    class Tabulated : public DSP<DataType>
+    {
+    public:
+      Tabulated()
+      {
+        this->set_gain_curve_table(true, false);
+      }
+    };
+  };
+
+  // the side chain plugins as they run when the host connects nothing to their side chain
+  template<template<typename> class DSP>
+  struct WithoutSideChain
+  {
+    template<typename DataType>
+    class Unconnected : public DSP<DataType>
+    {
+    public:
+      Unconnected()
+      {
+        this->set_sidechain_connected(false);
+      }
+    };
+  };
+
+  template<template<typename> class DSP>
+  PluginEntry make_entry(const char* name)
+  {
+    PluginEntry entry = {name, create<DSP<float> >, create<DSP<double> >};
+    return entry;
+  }
+}
+
+const std::vector<PluginEntry>& get_plugins()
+{
+  static const std::vector<PluginEntry> plugins =
+  {
+    make_entry<ATKAutoSwellDSP>("ATKAutoSwell"),
+    make_entry<ATKChorusMonoDSP>("ATKChorus"),
+    make_entry<ATKChorusNoiseDSP>("ATKChorusNoise"),
+    make_entry<ATKChorusStereoDSP>("ATKChorusStereo"),
+    make_entry<ATKChorusStereo8DSP>("ATKChorusStereo8"),
+    make_entry<ATKColoredCompressorDSP>("ATKColoredCompressor"),
+    make_entry<ATKColoredExpanderDSP>("ATKColoredExpander"),
+    make_entry<ATKCompressorDSP>("ATKCompressor"),
+    make_entry<ATKCompressorFusedDSP>("ATKCompressorFused"),
+    make_entry<WithGainCurveTable<ATKCompressorFusedDSP>::Tabulated>("ATKCompressorTable"),
+    make_entry<ATKExpanderDSP>("ATKExpander"),
+    make_entry<ATKLimiterDSP>("ATKLimiter"),
+    make_entry<ATKSD1MonoDSP>("ATKSD1"),
+    make_entry<ATKSD1NewtonDSP>("ATKSD1Newton"),
+    make_entry<ATKSD1TableDSP>("ATKSD1Table"),
+    make_entry<ATKSD1StereoDSP>("ATKSD1Stereo"),
+    make_entry<ATKSD1StereoTableDSP>("ATKSD1StereoTable"),
+    make_entry<WithGainCurveTable<ATKSideChainCompressorDSP>::Tabulated>("ATKSideChainCompressor"),
+    make_entry<ATKSideChainCompressorDSP>("ATKSideChainCompressorAnalytic"),
+    make_entry<WithGainCurveTable<ATKSideChainCompressorGraphDSP>::Tabulated>("ATKSideChainCompressorGraph"),
+    make_entry<ATKSideChainCompressorGraphDSP>("ATKSideChainCompressorGraphAnalytic"),
+    make_entry<WithoutSideChain<WithGainCurveTable<ATKSideChainCompressorDSP>::Tabulated>::Unconnected>("ATKSideChainCompressorInternalKey"),
+    make_entry<WithoutSideChain<ATKSideChainCompressorDSP>::Unconnected>("ATKSideChainCompressorAnalyticInternalKey"),
+    make_entry<WithoutSideChain<WithGainCurveTable<ATKSideChainCompressorGraphDSP>::Tabulated>::Unconnected>("ATKSideChainCompressorGraphInternalKey"),
+    make_entry<ATKSideChainExpanderDSP>("ATKSideChainExpander"),
+    make_entry<WithoutSideChain<ATKSideChainExpanderDSP>::Unconnected>("ATKSideChainExpanderInternalKey"),
+    make_entry<WithGainCurveTable<ATKStereoCompressorDSP>::Tabulated>("ATKStereoCompressor"),
+    make_entry<ATKStereoCompressorDSP>("ATKStereoCompressorAnalytic"),
+    make_entry<WithGainCurveTable<ATKStereoCompressorGraphDSP>::Tabulated>("ATKStereoCompressorGraph"),
+    make_entry<ATKStereoCompressorGraphDSP>("ATKStereoCompressorGraphAnalytic"),
+    make_entry<ATKStereoPhaserDSP>("ATKStereoPhaser"),
+    make_entry<WithStages<4>::Staged>("ATKStereoPhaser4Stages"),
+    make_entry<WithStages<24>::Staged>("ATKStereoPhaser24Stages"),
+    make_entry<ATKUniversalDelayDSP>("ATKUniversalDelay"),
+    make_entry<WithDelay<true, 1>::Delayed>("ATKUniversalDelay1ms"),
+    make_entry<WithDelay<true, 10>::Delayed>("ATKUniversalDelay10ms"),
+    make_entry<WithDelay<true, 100>::Delayed>("ATKUniversalDelay100ms"),
+    make_entry<WithDelay<false, 1>::Delayed>("ATKUniversalDelayScalar1ms"),
+    make_entry<WithDelay<false, 10>::Delayed>("ATKUniversalDelayScalar10ms"),
+    make_entry<WithDelay<false, 100>::Delayed>("ATKUniversalDelayScalar100ms"),
+    make_entry<ATKUniversalDelaySyncDSP>("ATKUniversalDelaySync"),
+    make_entry<ATKUniversalVariableDelayDSP>("ATKUniversalVariableDelay"),
+    make_entry<ATKUniversalVariableDelayLagrangeDSP>("ATKUniversalVariableDelayLagrange")
+  };
+  return plugins;
+}
+
+const PluginEntry* find_plugin(const std::string& name)
+{
+  for (const PluginEntry& entry : get_plugins())
+  {
+    if (name == entry.name)
+    {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+template<>
+std::unique_ptr<PluginDSP<float> > create_plugin<float>(const PluginEntry& entry)
+{
+  return entry.create_float();
+}
+
+template<>
+std::unique_ptr<PluginDSP<double> > create_plugin<double>(const PluginEntry& entry)
+{
+  return entry.create_double();
+}
@@ -0,0 +1,71 @@
+#ifndef __Plugins__
+#define __Plugins__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../common/ParameterInfo.h"
+
+// Type-erased access to the DSP classes, so that one tool can drive all the plugins
+template<typename DataType>
+class PluginDSP
+{
+public:
+  virtual ~PluginDSP() {}
+
+  virtual int nb_inputs() const = 0;
+  virtual int nb_sidechain_inputs() const = 0;
+  virtual int nb_outputs() const = 0;
+  virtual int nb_parameters() const = 0;
+  virtual const ParameterInfo& parameter(int paramIdx) const = 0;
+
+  virtual void set_sampling_rate(int sampling_rate) = 0;
+  virtual void set_parameter(int paramIdx, double value) = 0;
+  virtual double get_parameter(int paramIdx) const = 0;
+  virtual void post_parameter(int paramIdx, double value) = 0;
+  virtual void process(DataType** inputs, DataType** outputs, int nFrames) = 0;
+};
+
+template<class DSP>
+class PluginDSPImpl : public PluginDSP<typename DSP::DataType>
+{
+public:
+  typedef typename DSP::DataType DataType;
+
+  int nb_inputs() const { return DSP::nb_inputs; }
+  int nb_sidechain_inputs() const { return DSP::nb_sidechain_inputs; }
+  int nb_outputs() const { return DSP::nb_outputs; }
+  int nb_parameters() const { return DSP::kNumParams; }
+  const ParameterInfo& parameter(int paramIdx) const { return DSP::parameters[paramIdx]; }
+
+  void set_sampling_rate(int sampling_rate) { dsp.set_sampling_rate(sampling_rate); }
+  void set_parameter(int paramIdx, double value) { dsp.set_parameter(paramIdx, value); }
+  double get_parameter(int paramIdx) const { return dsp.get_parameter(paramIdx); }
+  void post_parameter(int paramIdx, double value) { dsp.post_parameter(paramIdx, value); }
+  void process(DataType** inputs, DataType** outputs, int nFrames) { dsp.process(inputs, outputs, nFrames); }
+
+private:
+  DSP dsp;
+};
+
+struct PluginEntry
+{
+  const char* name;
+  std::unique_ptr<PluginDSP<float> > (*create_float)();
+  std::unique_ptr<PluginDSP<double> > (*create_double)();
+};
+
+template<typename DataType>
+std::unique_ptr<PluginDSP<DataType> > create_plugin(const PluginEntry& entry);
+template<>
+std::unique_ptr<PluginDSP<float> > create_plugin<float>(const PluginEntry& entry);
+template<>
+std::unique_ptr<PluginDSP<double> > create_plugin<double>(const PluginEntry& entry);
+
+// All the plugins, in alphabetical order
+const std::vector<PluginEntry>& get_plugins();
+// Returns nullptr if there is no plugin called name
+const PluginEntry* find_plugin(const std::string& name);
+
+#endif
@@ -0,0 +1,604 @@
+// Micro-benchmark of the plugins DSP: time the process call of each plugin for several block
+// sizes and sampling rates, and write the results to a CSV or JSON file to track regressions
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define HAS_CYCLE_COUNTER 1
+#else
+#define HAS_CYCLE_COUNTER 0
+#endif
+
+#include "../ATKSD1/SD1ClipperFilter.h"
+#include "../common/GainCurveTable.h"
+#include "Plugins.h"
+
+namespace
+{
+  struct Result
+  {
+    std::string plugin;
+    std::string sample_type;
+    int sampling_rate;
+    int block_size;
+    int64_t frames;
+    double ns_per_sample;
+    double cycles_per_sample;
+    double block_p50_ns;
+    double block_p99_ns;
+    double block_max_ns;
+    double cpu_load;
+    bool stress;
+    int64_t parameters_posted;
+  };
+
+  void usage()
+  {
+    std::cerr << "Usage: benchmark [options]" << std::endl
+      << "Options:" << std::endl
+      << "  --plugin Name        benchmark only this plugin (can be repeated)" << std::endl
+      << "  --block-sizes list   comma separated block sizes (default 1,16,32,64,256,1024,4096)" << std::endl
+      << "  --rates list         comma separated sampling rates (default 44100,48000,96000,192000)" << std::endl
+      << "  --types list         comma separated sample types, float and/or double (default double)" << std::endl
+      << "  --duration s         seconds of audio processed per measurement (default 1)" << std::endl
+      << "  --stress             post random parameter values from another thread while measuring" << std::endl
+      << "  --output file        result file, JSON if it ends with .json, CSV otherwise (default benchmark.csv)" << std::endl
+      << "  --list-plugins       print the available plugins" << std::endl
+      << "  --gain-curve         compare the tabulated and the analytic compressor gain curves, speed and error" << std::endl
+      << "  --sd1-table          compare the tabulated and the Newton solved SD1 clipper, speed and error" << std::endl;
+  }
+
+  inline uint64_t read_cycles()
+  {
+#if HAS_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  std::vector<std::string> split(const std::string& list)
+  {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+      items.push_back(item);
+    }
+    return items;
+  }
+
+  std::vector<int> parse_list(const std::string& list)
+  {
+    std::vector<int> values;
+    for (const std::string& item : split(list))
+    {
+      int value = std::atoi(item.c_str());
+      if (value <= 0)
+      {
+        throw std::runtime_error("Invalid value in list: " + list);
+      }
+      values.push_back(value);
+    }
+    return values;
+  }
+
+  template<typename DataType>
+  const char* type_name();
+  template<>
+  const char* type_name<float>() { return "float"; }
+  template<>
+  const char* type_name<double>() { return "double"; }
+
+  // Noise with a slow amplitude envelope, so that the dynamic plugins go in and out of gain reduction
+  template<typename DataType>
+  std::vector<DataType> make_signal(int64_t size, int sampling_rate)
+  {
+    std::vector<DataType> signal(size);
+    uint32_t seed = 12345;
+    for (int64_t i = 0; i < size; ++i)
+    {
+      seed = seed * 1664525 + 1013904223;
+      double noise = static_cast<int32_t>(seed) / 2147483648.;
+      double envelope = .5 + .45 * std::sin(2 * M_PI * 2 * i / sampling_rate);
+      signal[i] = static_cast<DataType>(noise * envelope);
+    }
+    return signal;
+  }
+
+  double percentile(std::vector<double> values, double ratio)
+  {
+    std::size_t index = static_cast<std::size_t>(std::ceil(ratio * values.size()));
+    index = std::min(std::max<std::size_t>(index, 1), values.size()) - 1;
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+  }
+
+  template<typename DataType>
+  class Runner
+  {
+  public:
+    Runner(PluginDSP<DataType>& dsp, const std::vector<DataType>& signal)
+      :dsp(dsp), signal(signal), inputs(dsp.nb_inputs()), outputs(dsp.nb_outputs()),
+      output_buffers(dsp.nb_outputs(), std::vector<DataType>(signal.size()))
+    {
+    }
+
+    void process(int64_t offset, int size)
+    {
+      // every input, main or side chain, reads the same test signal
+      for (std::size_t i = 0; i < inputs.size(); ++i)
+      {
+        inputs[i] = const_cast<DataType*>(&signal[offset]);
+      }
+      for (std::size_t i = 0; i < outputs.size(); ++i)
+      {
+        outputs[i] = &output_buffers[i][offset];
+      }
+      dsp.process(inputs.data(), outputs.data(), size);
+    }
+
+  private:
+    PluginDSP<DataType>& dsp;
+    const std::vector<DataType>& signal;
+    std::vector<DataType*> inputs;
+    std::vector<DataType*> outputs;
+    std::vector<std::vector<DataType> > output_buffers;
+  };
+
+  // Posts random values to all the parameters until stopped, like a fast GUI drag or dense automation
+  template<typename DataType>
+  class ParameterHammer
+  {
+  public:
+    ParameterHammer(PluginDSP<DataType>& dsp)
+      :dsp(dsp), running(true), posted(0), thread(&ParameterHammer::run, this)
+    {
+    }
+
+    ~ParameterHammer()
+    {
+      stop();
+    }
+
+    // Returns the number of changes posted
+    int64_t stop()
+    {
+      if (thread.joinable())
+      {
+        running.store(false);
+        thread.join();
+      }
+      return posted;
+    }
+
+  private:
+    void run()
+    {
+      uint32_t seed = 54321;
+      while (running.load(std::memory_order_relaxed))
+      {
+        for (int i = 0; i < dsp.nb_parameters(); ++i)
+        {
+          const ParameterInfo& info = dsp.parameter(i);
+          seed = seed * 1664525 + 1013904223;
+          double ratio = seed / 4294967296.;
+          dsp.post_parameter(i, info.boolean ? (ratio < .5 ? 0 : 1) : info.min_value + ratio * (info.max_value - info.min_value));
+          ++posted;
+        }
+      }
+    }
+
+    PluginDSP<DataType>& dsp;
+    std::atomic<bool> running;
+    int64_t posted;
+    std::thread thread;
+  };
+
+  template<typename DataType>
+  Result run(const PluginEntry& entry, int sampling_rate, int block_size, double duration, bool stress)
+  {
+    // at least a few hundred blocks so that the percentiles mean something for large blocks
+    const int64_t nb_blocks = std::max<int64_t>(static_cast<int64_t>(duration * sampling_rate / block_size), 200);
+    const int64_t nb_frames = nb_blocks * block_size;
+    std::vector<DataType> signal = make_signal<DataType>(nb_frames, sampling_rate);
+
+    std::unique_ptr<PluginDSP<DataType> > dsp = create_plugin<DataType>(entry);
+    dsp->set_sampling_rate(sampling_rate);
+    Runner<DataType> runner(*dsp, signal);
+
+    // warm up the caches and the filter states
+    for (int64_t block = 0; block < std::min<int64_t>(nb_blocks, 16); ++block)
+    {
+      runner.process(block * block_size, block_size);
+    }
+
+    std::unique_ptr<ParameterHammer<DataType> > hammer;
+    if (stress)
+    {
+      hammer.reset(new ParameterHammer<DataType>(*dsp));
+    }
+
+    // throughput pass, a single timer around the whole loop
+    auto start = std::chrono::steady_clock::now();
+    uint64_t start_cycles = read_cycles();
+    for (int64_t block = 0; block < nb_blocks; ++block)
+    {
+      runner.process(block * block_size, block_size);
+    }
+    uint64_t end_cycles = read_cycles();
+    auto end = std::chrono::steady_clock::now();
+
+    // latency pass, each block is timed on its own
+    std::vector<double> block_times(nb_blocks);
+    for (int64_t block = 0; block < nb_blocks; ++block)
+    {
+      auto block_start = std::chrono::steady_clock::now();
+      runner.process(block * block_size, block_size);
+      auto block_end = std::chrono::steady_clock::now();
+      block_times[block] = std::chrono::duration<double, std::nano>(block_end - block_start).count();
+    }
+
+    Result result;
+    result.stress = stress;
+    result.parameters_posted = hammer ? hammer->stop() : 0;
+    result.plugin = entry.name;
+    result.sample_type = type_name<DataType>();
+    result.sampling_rate = sampling_rate;
+    result.block_size = block_size;
+    result.frames = nb_frames;
+    double elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+    result.ns_per_sample = elapsed / nb_frames;
+    result.cycles_per_sample = HAS_CYCLE_COUNTER ? static_cast<double>(end_cycles - start_cycles) / nb_frames : 0;
+    result.block_p50_ns = percentile(block_times, .5);
+    result.block_p99_ns = percentile(block_times, .99);
+    result.block_max_ns = *std::max_element(block_times.begin(), block_times.end());
+    result.cpu_load = elapsed * 1e-9 * sampling_rate / nb_frames;
+    return result;
+  }
+
+  // Evaluation of ATK::GainCompressorFilter, in the sample type
+  template<typename DataType>
+  DataType analytic_gain(DataType value, DataType ratio, DataType softness)
+  {
+    if (value == 0)
+    {
+      return 1;
+    }
+    DataType diff = 10 * std::log10(value);
+    return static_cast<DataType>(std::pow(10, -(std::sqrt(diff * diff + softness) + diff) / 40 * (ratio - 1) / ratio));
+  }
+
+  // Per sample cost of the analytic and tabulated gain curves, and largest error of the table in dB
+  // over a sweep from -96 dB to +96 dB around the threshold for a grid of ratios and softness
+  template<typename DataType>
+  void run_gain_curve()
+  {
+    const double ratios[] = {1.5, 2, 4, 10, 100};
+    const double softnesses[] = {1e-4, 1e-2, 1};
+    const int nb_values = 1 << 16;
+
+    // power / threshold values as seen by the filter, noise of all levels
+    std::vector<DataType> values(nb_values);
+    uint32_t seed = 12345;
+    for (int i = 0; i < nb_values; ++i)
+    {
+      seed = seed * 1664525 + 1013904223;
+      values[i] = static_cast<DataType>(std::pow(10, (seed / 4294967296. * 192 - 96) / 10));
+    }
+
+    GainCurveTable<DataType> table;
+    double analytic_time = 0;
+    double table_time = 0;
+    double max_error = 0;
+    DataType sum = 0;
+    for (double ratio : ratios)
+    {
+      for (double softness : softnesses)
+      {
+        table.request(ratio, softness);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < nb_values; ++i)
+        {
+          sum += analytic_gain<DataType>(values[i], static_cast<DataType>(ratio), static_cast<DataType>(softness));
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (int i = 0; i < nb_values; ++i)
+        {
+          sum += table.get_gain(values[i]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        analytic_time += std::chrono::duration<double, std::nano>(middle - start).count();
+        table_time += std::chrono::duration<double, std::nano>(end - middle).count();
+
+        for (double db = -96; db <= 96; db += 1e-3)
+        {
+          double value = std::pow(10, db / 10);
+          double expected = GainCurveTable<DataType>::gain(value, ratio, softness);
+          double actual = table.get_gain(static_cast<DataType>(value));
+          max_error = std::max(max_error, std::abs(20 * std::log10(actual / expected)));
+        }
+      }
+    }
+
+    const double nb_evaluations = static_cast<double>(nb_values) * (sizeof(ratios) / sizeof(ratios[0])) * (sizeof(softnesses) / sizeof(softnesses[0]));
+    std::cout << std::left << std::setw(7) << type_name<DataType>() << std::right << std::fixed << std::setprecision(2)
+      << std::setw(16) << analytic_time / nb_evaluations << std::setw(16) << table_time / nb_evaluations
+      << std::setw(10) << analytic_time / table_time << "x" << std::setprecision(5) << std::setw(16) << max_error << std::endl;
+    // keeps the evaluations from being optimized out
+    volatile DataType sink = sum;
+    (void)sink;
+  }
+
+  // Per evaluation cost of the Newton solver and of the table of the SD1 clipper, and largest
+  // error of the table in mV, over all the drives and the oversampled rates of ATKSD1
+  template<typename DataType>
+  void run_sd1_table()
+  {
+    const double drives[] = {0, .25, .5, .75, 1};
+    const double sampling_rates[] = {44100, 48000 * 8, 96000 * 8, 48000 * 32, 192000 * 32};
+    const int nb_values = 1 << 16;
+
+    // current / conductance from 1 mV to 1000 V, both signs
+    std::vector<double> values(nb_values);
+    uint32_t seed = 12345;
+    for (int i = 0; i < nb_values; ++i)
+    {
+      seed = seed * 1664525 + 1013904223;
+      values[i] = std::pow(10, seed / 4294967296. * 6 - 3) * (seed & 1 ? -1 : 1);
+    }
+
+    SD1ClipperTable<DataType> table;
+    std::vector<DataType> currents(nb_values);
+    double newton_time = 0;
+    double table_time = 0;
+    double max_error = 0;
+    double sum = 0;
+    for (double drive : drives)
+    {
+      for (double sampling_rate : sampling_rates)
+      {
+        double conductance = SD1ClipperTable<DataType>::get_conductance(drive, sampling_rate);
+        table.set_conductance(conductance);
+        for (int i = 0; i < nb_values; ++i)
+        {
+          currents[i] = static_cast<DataType>(values[i] * conductance);
+        }
+
+        // the filter starts from the previous solution, here from an unrelated value
+        std::vector<double> expected(nb_values);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < nb_values; ++i)
+        {
+          expected[i] = SD1ClipperTable<DataType>::solve(currents[i], conductance, i ? expected[i - 1] : 0);
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (int i = 0; i < nb_values; ++i)
+        {
+          sum += table.get_voltage(currents[i]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        newton_time += std::chrono::duration<double, std::nano>(middle - start).count();
+        table_time += std::chrono::duration<double, std::nano>(end - middle).count();
+
+        for (int i = 0; i < nb_values; ++i)
+        {
+          max_error = std::max(max_error, std::abs(table.get_voltage(currents[i]) - expected[i]) * 1000);
+        }
+      }
+    }
+
+    const double nb_evaluations = static_cast<double>(nb_values) * (sizeof(drives) / sizeof(drives[0])) * (sizeof(sampling_rates) / sizeof(sampling_rates[0]));
+    std::cout << std::left << std::setw(7) << type_name<DataType>() << std::right << std::fixed << std::setprecision(2)
+      << std::setw(16) << newton_time / nb_evaluations << std::setw(16) << table_time / nb_evaluations
+      << std::setw(10) << newton_time / table_time << "x" << std::setprecision(5) << std::setw(16) << max_error << std::endl;
+    volatile double sink = sum;
+    (void)sink;
+  }
+
+  void write_csv(std::ostream& stream, const std::vector<Result>& results)
+  {
+    stream << "plugin,sample_type,sampling_rate,block_size,frames,ns_per_sample,cycles_per_sample,block_p50_ns,block_p99_ns,block_max_ns,cpu_load,stress,parameters_posted" << std::endl;
+    for (const Result& result : results)
+    {
+      stream << result.plugin << ',' << result.sample_type << ',' << result.sampling_rate << ',' << result.block_size << ',' << result.frames << ','
+        << result.ns_per_sample << ',';
+      if (HAS_CYCLE_COUNTER)
+      {
+        stream << result.cycles_per_sample;
+      }
+      stream << ',' << result.block_p50_ns << ',' << result.block_p99_ns << ',' << result.block_max_ns << ',' << result.cpu_load << ','
+        << result.stress << ',' << result.parameters_posted << std::endl;
+    }
+  }
+
+  void write_json(std::ostream& stream, const std::vector<Result>& results)
+  {
+    stream << "[" << std::endl;
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+      const Result& result = results[i];
+      stream << "  {\"plugin\": \"" << result.plugin << "\", \"sample_type\": \"" << result.sample_type
+        << "\", \"sampling_rate\": " << result.sampling_rate
+        << ", \"block_size\": " << result.block_size << ", \"frames\": " << result.frames
+        << ", \"ns_per_sample\": " << result.ns_per_sample << ", \"cycles_per_sample\": ";
+      if (HAS_CYCLE_COUNTER)
+      {
+        stream << result.cycles_per_sample;
+      }
+      else
+      {
+        stream << "null";
+      }
+      stream << ", \"block_p50_ns\": " << result.block_p50_ns << ", \"block_p99_ns\": " << result.block_p99_ns
+        << ", \"block_max_ns\": " << result.block_max_ns << ", \"cpu_load\": " << result.cpu_load
+        << ", \"stress\": " << (result.stress ? "true" : "false") << ", \"parameters_posted\": " << result.parameters_posted << "}"
+        << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    stream << "]" << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<const PluginEntry*> plugins;
+  std::vector<int> block_sizes = {1, 16, 32, 64, 256, 1024, 4096};
+  std::vector<int> rates = {44100, 48000, 96000, 192000};
+  std::vector<std::string> types = {"double"};
+  double duration = 1;
+  bool stress = false;
+  std::string output_filename = "benchmark.csv";
+
+  try
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (arg == "--list-plugins")
+      {
+        for (const PluginEntry& entry : get_plugins())
+        {
+          std::cout << entry.name << std::endl;
+        }
+        return 0;
+      }
+      else if (arg == "--help" || arg == "-h")
+      {
+        usage();
+        return 0;
+      }
+      else if (arg == "--stress")
+      {
+        stress = true;
+      }
+      else if (arg == "--gain-curve")
+      {
+        std::cout << std::left << std::setw(7) << "type" << std::right << std::setw(16) << "analytic (ns)" << std::setw(16) << "table (ns)"
+          << std::setw(11) << "speedup" << std::setw(16) << "max error (dB)" << std::endl;
+        run_gain_curve<float>();
+        run_gain_curve<double>();
+        return 0;
+      }
+      else if (arg == "--sd1-table")
+      {
+        std::cout << std::left << std::setw(7) << "type" << std::right << std::setw(16) << "Newton (ns)" << std::setw(16) << "table (ns)"
+          << std::setw(11) << "speedup" << std::setw(16) << "max error (mV)" << std::endl;
+        run_sd1_table<float>();
+        run_sd1_table<double>();
+        return 0;
+      }
+      else if (arg.compare(0, 2, "--") == 0 && i + 1 < argc)
+      {
+        std::string value = argv[++i];
+        if (arg == "--plugin")
+        {
+          const PluginEntry* entry = find_plugin(value);
+          if (!entry)
+          {
+            throw std::runtime_error("Unknown plugin " + value);
+          }
+          plugins.push_back(entry);
+        }
+        else if (arg == "--block-sizes")
+          block_sizes = parse_list(value);
+        else if (arg == "--rates")
+          rates = parse_list(value);
+        else if (arg == "--types")
+          types = split(value);
+        else if (arg == "--duration")
+          duration = std::atof(value.c_str());
+        else if (arg == "--output")
+          output_filename = value;
+        else
+          throw std::runtime_error("Unknown option " + arg);
+      }
+      else
+      {
+        usage();
+        return 1;
+      }
+    }
+    if (plugins.empty())
+    {
+      for (const PluginEntry& entry : get_plugins())
+      {
+        plugins.push_back(&entry);
+      }
+    }
+    if (duration <= 0)
+    {
+      throw std::runtime_error("The duration must be positive");
+    }
+    for (const std::string& type : types)
+    {
+      if (type != "float" && type != "double")
+      {
+        throw std::runtime_error("Unknown sample type " + type);
+      }
+    }
+
+    std::ofstream output(output_filename.c_str());
+    if (!output)
+    {
+      throw std::runtime_error("Cannot open " + output_filename);
+    }
+
+    std::cout << std::left << std::setw(28) << "plugin" << std::setw(7) << "type" << std::right << std::setw(8) << "rate" << std::setw(7) << "block"
+      << std::setw(12) << "ns/sample" << std::setw(14) << "cycles/sample" << std::setw(12) << "p50 (us)"
+      << std::setw(12) << "p99 (us)" << std::setw(12) << "max (us)" << std::setw(9) << "load" << std::endl;
+    std::cout << std::fixed;
+
+    std::vector<Result> results;
+    for (const PluginEntry* entry : plugins)
+    {
+      for (const std::string& type : types)
+      {
+        for (int rate : rates)
+        {
+          for (int block_size : block_sizes)
+          {
+            Result result = type == "float" ? run<float>(*entry, rate, block_size, duration, stress) : run<double>(*entry, rate, block_size, duration, stress);
+            std::cout << std::left << std::setw(28) << result.plugin << std::setw(7) << result.sample_type << std::right << std::setw(8) << result.sampling_rate
+              << std::setw(7) << result.block_size << std::setprecision(1) << std::setw(12) << result.ns_per_sample
+              << std::setw(14) << result.cycles_per_sample << std::setprecision(2) << std::setw(12) << result.block_p50_ns * 1e-3
+              << std::setw(12) << result.block_p99_ns * 1e-3 << std::setw(12) << result.block_max_ns * 1e-3
+              << std::setprecision(1) << std::setw(8) << result.cpu_load * 100 << "%" << std::endl;
+            results.push_back(result);
+          }
+        }
+      }
+    }
+
+    if (output_filename.size() > 5 && output_filename.compare(output_filename.size() - 5, 5, ".json") == 0)
+    {
+      write_json(output, results);
+    }
+    else
+    {
+      write_csv(output, results);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
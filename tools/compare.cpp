@@ -0,0 +1,385 @@
+// Runs two plugins with the same parameters on the same signals and reports the largest difference
+// between their outputs, to check an optimized kernel against the reference filter graph
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../ATKSD1/ATKSD1DSP.h"
+#include "Plugins.h"
+
+namespace
+{
+  void usage()
+  {
+    std::cerr << "Usage: compare [options] reference plugin" << std::endl
+      << "Options:" << std::endl
+      << "  --block-size n       frames per process call (default 256)" << std::endl
+      << "  --rate n             sampling rate (default 48000)" << std::endl
+      << "  --type name          sample type, float or double (default double)" << std::endl
+      << "  --duration s         seconds of audio for each parameter set (default 2)" << std::endl
+      << "  --tolerance value    largest accepted difference (default 1e-9 in double, 1e-5 in float)" << std::endl
+      << "  --sd1-latency        check the latency reported by ATKSD1 against its impulse response" << std::endl;
+  }
+
+  struct Random
+  {
+    uint32_t seed;
+
+    double next()
+    {
+      seed = seed * 1664525 + 1013904223;
+      return seed / 4294967296.;
+    }
+  };
+
+  // Noise bursts of varying level separated by silences, so that the dynamic plugins go through
+  // their whole gain curve and their attack and release phases
+  // Each input gets its own noise and its own burst timing, so that the left, right and side
+  // chain inputs are uncorrelated and a swapped or mixed up input changes the output
+  template<typename DataType>
+  std::vector<DataType> make_signal(int64_t size, int sampling_rate, int input)
+  {
+    std::vector<DataType> signal(size);
+    Random random = {12345u + 7919u * input};
+    for (int64_t i = 0; i < size; ++i)
+    {
+      double noise = 2 * random.next() - 1;
+      double envelope = std::max(0., std::sin(2 * M_PI * (1.5 + .25 * input) * i / sampling_rate + 1.3 * input));
+      signal[i] = static_cast<DataType>(noise * envelope * envelope);
+    }
+    return signal;
+  }
+
+  // The parameters of toggled are posted halfway through, as a GUI would do while playing
+  template<typename DataType>
+  std::vector<DataType> render(PluginDSP<DataType>& dsp, const std::vector<std::vector<DataType> >& signals, int block_size, const std::vector<std::pair<int, double> >& toggled)
+  {
+    const int64_t length = static_cast<int64_t>(signals[0].size());
+    std::vector<std::vector<DataType> > output_buffers(dsp.nb_outputs(), std::vector<DataType>(length));
+    std::vector<DataType*> inputs(dsp.nb_inputs());
+    std::vector<DataType*> outputs(dsp.nb_outputs());
+    bool posted = false;
+
+    for (int64_t offset = 0; offset < length; offset += block_size)
+    {
+      int size = static_cast<int>(std::min<int64_t>(block_size, length - offset));
+      if (!posted && offset >= length / 2)
+      {
+        for (const std::pair<int, double>& parameter : toggled)
+        {
+          dsp.post_parameter(parameter.first, parameter.second);
+        }
+        posted = true;
+      }
+      for (std::size_t i = 0; i < inputs.size(); ++i)
+      {
+        inputs[i] = const_cast<DataType*>(&signals[i][offset]);
+      }
+      for (std::size_t i = 0; i < outputs.size(); ++i)
+      {
+        outputs[i] = &output_buffers[i][offset];
+      }
+      dsp.process(inputs.data(), outputs.data(), size);
+    }
+
+    // all the channels one after the other
+    std::vector<DataType> result;
+    for (const std::vector<DataType>& buffer : output_buffers)
+    {
+      result.insert(result.end(), buffer.begin(), buffer.end());
+    }
+    return result;
+  }
+
+  // Largest difference over the default parameters followed by a few random parameter sets
+  // From the second set on, the boolean parameters (the routings of the stereo compressors) flip
+  // halfway through the render
+  template<typename DataType>
+  double compare(const PluginEntry& reference_entry, const PluginEntry& plugin_entry, int sampling_rate, int block_size, double duration)
+  {
+    std::unique_ptr<PluginDSP<DataType> > reference = create_plugin<DataType>(reference_entry);
+    std::unique_ptr<PluginDSP<DataType> > plugin = create_plugin<DataType>(plugin_entry);
+    if (reference->nb_parameters() != plugin->nb_parameters() || reference->nb_inputs() != plugin->nb_inputs() || reference->nb_outputs() != plugin->nb_outputs())
+    {
+      throw std::runtime_error("The two plugins don't have the same parameters and channels");
+    }
+
+    std::vector<std::vector<DataType> > signals;
+    for (int input = 0; input < reference->nb_inputs(); ++input)
+    {
+      signals.push_back(make_signal<DataType>(static_cast<int64_t>(duration * sampling_rate), sampling_rate, input));
+    }
+    Random random = {54321};
+    double max_difference = 0;
+
+    for (int set = 0; set < 8; ++set)
+    {
+      std::vector<double> values;
+      std::vector<std::pair<int, double> > toggled;
+      for (int i = 0; i < reference->nb_parameters(); ++i)
+      {
+        const ParameterInfo& info = reference->parameter(i);
+        double value = set == 0 ? info.default_value : info.min_value + random.next() * (info.max_value - info.min_value);
+        if (info.boolean)
+        {
+          value = value >= .5;
+          if (set > 0)
+          {
+            toggled.push_back(std::make_pair(i, 1 - value));
+          }
+        }
+        values.push_back(value);
+      }
+
+      for (PluginDSP<DataType>* dsp : {reference.get(), plugin.get()})
+      {
+        for (int i = 0; i < dsp->nb_parameters(); ++i)
+        {
+          dsp->set_parameter(i, values[i]);
+        }
+        // the next sets are changed while running, to compare the parameter ramps as well
+        if (set == 0)
+        {
+          dsp->set_sampling_rate(sampling_rate);
+        }
+      }
+
+      std::vector<DataType> expected = render(*reference, signals, block_size, toggled);
+      std::vector<DataType> actual = render(*plugin, signals, block_size, toggled);
+      double difference = 0;
+      for (std::size_t i = 0; i < expected.size(); ++i)
+      {
+        difference = std::max(difference, std::abs(static_cast<double>(expected[i]) - actual[i]));
+      }
+      std::cout << "parameter set " << set << ": max difference " << difference << std::endl;
+      max_difference = std::max(max_difference, difference);
+    }
+    return max_difference;
+  }
+
+  // Position of the largest sample of a buffer
+  int peak_position(const std::vector<double>& output)
+  {
+    return static_cast<int>(std::max_element(output.begin(), output.end(), [](double a, double b) { return std::abs(a) < std::abs(b); }) - output.begin());
+  }
+
+  // Delay of the low frequencies through the ATKSD1 oversampling and decimation filters at the
+  // highest factor, without the delay added to reach the reported latency: the centroid of their
+  // impulse response, which is their group delay at 0 Hz
+  double measure_sd1_filters_delay(PolyphaseOversampling::FilterLength length, PolyphaseOversampling::FilterPhase phase, int sampling_rate)
+  {
+    const int size = 1024;
+    const int nb_stages = PolyphaseOversampling::max_nb_stages;
+    std::vector<double> input(size);
+    std::vector<double> output(size);
+    input[0] = 1;
+
+    ATK::InPointerFilter<double> inFilter(input.data(), 1, size, false);
+    PolyphaseOversamplingFilter<double> oversamplingFilter;
+    PolyphaseDecimationFilter<double> decimationFilter;
+    ATK::OutPointerFilter<double> outFilter(output.data(), 1, size, false);
+    oversamplingFilter.set_input_port(0, &inFilter, 0);
+    decimationFilter.set_input_port(0, &oversamplingFilter, 0);
+    outFilter.set_input_port(0, &decimationFilter, 0);
+
+    oversamplingFilter.set_filter_length(length);
+    oversamplingFilter.set_filter_phase(phase);
+    decimationFilter.set_filter_length(length);
+    decimationFilter.set_filter_phase(phase);
+    inFilter.set_output_sampling_rate(sampling_rate);
+    oversamplingFilter.set_input_sampling_rate(sampling_rate);
+    oversamplingFilter.set_output_sampling_rate(sampling_rate << nb_stages);
+    decimationFilter.set_input_sampling_rate(sampling_rate << nb_stages);
+    decimationFilter.set_output_sampling_rate(sampling_rate);
+    outFilter.set_input_sampling_rate(sampling_rate);
+    oversamplingFilter.full_setup();
+    decimationFilter.full_setup();
+
+    outFilter.process(size);
+    double sum = 0;
+    double moment = 0;
+    for (int i = 0; i < size; ++i)
+    {
+      sum += output[i];
+      moment += i * output[i];
+    }
+    return moment / sum;
+  }
+
+  // Peak of a small impulse through ATKSD1DSP, with the Drive and the Tone at 0 so that the
+  // overdrive stage and the tone stack stay close to linear
+  int measure_sd1_latency(PolyphaseOversampling::FilterLength length, PolyphaseOversampling::FilterPhase phase, int quality, int sampling_rate)
+  {
+    const int size = 1024;
+    std::vector<double> input(size);
+    std::vector<double> output(size);
+    input[0] = 1e-3;
+
+    ATKSD1DSP<double> dsp;
+    dsp.set_oversampling_filter_length(length);
+    dsp.set_parameter(ATKSD1Parameters::kDrive, 0);
+    dsp.set_parameter(ATKSD1Parameters::kTone, 0);
+    dsp.set_parameter(ATKSD1Parameters::kLevel, 100);
+    dsp.set_parameter(ATKSD1Parameters::kQuality, quality);
+    dsp.set_parameter(ATKSD1Parameters::kResampling, phase);
+    dsp.set_sampling_rate(sampling_rate);
+
+    double* inputs[] = {input.data()};
+    double* outputs[] = {output.data()};
+    dsp.process(inputs, outputs, size);
+    return peak_position(output);
+  }
+
+  // Checks the latency that ATKSD1 reports, for all the filter lengths, Resampling and Quality
+  // values and usual sampling rates:
+  // - the delay of the resampling filters of the highest factor, which the other ones are delayed
+  //   to match, must round up to the reported latency
+  // - through the whole ATKSD1DSP, the tone stack and the high pass delay the peak of the impulse
+  //   further, by an amount that only depends on the sampling rate: the peak must come that much
+  //   after the reported latency with all the filters and factors, give or take a sample with the
+  //   minimum phase filters, whose peak is not exactly at their group delay
+  // Returns the number of failures
+  int check_sd1_latency()
+  {
+    static const char* const length_names[] = {"short", "medium", "long"};
+    static const char* const phase_names[] = {"linear phase", "min latency"};
+    const int sampling_rates[] = {44100, 48000, 88200, 96000, 176400, 192000};
+    const int nb_sampling_rates = sizeof(sampling_rates) / sizeof(sampling_rates[0]);
+    // delay of the tone stack and the high pass at each sampling rate, from the first filters
+    std::vector<int> tone_delays(nb_sampling_rates, -1);
+    int nb_failures = 0;
+
+    for (int length = PolyphaseOversampling::kShort; length <= PolyphaseOversampling::kLong; ++length)
+    {
+      for (int phase = PolyphaseOversampling::kLinearPhase; phase <= PolyphaseOversampling::kMinimumPhase; ++phase)
+      {
+        PolyphaseOversampling::FilterLength filter_length = static_cast<PolyphaseOversampling::FilterLength>(length);
+        PolyphaseOversampling::FilterPhase filter_phase = static_cast<PolyphaseOversampling::FilterPhase>(phase);
+        ATKSD1DSP<double> dsp;
+        dsp.set_oversampling_filter_length(filter_length);
+        int latency = dsp.get_latency(filter_phase);
+        int tolerance = filter_phase == PolyphaseOversampling::kMinimumPhase ? 1 : 0;
+        std::cout << length_names[length] << " " << phase_names[phase] << " filters: latency " << latency << ",";
+
+        int nb_mismatches = 0;
+        for (int rate = 0; rate < nb_sampling_rates; ++rate)
+        {
+          double delay = measure_sd1_filters_delay(filter_length, filter_phase, sampling_rates[rate]);
+          if (delay > latency + 1e-6 || delay <= latency - 1)
+          {
+            std::cout << " filters delay " << delay << " at " << sampling_rates[rate] << " Hz,";
+            ++nb_mismatches;
+          }
+
+          for (int quality = 0; quality <= PolyphaseOversampling::max_nb_stages; ++quality)
+          {
+            int peak = measure_sd1_latency(filter_length, filter_phase, quality, sampling_rates[rate]);
+            if (tone_delays[rate] < 0)
+            {
+              tone_delays[rate] = peak - latency;
+            }
+            if (std::abs(peak - latency - tone_delays[rate]) > tolerance)
+            {
+              std::cout << " plugin peak " << peak << " at " << sampling_rates[rate] << " Hz " << (1 << quality) << "x,";
+              ++nb_mismatches;
+            }
+          }
+        }
+        std::cout << (nb_mismatches ? " FAILED" : " measured at all the sampling rates and factors") << std::endl;
+        nb_failures += nb_mismatches;
+      }
+    }
+    std::cout << "tone stack and high pass:";
+    for (int rate = 0; rate < nb_sampling_rates; ++rate)
+    {
+      std::cout << " " << tone_delays[rate] << " samples at " << sampling_rates[rate] << " Hz" << (rate + 1 < nb_sampling_rates ? "," : "");
+    }
+    std::cout << std::endl;
+    return nb_failures;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<const PluginEntry*> plugins;
+  int block_size = 256;
+  int sampling_rate = 48000;
+  std::string type = "double";
+  double duration = 2;
+  double tolerance = -1;
+
+  try
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (arg == "--help" || arg == "-h")
+      {
+        usage();
+        return 0;
+      }
+      else if (arg == "--sd1-latency")
+      {
+        return check_sd1_latency() == 0 ? 0 : 2;
+      }
+      else if (arg.compare(0, 2, "--") == 0 && i + 1 < argc)
+      {
+        std::string value = argv[++i];
+        if (arg == "--block-size")
+          block_size = std::atoi(value.c_str());
+        else if (arg == "--rate")
+          sampling_rate = std::atoi(value.c_str());
+        else if (arg == "--type")
+          type = value;
+        else if (arg == "--duration")
+          duration = std::atof(value.c_str());
+        else if (arg == "--tolerance")
+          tolerance = std::atof(value.c_str());
+        else
+          throw std::runtime_error("Unknown option " + arg);
+      }
+      else
+      {
+        const PluginEntry* entry = find_plugin(arg);
+        if (!entry)
+        {
+          throw std::runtime_error("Unknown plugin " + arg);
+        }
+        plugins.push_back(entry);
+      }
+    }
+    if (plugins.size() != 2)
+    {
+      usage();
+      return 1;
+    }
+    if (block_size <= 0 || sampling_rate <= 0 || duration <= 0)
+    {
+      throw std::runtime_error("The block size, the sampling rate and the duration must be positive");
+    }
+    if (type != "float" && type != "double")
+    {
+      throw std::runtime_error("Unknown sample type " + type);
+    }
+    if (tolerance < 0)
+    {
+      tolerance = type == "float" ? 1e-5 : 1e-9;
+    }
+
+    double difference = type == "float" ? compare<float>(*plugins[0], *plugins[1], sampling_rate, block_size, duration) : compare<double>(*plugins[0], *plugins[1], sampling_rate, block_size, duration);
+    std::cout << plugins[1]->name << " vs " << plugins[0]->name << ": max difference " << difference << " (tolerance " << tolerance << ")" << std::endl;
+    return difference <= tolerance ? 0 : 2;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,101 @@
+// Runs the graphs of the stereo dynamics plugins once in each routing (middle/side, link and
+// enabled channels), with and without side chain, and lists the filters that processed and the
+// ones that the routing left out
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../ATKSideChainCompressor/ATKSideChainCompressorDSP.h"
+#include "../ATKSideChainExpander/ATKSideChainExpanderDSP.h"
+#include "../ATKStereoCompressor/ATKStereoCompressorDSP.h"
+
+namespace
+{
+  const int sampling_rate = 48000;
+  const int block_size = 256;
+
+  // the compressors process with their fused kernel by default
+  template<class DSP>
+  void use_graph(DSP& dsp)
+  {
+    dsp.set_fused_kernel(false);
+  }
+
+  // the expander only has its graph
+  void use_graph(ATKSideChainExpanderDSP<double>&)
+  {
+  }
+
+  template<class DSP>
+  void connect_sidechain(DSP& dsp, bool connected)
+  {
+    dsp.set_sidechain_connected(connected);
+  }
+
+  // the stereo compressor has no side chain
+  void connect_sidechain(ATKStereoCompressorDSP<double>&, bool)
+  {
+  }
+
+  template<class DSP>
+  void list_nodes(const char* name, bool sidechain_connected)
+  {
+    std::vector<std::vector<double> > buffers(DSP::nb_inputs + DSP::nb_outputs, std::vector<double>(block_size));
+    std::vector<double*> pointers;
+    for (std::vector<double>& buffer : buffers)
+    {
+      pointers.push_back(buffer.data());
+    }
+    for (int channel = 0; channel < DSP::nb_inputs; ++channel)
+    {
+      // different channels, loud enough for the silence detection to let them through
+      for (int i = 0; i < block_size; ++i)
+      {
+        buffers[channel][i] = .5 * ((i * (channel + 3)) % 17 - 8) / 8.;
+      }
+    }
+
+    for (int routing = 0; routing < 16; ++routing)
+    {
+      bool middleside = (routing & 1) != 0;
+      bool linked = (routing & 2) != 0;
+      bool enabled1 = (routing & 4) != 0;
+      bool enabled2 = (routing & 8) != 0;
+
+      DSP dsp;
+      use_graph(dsp);
+      connect_sidechain(dsp, sidechain_connected);
+      dsp.set_parameter(DSP::kMiddleside, middleside);
+      dsp.set_parameter(DSP::kLinkChannels, linked);
+      dsp.set_parameter(DSP::kActivateChannel1, enabled1);
+      dsp.set_parameter(DSP::kActivateChannel2, enabled2);
+      dsp.set_sampling_rate(sampling_rate);
+      dsp.reset_node_runs();
+      dsp.process(pointers.data(), pointers.data() + DSP::nb_inputs, block_size);
+
+      std::string ran;
+      std::string skipped;
+      for (const std::pair<std::string, int64_t>& node : dsp.get_node_runs())
+      {
+        (node.second > 0 ? ran : skipped) += " " + node.first;
+      }
+      std::cout << name << (middleside ? " M/S" : " L/R") << (linked ? " linked" : " unlinked")
+        << (enabled1 ? " ch1 on" : " ch1 off") << (enabled2 ? " ch2 on" : " ch2 off") << std::endl;
+      std::cout << "  ran:" << ran << std::endl;
+      std::cout << "  skipped:" << skipped << std::endl;
+    }
+  }
+}
+
+int main()
+{
+  list_nodes<ATKSideChainCompressorDSP<double> >("ATKSideChainCompressorGraph", true);
+  list_nodes<ATKSideChainCompressorDSP<double> >("ATKSideChainCompressorGraphInternalKey", false);
+  list_nodes<ATKSideChainExpanderDSP<double> >("ATKSideChainExpander", true);
+  list_nodes<ATKSideChainExpanderDSP<double> >("ATKSideChainExpanderInternalKey", false);
+  list_nodes<ATKStereoCompressorDSP<double> >("ATKStereoCompressorGraph", true);
+  return 0;
+}
@@ -0,0 +1,356 @@
+// Offline renderer: runs the DSP graph of one plugin over a WAV or raw file
+// Built once per plugin, PLUGIN_HEADER and PLUGIN_DSP are set by the Makefile
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "AudioFile.h"
+
+#include PLUGIN_HEADER
+
+#define STRINGIFY2(x) #x
+#define STRINGIFY(x) STRINGIFY2(x)
+
+// parameters and channel layout do not depend on the sample type
+typedef PLUGIN_DSP<double> DSP;
+
+namespace
+{
+  void usage()
+  {
+    std::cerr << "Usage: render-" STRINGIFY(PLUGIN_DSP) " [options] input output" << std::endl
+      << "Options:" << std::endl
+      << "  --param Name=value   set a parameter (name or index)" << std::endl
+      << "  --preset file        read Name=value lines from a file" << std::endl
+      << "  --block-size N       number of frames per process call (default 4096)" << std::endl
+      << "  --sidechain file     side chain input (default: the main input)" << std::endl
+      << "  --rate N             sampling rate of raw inputs (default 44100)" << std::endl
+      << "  --channels N         number of channels of raw inputs (default 1)" << std::endl
+      << "  --float              process in single precision (default double)" << std::endl
+      << "  --list-params        print the parameters and their ranges" << std::endl
+      << "Raw files are interleaved 32 bits float, WAV outputs use the input sample format." << std::endl;
+  }
+
+  std::string trim(const std::string& str)
+  {
+    std::string::size_type begin = str.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+    {
+      return std::string();
+    }
+    std::string::size_type end = str.find_last_not_of(" \t\r");
+    return str.substr(begin, end - begin + 1);
+  }
+
+  int find_parameter(const std::string& name)
+  {
+    for (int i = 0; i < DSP::kNumParams; ++i)
+    {
+      if (name == DSP::parameters[i].name)
+      {
+        return i;
+      }
+    }
+    char* end;
+    long index = std::strtol(name.c_str(), &end, 10);
+    if (*end == '\0' && !name.empty() && index >= 0 && index < DSP::kNumParams)
+    {
+      return static_cast<int>(index);
+    }
+    throw std::runtime_error("Unknown parameter " + name);
+  }
+
+  // index of a value of an enumerated parameter, -1 if there is no such value
+  int find_value_name(const ParameterInfo& info, const std::string& name)
+  {
+    for (int value = 0; value <= info.max_value; ++value)
+    {
+      if (name == info.value_names[value])
+      {
+        return value;
+      }
+    }
+    return -1;
+  }
+
+  void parse_parameter(const std::string& assignment, double* values)
+  {
+    std::string::size_type equal = assignment.find('=');
+    if (equal == std::string::npos)
+    {
+      throw std::runtime_error("Expected Name=value, got " + assignment);
+    }
+    int index = find_parameter(trim(assignment.substr(0, equal)));
+    const ParameterInfo& info = DSP::parameters[index];
+    std::string value = trim(assignment.substr(equal + 1));
+
+    if (info.boolean && (value == "true" || value == "on"))
+    {
+      values[index] = 1;
+    }
+    else if (info.boolean && (value == "false" || value == "off"))
+    {
+      values[index] = 0;
+    }
+    else if (info.value_names && find_value_name(info, value) >= 0)
+    {
+      values[index] = find_value_name(info, value);
+    }
+    else
+    {
+      char* end;
+      values[index] = std::strtod(value.c_str(), &end);
+      if (*end != '\0' || value.empty())
+      {
+        throw std::runtime_error("Invalid value for " + std::string(info.name) + ": " + value);
+      }
+    }
+    if (values[index] < info.min_value || values[index] > info.max_value)
+    {
+      std::cerr << "Warning: " << info.name << " = " << values[index] << " is outside of [" << info.min_value << ", " << info.max_value << "]" << std::endl;
+    }
+  }
+
+  void read_preset(const std::string& filename, double* values)
+  {
+    std::ifstream stream(filename.c_str());
+    if (!stream)
+    {
+      throw std::runtime_error("Cannot open " + filename);
+    }
+    std::string line;
+    while (std::getline(stream, line))
+    {
+      line = trim(line.substr(0, line.find('#')));
+      if (!line.empty())
+      {
+        parse_parameter(line, values);
+      }
+    }
+  }
+
+  void list_parameters()
+  {
+    for (int i = 0; i < DSP::kNumParams; ++i)
+    {
+      const ParameterInfo& info = DSP::parameters[i];
+      std::cout << i << ": " << info.name;
+      if (info.boolean)
+      {
+        std::cout << " (on/off, default " << (info.default_value != 0 ? "on" : "off") << ")" << std::endl;
+      }
+      else if (info.value_names)
+      {
+        std::cout << " (";
+        for (int value = 0; value <= info.max_value; ++value)
+        {
+          std::cout << (value ? "/" : "") << info.value_names[value];
+        }
+        std::cout << ", default " << info.value_names[static_cast<int>(info.default_value)] << ")" << std::endl;
+      }
+      else
+      {
+        std::cout << " [" << info.min_value << ", " << info.max_value << "] " << info.label << " (default " << info.default_value << ")" << std::endl;
+      }
+    }
+  }
+
+  // copies the first nb_frames of each channel, padding with zeros
+  template<typename DataType>
+  std::vector<std::vector<DataType> > convert(const std::vector<std::vector<double> >& channels, int64_t nb_frames)
+  {
+    std::vector<std::vector<DataType> > converted(channels.size(), std::vector<DataType>(nb_frames));
+    for (std::size_t channel = 0; channel < channels.size(); ++channel)
+    {
+      for (int64_t i = 0; i < nb_frames && i < static_cast<int64_t>(channels[channel].size()); ++i)
+      {
+        converted[channel][i] = static_cast<DataType>(channels[channel][i]);
+      }
+    }
+    return converted;
+  }
+
+  // Runs the plugin over input and fills output, returns the processing time in seconds
+  template<typename DataType>
+  double render(const AudioFile& input, const AudioFile& sidechain, const double* values, int block_size, AudioFile& output)
+  {
+    typedef PLUGIN_DSP<DataType> TypedDSP;
+
+    // mono plugins are duplicated for each channel of the file, the others take the file
+    // channels in order, reusing them when the file has fewer channels than the plugin
+    const int nb_main_inputs = DSP::nb_inputs - DSP::nb_sidechain_inputs;
+    const int nb_instances = (DSP::nb_inputs == 1 && DSP::nb_outputs == 1) ? input.nb_channels() : 1;
+    const int64_t nb_frames = input.nb_frames();
+
+    std::vector<std::unique_ptr<TypedDSP> > instances;
+    for (int instance = 0; instance < nb_instances; ++instance)
+    {
+      instances.push_back(std::unique_ptr<TypedDSP>(new TypedDSP));
+      for (int i = 0; i < DSP::kNumParams; ++i)
+      {
+        instances.back()->set_parameter(i, values[i]);
+      }
+      // also ends the parameter ramps, the file starts with the requested values
+      instances.back()->set_sampling_rate(input.sampling_rate);
+    }
+
+    std::vector<std::vector<DataType> > input_channels = convert<DataType>(input.channels, nb_frames);
+    std::vector<std::vector<DataType> > sidechain_channels = convert<DataType>(sidechain.channels, nb_frames);
+    std::vector<std::vector<DataType> > output_channels(nb_instances * DSP::nb_outputs, std::vector<DataType>(nb_frames));
+
+    DataType* inputs[DSP::nb_inputs];
+    DataType* outputs[DSP::nb_outputs];
+
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t offset = 0; offset < nb_frames; offset += block_size)
+    {
+      int size = static_cast<int>(std::min<int64_t>(block_size, nb_frames - offset));
+      for (int instance = 0; instance < nb_instances; ++instance)
+      {
+        for (int i = 0; i < nb_main_inputs; ++i)
+        {
+          inputs[i] = &input_channels[(instance + i) % input_channels.size()][offset];
+        }
+        for (int i = 0; i < DSP::nb_sidechain_inputs; ++i)
+        {
+          inputs[nb_main_inputs + i] = &sidechain_channels[i % sidechain_channels.size()][offset];
+        }
+        for (int i = 0; i < DSP::nb_outputs; ++i)
+        {
+          outputs[i] = &output_channels[instance * DSP::nb_outputs + i][offset];
+        }
+        instances[instance]->process(inputs, outputs, size);
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    output.sampling_rate = input.sampling_rate;
+    output.format = input.format;
+    output.channels.assign(output_channels.size(), std::vector<double>(nb_frames));
+    for (std::size_t channel = 0; channel < output_channels.size(); ++channel)
+    {
+      std::copy(output_channels[channel].begin(), output_channels[channel].end(), output.channels[channel].begin());
+    }
+
+    return std::chrono::duration<double>(end - start).count();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  double values[DSP::kNumParams];
+  for (int i = 0; i < DSP::kNumParams; ++i)
+  {
+    values[i] = DSP::parameters[i].default_value;
+  }
+
+  std::vector<std::string> files;
+  std::string sidechain_filename;
+  int block_size = 4096;
+  int raw_rate = 44100;
+  int raw_channels = 1;
+  bool use_float = false;
+
+  try
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (arg == "--list-params")
+      {
+        list_parameters();
+        return 0;
+      }
+      else if (arg == "--help" || arg == "-h")
+      {
+        usage();
+        return 0;
+      }
+      else if (arg == "--float")
+      {
+        use_float = true;
+      }
+      else if (arg.compare(0, 2, "--") == 0)
+      {
+        if (i + 1 >= argc)
+        {
+          throw std::runtime_error("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--param")
+          parse_parameter(value, values);
+        else if (arg == "--preset")
+          read_preset(value, values);
+        else if (arg == "--block-size")
+          block_size = std::atoi(value.c_str());
+        else if (arg == "--sidechain")
+          sidechain_filename = value;
+        else if (arg == "--rate")
+          raw_rate = std::atoi(value.c_str());
+        else if (arg == "--channels")
+          raw_channels = std::atoi(value.c_str());
+        else
+          throw std::runtime_error("Unknown option " + arg);
+      }
+      else
+      {
+        files.push_back(arg);
+      }
+    }
+    if (files.size() != 2 || block_size <= 0 || raw_rate <= 0 || raw_channels <= 0)
+    {
+      usage();
+      return 1;
+    }
+
+    AudioFile input;
+    input.sampling_rate = raw_rate;
+    input.channels.resize(raw_channels);
+    read_audio(files[0], input);
+
+    AudioFile sidechain;
+    if (!sidechain_filename.empty())
+    {
+      sidechain.sampling_rate = raw_rate;
+      sidechain.channels.resize(raw_channels);
+      read_audio(sidechain_filename, sidechain);
+      if (sidechain.sampling_rate != input.sampling_rate)
+      {
+        throw std::runtime_error("Side chain and input sampling rates differ");
+      }
+    }
+    else
+    {
+      sidechain.channels = input.channels;
+    }
+    if (input.nb_channels() == 0 || sidechain.nb_channels() == 0)
+    {
+      throw std::runtime_error("No channel to process");
+    }
+
+    AudioFile output;
+    double elapsed = use_float ? render<float>(input, sidechain, values, block_size, output) : render<double>(input, sidechain, values, block_size, output);
+
+    write_audio(files[1], output);
+
+    const int64_t nb_frames = input.nb_frames();
+    int64_t processed = nb_frames * output.nb_channels();
+    std::cerr << STRINGIFY(PLUGIN_DSP) << ": " << processed << " samples in " << elapsed << " s, "
+      << (elapsed > 0 ? processed / elapsed : 0) << " samples/s ("
+      << (elapsed > 0 ? nb_frames / (elapsed * input.sampling_rate) : 0) << "x real time)" << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}